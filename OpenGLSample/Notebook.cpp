@@ -1,63 +0,0 @@
-#define _USE_MATH_DEFINES // for C++
-#include <cmath>
-
-#include "notebook.h"
-
-using namespace std; // Standard namespace
-
-
-vector<GLfloat>* Notebook::drawNotebook()
-{
-    vector<GLfloat>* vec = new vector<GLfloat>{
-        // positions          // normals           // texture coords
-          -1.0f, -0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-           1.0f, -0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
-           1.0f,  0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-           1.0f,  0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-          -1.0f,  0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
-          -1.0f, -0.1f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-
-          -1.0f, -0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-           1.0f, -0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
-           1.0f,  0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-           1.0f,  0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-          -1.0f,  0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
-          -1.0f, -0.1f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-
-          -1.0f,  0.1f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-          -1.0f,  0.1f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-          -1.0f, -0.1f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-          -1.0f, -0.1f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-          -1.0f, -0.1f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-          -1.0f,  0.1f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-           1.0f,  0.1f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-           1.0f,  0.1f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-           1.0f, -0.1f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-           1.0f, -0.1f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-           1.0f, -0.1f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-           1.0f,  0.1f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-          -1.0f, -0.1f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-           1.0f, -0.1f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
-           1.0f, -0.1f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-           1.0f, -0.1f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-          -1.0f, -0.1f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
-          -1.0f, -0.1f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-
-          -1.0f,  0.1f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-           1.0f,  0.1f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
-           1.0f,  0.1f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-           1.0f,  0.1f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-          -1.0f,  0.1f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
-          -1.0f,  0.1f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-    };
-    return vec;
-}
-
-
-
-
-
-
-
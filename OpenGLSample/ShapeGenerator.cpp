@@ -2,6 +2,7 @@
 //#include <glm\glm.hpp>
 //#include <glm\gtc\matrix_transform.hpp>
 #include "Vertex.h"
+#include <algorithm>
 
 #define PI 3.14159265359
 using glm::vec3;
@@ -99,4 +100,65 @@ ShapeData ShapeGenerator::makeSphere(uint tesselation)
 		}
 	}
 	return ret;
-}
\ No newline at end of file
+}
+
+MeshOptimizationReport ShapeGenerator::optimize(ShapeData& shape)
+{
+	std::vector<unsigned int> indices(shape.indices, shape.indices + shape.numIndices);
+	std::vector<unsigned int> remap;
+	MeshOptimizationReport report = optimizeMesh(indices, &shape.vertices[0].position.x, sizeof(Vertex), shape.numVertices, remap);
+
+	std::vector<Vertex> vertices(shape.vertices, shape.vertices + shape.numVertices);
+	remapVertices(vertices, remap);
+	std::copy(vertices.begin(), vertices.end(), shape.vertices);
+	for (uint i = 0; i < shape.numIndices; i++)
+		shape.indices[i] = (GLushort)indices[i];
+	return report;
+}
+
+std::vector<GLushort> ShapeGenerator::makeGridIndices(uint cells, uint step, uint stitchMask)
+{
+	std::vector<GLushort> ret;
+	const uint blocks = cells / step / 2;
+	const uint rowSize = cells + 1;
+	ret.reserve(blocks * blocks * 8 * 3);
+
+	auto vertex = [rowSize](uint x, uint z) { return (GLushort)(z * rowSize + x); };
+	for (uint bz = 0; bz < blocks; bz++)
+	{
+		for (uint bx = 0; bx < blocks; bx++)
+		{
+			const uint x0 = bx * 2 * step, x1 = x0 + step, x2 = x0 + 2 * step;
+			const uint z0 = bz * 2 * step, z1 = z0 + step, z2 = z0 + 2 * step;
+			const GLushort center = vertex(x1, z1);
+
+			// block border counter-clockwise seen from +Y: corner, edge middle, corner per side
+			const GLushort sides[4][3] = {
+				{ vertex(x0, z0), vertex(x0, z1), vertex(x0, z2) }, // min X
+				{ vertex(x0, z2), vertex(x1, z2), vertex(x2, z2) }, // max Z
+				{ vertex(x2, z2), vertex(x2, z1), vertex(x2, z0) }, // max X
+				{ vertex(x2, z0), vertex(x1, z0), vertex(x0, z0) }  // min Z
+			};
+			const bool stitched[4] = {
+				(stitchMask & GRID_EDGE_MIN_X) && bx == 0,
+				(stitchMask & GRID_EDGE_MAX_Z) && bz == blocks - 1,
+				(stitchMask & GRID_EDGE_MAX_X) && bx == blocks - 1,
+				(stitchMask & GRID_EDGE_MIN_Z) && bz == 0
+			};
+
+			for (int side = 0; side < 4; side++)
+			{
+				if (stitched[side])
+				{
+					ret.insert(ret.end(), { center, sides[side][0], sides[side][2] });
+				}
+				else
+				{
+					ret.insert(ret.end(), { center, sides[side][0], sides[side][1] });
+					ret.insert(ret.end(), { center, sides[side][1], sides[side][2] });
+				}
+			}
+		}
+	}
+	return ret;
+}
@@ -1,7 +1,15 @@
 #pragma once
+#include <vector>
 #include "ShapeData.h"
+#include "meshOptimizer.h"
 typedef unsigned int uint;
 
+// Grid edges for makeGridIndices stitch masks
+const uint GRID_EDGE_MIN_X = 1; // column 0
+const uint GRID_EDGE_MAX_X = 1 << 1; // column cells
+const uint GRID_EDGE_MIN_Z = 1 << 2; // row 0
+const uint GRID_EDGE_MAX_Z = 1 << 3; // row cells
+
 class ShapeGenerator
 {
 	static ShapeData makePlaneVerts(uint dimensions);
@@ -12,5 +20,11 @@ public:
 
 	static ShapeData makePlane(uint dimensions = 10);
 	static ShapeData makeSphere(uint tesselation = 20);
+	static MeshOptimizationReport optimize(ShapeData& shape);
+
+	// Triangle list over a (cells + 1) x (cells + 1) vertex grid (row-major, row = Z) using every step-th vertex,
+	// as fans of 8 triangles around the center of 2x2 blocks. Edges in stitchMask skip their odd vertices, so they
+	// meet a neighbour grid using twice the step without cracks. cells / step must be even.
+	static std::vector<GLushort> makeGridIndices(uint cells, uint step, uint stitchMask = 0);
 	
 };
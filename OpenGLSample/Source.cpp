@@ -9,9 +9,19 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shader.h"
+#include "shaderVariants.h"
+#include "glState.h"
+#include "glHandle.h"
+#include "material.h"
 #include "camera.h"
 #include "cylinder.h"
 #include "Sphere.h"
+#include "mesh.h"
+#include "terrain.h"
+#include "cameraPath.h"
+#include "frameStats.h"
+#include "vertexLayoutBenchmark.h"
+#include "vboindexer.hpp"
 
 // floss
 #include "floss.h"
@@ -19,29 +29,38 @@
 // notebook 
 #include "notebook.h"
 
-// notebook spirals
-#include "notebookSpiral.h"
-
-// speaker 
-#include "speaker.h"
-
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
+GLTexture loadTexture(const char* path);
+void benchmarkSphereIndexing();
+std::unique_ptr<Mesh> createSphereMesh(float radius, int sectorCount, int stackCount, std::vector<Texture>&& textures);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+// near clip plane; the far one is the terrain view distance, depth precision goes with near / far,
+// so near stays as far out as close-ups of the props allow
+const float NEAR_PLANE = 0.5f;
 
 // camera
 Camera camera(glm::vec3(0.0f, 12.0f, 25.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// input of the current frame, the mouse callbacks add to it and processInput applies it
+CameraInput cameraInput;
+// camera path being recorded with --record, N starts a new segment
+CameraPath cameraPath;
+bool recording = false;
+bool segmentKeyDown = false;
 // camera
 glm::vec3 cameraPos = glm::vec3(-5.0f, 15.0f, 15.0f);
 glm::vec3 cameraFront = glm::vec3(5.0f, 15.0f, 3.0f);
@@ -57,8 +76,40 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+int main(int argc, char** argv)
 {
+	// camera paths, to benchmark builds against each other on exactly the same frames:
+	//   --record <file>        records the flight (N starts a new path segment)
+	//   --replay <file>        plays the recorded input back at a fixed 60 Hz time step
+	//   --replay-poses <file>  plays the recorded camera poses back at a fixed 60 Hz time step
+	//   --stats <file>         writes the frame times of a replay as CSV
+	// and the mesh benchmarks, which print their results and exit:
+	//   --benchmark-layouts    StaticMesh3D vertex layouts and indexVBO welding
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	const char* statsPath = nullptr;
+	CameraReplayMode replayMode = CameraReplayMode::Input;
+	bool benchmarkLayouts = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (hasValue && strcmp(argv[i], "--record") == 0)
+			recordPath = argv[++i];
+		else if (hasValue && strcmp(argv[i], "--replay") == 0)
+			replayPath = argv[++i];
+		else if (hasValue && strcmp(argv[i], "--replay-poses") == 0)
+		{
+			replayPath = argv[++i];
+			replayMode = CameraReplayMode::Poses;
+		}
+		else if (hasValue && strcmp(argv[i], "--stats") == 0)
+			statsPath = argv[++i];
+		else if (strcmp(argv[i], "--benchmark-layouts") == 0)
+			benchmarkLayouts = true;
+		else
+			std::cout << "Ignoring unknown argument " << argv[i] << std::endl;
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -95,58 +146,51 @@ int main()
 		return -1;
 	}
 
+	if (benchmarkLayouts)
+	{
+		static_meshes_3D::benchmarkVertexLayouts();
+		benchmarkSphereIndexing();
+		glfwTerminate();
+		return 0;
+	}
+
 	// configure global opengl state
 	// -----------------------------
-	glEnable(GL_DEPTH_TEST);
-
-	// build and compile our shader zprogram
-	// ------------------------------------
-	Shader lightingShader("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs");
-	Shader lightSphereShader("shaderfiles/6.light_cube.vs", "shaderfiles/6.light_cube.fs");
+	GLState::setEnabled(GL_DEPTH_TEST, true);
 
-	// Floss Vertices
-	float flossVerts[5000];
-	// Retrieve floss.h vector
-	vector<float>* flossVec = Floss::drawFloss();
-	// Add vectors into verts, then delete them
-	for (unsigned int i = 0; i < flossVec->size(); i++)
+	// camera path replay or recording
+	// -------------------------------
+	std::unique_ptr<CameraPathPlayer> pathPlayer;
+	FrameStats frameStats;
+	if (replayPath)
 	{
-		flossVerts[i] = flossVec->at(i);
-	}
-	delete(flossVec);
-
-	// Notebook Vertices
-	float notebookVerts[5000];
-	// Retrieve notebook.h vector
-	vector<float>* notebookVec = Notebook::drawNotebook();
-	// Add vectors into verts, then delete them
-	for (unsigned int i = 0; i < notebookVec->size(); i++)
-	{
-		notebookVerts[i] = notebookVec->at(i);
-	}
-	delete(notebookVec);
-
-	// Notebook Spiral Vertices
-	float notebookSpiralVerts[5000];
-	// Retrieve notebookspiral.h vector
-	vector<float>* spiralVec = NotebookSpiral::drawNotebookSpirals();
-	// Add vectors into verts, then delete them
-	for (unsigned int i = 0; i < spiralVec->size(); i++)
-	{
-		notebookSpiralVerts[i] = spiralVec->at(i);
+		if (!cameraPath.load(replayPath))
+		{
+			glfwTerminate();
+			return -1;
+		}
+		pathPlayer.reset(new CameraPathPlayer(cameraPath, replayMode));
+		pathPlayer->reset(camera);
+		// frame times are what a replay measures, vsync would cap them
+		glfwSwapInterval(0);
 	}
-	delete(spiralVec);
-
-	// Speaker Vertices
-	float speakerVerts[5000];
-	// Retrieve speaker.h vector
-	vector<float>* speakerVec = Speaker::drawSpeaker();
-	// Add vectors into verts, then delete them
-	for (unsigned int i = 0; i < speakerVec->size(); i++)
+	else if (recordPath)
 	{
-		speakerVerts[i] = speakerVec->at(i);
+		cameraPath.start(camera);
+		recording = true;
 	}
-	delete(speakerVec);
+
+	// build and compile our shader zprogram
+	// ------------------------------------
+	ShaderVariants lightingVariants("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs", {
+		{ "NR_POINT_LIGHTS", 4 },
+		{ "USE_DIR_LIGHT" },
+		{ "USE_SPOT_LIGHT" },
+		{ "USE_SPECULAR_MAP" },
+		{ "USE_INSTANCING" },
+		{ "USE_QTANGENT" }
+	});
+	Shader lightSphereShader("shaderfiles/6.light_cube.vs", "shaderfiles/6.light_cube.fs");
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
 	// ------------------------------------------------------------------
@@ -195,14 +239,6 @@ int main()
 		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
 	};
 
-	float planeVertices[] = {
-		// Positions            // Texture Coords
-		-10.0f, 3.5f, -10.0f,   0.0f, 0.0f,
-		 10.0f, 3.5f, -10.0f,   10.0f, 0.0f,
-		 10.0f, 3.5f,  10.0f,   10.0f, 10.0f,
-		-10.0f, 3.5f,  10.0f,   0.0f, 10.0f,
-	};
-
 	float cupVertices[] = {
 	-0.5f, 0.5f, -0.5f,  0.0f, 1.0f,
 	 0.5f, 0.5f, -0.5f,  1.0f, 1.0f,
@@ -260,177 +296,102 @@ int main()
 	};
 
 
-	////// Configure Floss VAO and VBO //////
-	unsigned int flossVBO, flossVAO;
-	glGenVertexArrays(1, &flossVAO);
-	glGenBuffers(1, &flossVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, flossVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(flossVerts), flossVerts, GL_STATIC_DRAW);
-
-	glBindVertexArray(flossVAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	////// Configure Notebook VAO and VBO //////
-	unsigned int notebookVBO, notebookVAO;
-	glGenVertexArrays(1, &notebookVAO);
-	glGenBuffers(1, &notebookVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, notebookVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(notebookVerts), notebookVerts, GL_STATIC_DRAW);
-
-	glBindVertexArray(notebookVAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	////// Configure Notebook VAO and VBO //////
-	unsigned int notebookSpiralVBO, notebookSpiralVAO;
-	glGenVertexArrays(1, &notebookSpiralVAO);
-	glGenBuffers(1, &notebookSpiralVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, notebookSpiralVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(notebookSpiralVerts), notebookSpiralVerts, GL_STATIC_DRAW);
-
-	glBindVertexArray(notebookSpiralVAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-
-	////// Configure the Light VAO, VBO, and IBO //////
+	////// Configure Floss and Notebook VAOs //////
+	// compile-time meshes, uploaded at their exact size
+	GLVertexArray flossVAO;
+	GLBuffer flossVBO, flossEBO;
+	box_mesh::createVertexArray(Floss::MESH, flossVAO, flossVBO, flossEBO);
+
+	GLVertexArray notebookVAO;
+	GLBuffer notebookVBO, notebookEBO;
+	box_mesh::createVertexArray(Notebook::MESH, notebookVAO, notebookVBO, notebookEBO);
+
+
+	////// Configure the Light sphere, it owns its VAO, VBO and IBO //////
 	Sphere light(1.5f, 20, 30, true);    // Radius, Sectors, Stacks, Smooth Shading bool
-	unsigned int lightVBO, lightVAO, lightIBO;
-	glGenBuffers(1, &lightVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
-	glBufferData(GL_ARRAY_BUFFER, light.getInterleavedVertexSize(), light.getInterleavedVertices(), GL_STATIC_DRAW);
-
-	glGenBuffers(1, &lightIBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lightIBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lightIBO); glBufferData(GL_ELEMENT_ARRAY_BUFFER, light.getIndexSize(), light.getIndices(), GL_STATIC_DRAW);
-
-	glGenVertexArrays(1, &lightVAO);
-	glBindVertexArray(lightVAO);
-
-	// Bind the VBO to the buffer and set up the attributes
-	glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
-	int lightStride = light.getInterleavedStride();
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, lightStride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, false, lightStride, (void*)(sizeof(float) * 3));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, false, lightStride, (void*)(sizeof(float) * 6));
-	glEnableVertexAttribArray(2);
-
-	//Bind the IBO to the VAO for rendering
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lightIBO);
-
-
-	// Configure plane VAO & VBO
-	unsigned int planeVBO, planeVAO;
-	glGenVertexArrays(1, &planeVAO);
-	glGenBuffers(1, &planeVBO);
-
-	glBindVertexArray(planeVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	// Configure cup VAO & VBO
-	unsigned int cupVBO, cupVAO;
-	glGenVertexArrays(1, &cupVAO);
-	glGenBuffers(1, &cupVBO);
-	glBindVertexArray(cupVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, cupVBO); // POSSIBLE FIXME
-
-	// Configure straw VAO & VBO
-	unsigned int strawVBO, strawVAO;
-	glGenVertexArrays(1, &strawVAO);
-	glGenBuffers(1, &strawVBO);
-	glBindVertexArray(strawVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, strawVBO);
-
-
-	////// Configure Speaker VAO and VBO //////
-	unsigned int speakerVBO, speakerVAO;
-	glGenVertexArrays(1, &speakerVAO);
-	glGenBuffers(1, &speakerVBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, speakerVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(speakerVerts), speakerVerts, GL_STATIC_DRAW);
-
-	glBindVertexArray(speakerVAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
+	light.optimize().printSelf("light sphere");
+	light.upload();
 
 
+	////// Configure the cylinders once, each one is drawn with a single indexed draw call //////
+	static_meshes_3D::Cylinder spiralCylinder(0.3, 10, 5, true, true, true);
+	static_meshes_3D::Cylinder speakerCylinder(3, 10, 9, true, true, true);
+	static_meshes_3D::Cylinder cupCylinder(2, 8, 7, true, true, true); // cup size
+	static_meshes_3D::Cylinder strawCylinder(0.15, 10, 3, true, true, true); //best straw size (0.15, 10, 4)
 
-	// load textures (we now use a utility function to keep the code more organized)
-	// -----------------------------------------------------------------------------
-	
-	unsigned int diffuseMap = loadTexture("container2.png");
-	unsigned int specularMap = loadTexture("container2_specular.png");
-	unsigned int planeTexture = loadTexture("images/pinkMarble.jpg");
-	unsigned int cupTexture = loadTexture("images/whitebg.jpg");
-	unsigned int strawTexture = loadTexture("images/steel.jpg");
-	unsigned int notebookTexture = loadTexture("images/yellow.jpg");
-	unsigned int flossTexture = loadTexture("images/seaglass3.jpg");
-	unsigned int notebookSpiralTexture = loadTexture("images/whiteFence.jpg");
-	unsigned int speakerTexture = loadTexture("images/screen.jpg");
-
-	// shader configuration
-	// --------------------
-	lightingShader.use();
-	lightingShader.setInt("material.diffuse", 0);
-	lightingShader.setInt("material.specular", 1);
-	lightingShader.setInt("flossTexture", 0);
-	lightingShader.setInt("notebookTexture", 0);
-	lightingShader.setInt("notebookSpiralTexture", 0);
-	lightingShader.setInt("speakerTexture", 0);
-	
+	// all meshes are uploaded, staging memory they were built in can be reused
+	StagingArena::getShared().reset();
+
+
+	////// Configure the ground, streamed in chunks around the camera //////
+	// flat where the old plane was (y = -1.5), rolling hills further out
+	TerrainSettings terrainSettings;
+	terrainSettings.baseHeight = -1.5f;
+	terrainSettings.flatRadius = 300.0f;
+	terrainSettings.flatBlend = 200.0f;
+	Terrain terrain(TerrainHeightField::fromNoise(TerrainHeightField::SIMPLEX, 60.0f, 400.0f), terrainSettings);
+	// replayed frames must not depend on how fast chunks were built
+	if (pathPlayer)
+		terrain.setSynchronousStreaming(true);
 
 
-	// render loop
-	// -----------
-	while (!glfwWindowShouldClose(window))
-	{
-		// per-frame time logic
-		// --------------------
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
 
-		// input
-		// -----
-		processInput(window);
 
-		// render
-		// ------
-		glClearColor(0.6f, 0.8f, 0.5f, 1.0f); // Light olive green
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// be sure to activate shader when setting uniforms/drawing objects
-		lightingShader.use();
+
+	// load textures (we now use a utility function to keep the code more organized)
+	// -----------------------------------------------------------------------------
+	
+	GLTexture specularMap = loadTexture("container2_specular.png");
+	GLTexture planeTexture = loadTexture("images/pinkMarble.jpg");
+	GLTexture cupTexture = loadTexture("images/whitebg.jpg");
+	GLTexture strawTexture = loadTexture("images/steel.jpg");
+	GLTexture notebookTexture = loadTexture("images/yellow.jpg");
+	GLTexture flossTexture = loadTexture("images/seaglass3.jpg");
+	GLTexture notebookSpiralTexture = loadTexture("images/whiteFence.jpg");
+	GLTexture speakerTexture = loadTexture("images/screen.jpg");
+
+	// materials: each one draws with the lighting variant its textures need, picked once here
+	// ----------------------------------------------------------------------------------------
+	auto makeMaterial = [&](GLuint diffuse, GLuint specular, float specularStrength)
+	{
+		std::vector<Texture> textures = { { diffuse, "material.diffuse", "" } };
+		if (specular != 0)
+			textures.push_back({ specular, "material.specular", "" });
+
+		// specularStrength is only read by the variant without a specular map
+		Material material(textures, { { "material.shininess", 32.0f }, { "material.specularStrength", specularStrength } });
+		material.variantKey = lightingVariants.makeKey({
+			{ "NR_POINT_LIGHTS", 4 },
+			{ "USE_DIR_LIGHT", 1 },
+			{ "USE_SPOT_LIGHT", 1 },
+			{ "USE_SPECULAR_MAP", specular != 0 ? 1u : 0u }
+		});
+		material.prepare(lightingVariants.get(material.variantKey));
+		return material;
+	};
+	Material flossMaterial = makeMaterial(flossTexture.get(), specularMap.get(), 0.0f);
+	Material notebookMaterial = makeMaterial(notebookTexture.get(), specularMap.get(), 0.0f);
+	Material notebookSpiralMaterial = makeMaterial(notebookSpiralTexture.get(), specularMap.get(), 0.0f);
+	Material speakerMaterial = makeMaterial(speakerTexture.get(), specularMap.get(), 0.0f);
+	Material groundMaterial = makeMaterial(planeTexture.get(), 0, 0.2f); // marble has no specular map
+	Material cupMaterial = makeMaterial(cupTexture.get(), specularMap.get(), 0.0f);
+	Material strawMaterial = makeMaterial(strawTexture.get(), specularMap.get(), 0.0f);
+
+	// marble ball next to the cup, finely tessellated, so it is drawn at the level of detail its distance allows;
+	// up close it draws the full mesh without the meshlets facing away (levels of detail go after the meshlets)
+	glm::vec3 marblePosition(-1.0f, 0.0f, -17.0f);
+	std::unique_ptr<Mesh> marble = createSphereMesh(1.5f, 128, 64, { { planeTexture.get(), "material.diffuse", "" } });
+	marble->material = makeMaterial(planeTexture.get(), 0, 0.2f);
+	marble->buildMeshlets();
+	marble->generateLods();
+
+	// lighting uniforms belong to each program, so every variant a frame draws with gets them on first use
+	std::vector<unsigned int> litPrograms;
+	glm::mat4 projection, view;
+	auto setLighting = [&](Shader& lightingShader)
+	{
 		lightingShader.setVec3("viewPos", camera.Position);
-		lightingShader.setFloat("material.shininess", 32.0f);
 
 		/*
 		   Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index
@@ -486,49 +447,91 @@ int main()
 		lightingShader.setFloat("spotLight.quadratic", 0.032);
 		lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
 		lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-
-		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
 		lightingShader.setMat4("projection", projection);
 		lightingShader.setMat4("view", view);
+	};
+	auto useMaterial = [&](Material& material) -> Shader&
+	{
+		Shader& shader = lightingVariants.get(material.variantKey);
+		shader.use();
+		if (std::find(litPrograms.begin(), litPrograms.end(), shader.ID) == litPrograms.end())
+		{
+			litPrograms.push_back(shader.ID);
+			setLighting(shader);
+		}
+		material.bind(shader);
+		return shader;
+	};
+
+
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = glfwGetTime();
+		deltaTime = currentFrame - lastFrame;
+		lastFrame = currentFrame;
+		GLState::resetCounters();
+
+		// input
+		// -----
+		if (pathPlayer)
+		{
+			// the path decides where the camera is and which time step the frame uses
+			if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS || !pathPlayer->step(camera, deltaTime))
+				break;
+			cameraInput = CameraInput();
+
+			// streaming waits for the chunk workers in replays, keep that out of the measured frame
+			terrain.update(camera.Position);
+			frameStats.beginFrame(pathPlayer->getSegment());
+		}
+		else
+		{
+			processInput(window);
+			if (recording)
+				cameraPath.addFrame(deltaTime, cameraInput, camera);
+			cameraInput = CameraInput();
+		}
+
+		// render
+		// ------
+		glClearColor(0.6f, 0.8f, 0.5f, 1.0f); // Light olive green
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// world transformation
+		// view/projection transformations
+		projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, terrainSettings.viewDistance);
+		view = camera.GetViewMatrix();
+		litPrograms.clear();
 		glm::mat4 model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
 
-		// bind diffuse map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
-		// bind specular map
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap);
+		// every prop activates the lighting variant of its material, which also binds its textures
+		Shader* lightingShader = nullptr;
 
 		////// Build the floss  //////
 
-		// Binds floss texture 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, flossTexture);
+		lightingShader = &useMaterial(flossMaterial);
 
-		glBindVertexArray(flossVAO);
+		GLState::bindVertexArray(flossVAO.get());
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			// calculate the model matrix for each object and pass it to shader before drawing
 			glm::mat4 model = glm::mat4(1.0f);
 			model = glm::translate(model, flossPosition[i]);
 			model = glm::scale(model, glm::vec3(2.0f));
-			lightingShader.setMat4("model", model);
+			lightingShader->setMat4("model", model);
 
-			glDrawArrays(GL_TRIANGLES, 0, 42);
+			glDrawElements(GL_TRIANGLES, (GLsizei)Floss::MESH.numIndices, GL_UNSIGNED_SHORT, 0);
 		}
 
 		////// Build the Notebook //////
 
-			// Binds notebook texture 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, notebookTexture);
+		lightingShader = &useMaterial(notebookMaterial);
 
-		glBindVertexArray(notebookVAO);
+		GLState::bindVertexArray(notebookVAO.get());
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			// calculate the model matrix for each object and pass it to shader before drawing
@@ -536,18 +539,15 @@ int main()
 			model = glm::translate(model, notebookPosition[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
 			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-			lightingShader.setMat4("model", model);
+			lightingShader->setMat4("model", model);
 
-			glDrawArrays(GL_TRIANGLES, 0, 42);
+			glDrawElements(GL_TRIANGLES, (GLsizei)Notebook::MESH.numIndices, GL_UNSIGNED_SHORT, 0);
 		}
 
 		////// Build the Notebook Spirals //////
 
-		// Binds notebook spiral texture 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, notebookSpiralTexture);
+		lightingShader = &useMaterial(notebookSpiralMaterial);
 
-		glBindVertexArray(notebookSpiralVAO);
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			// calculate the model matrix for each object and pass it to shader before drawing
@@ -556,70 +556,62 @@ int main()
 			model = glm::scale(model, glm::vec3(2.0f));
 			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-			lightingShader.setMat4("model", model);
+			lightingShader->setMat4("model", model);
 
-			static_meshes_3D::Cylinder C2(0.3, 10, 5, true, true, true); 
-			C2.render();
+			spiralCylinder.render();
 		}
 
 		////// Build the speaker  //////
 
-		// Binds floss texture 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, speakerTexture);
+		lightingShader = &useMaterial(speakerMaterial);
 
-		glBindVertexArray(speakerVAO);
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			// calculate the model matrix for each object and pass it to shader before drawing
 			glm::mat4 model = glm::mat4(1.0f);
 			model = glm::translate(model, speakerPosition[i]);
 			model = glm::scale(model, glm::vec3(1.0f));
-			lightingShader.setMat4("model", model);
+			lightingShader->setMat4("model", model);
 
-			static_meshes_3D::Cylinder C2(3, 10, 9, true, true, true);
-			C2.render();
+			speakerCylinder.render();
 		}
 
-		// RENDER PLANE
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, planeTexture);
-		
-
-		glBindVertexArray(planeVAO);
-		for (unsigned int i = 0; i < 10; i++)
-		{
-			glm::mat4 model_plane = glm::mat4(1.0f);
-			model_plane = glm::translate(model_plane, glm::vec3(0.0f, -5.0f, 0.0f)); // Position the plane below the cup's base
-			model_plane = glm::rotate(model_plane, glm::radians(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-			model_plane = glm::scale(model_plane, glm::vec3(30.0f, 1.0f, 20.0f)); // Scale the plane to be larger in x and z directions
-			lightingShader.setMat4("model", model_plane);
+		// RENDER GROUND
+		lightingShader = &useMaterial(groundMaterial);
 
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-		}
+		lightingShader->setMat4("model", glm::mat4(1.0f)); // terrain vertices are in world space
+		if (!pathPlayer)
+			terrain.update(camera.Position); // replays updated it before the frame was measured
+		terrain.render(projection * view, camera.Position);
 
 		// RENDER CUP
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cupTexture);
-		glBindVertexArray(cupVAO);
+		lightingShader = &useMaterial(cupMaterial);
 		glm::mat4 model_cup = glm::mat4(1.0f);
 		model_cup = glm::translate(model_cup, glm::vec3(5.0f, 2.0f, -17.0f));
-		lightingShader.setMat4("model", model_cup);
+		lightingShader->setMat4("model", model_cup);
 
-		static_meshes_3D::Cylinder C(2, 8, 7, true, true, true); // cup size
-		C.render();
+		cupCylinder.render();
 
 		// RENDER STRAW
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, strawTexture);
-		glBindVertexArray(strawVAO);
+		lightingShader = &useMaterial(strawMaterial);
 		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
 		model = glm::translate(model, glm::vec3(5.0f, 7.0f, -17.0f));
 		model = glm::rotate(model, glm::radians(3.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Tilt the straw by 45 degrees around the z-axis
-		lightingShader.setMat4("model", model);
+		lightingShader->setMat4("model", model);
+
+		strawCylinder.render();
+
+		// RENDER MARBLE
+		lightingShader = &useMaterial(marble->material);
+		model = glm::translate(glm::mat4(1.0f), marblePosition);
+		lightingShader->setMat4("model", model);
 
-		static_meshes_3D::Cylinder C2(0.15, 10, 3, true, true, true); //best straw size (0.15, 10, 4)
-		C2.render();
+		const unsigned int marbleLod = marble->selectLod(glm::distance(camera.Position, marblePosition),
+			getProjectionScale(glm::radians(camera.Zoom), (float)SCR_HEIGHT));
+		if (marbleLod == 0)
+			marble->DrawCulled(*lightingShader, model, projection * view, camera.Position);
+		else
+			marble->Draw(*lightingShader, marbleLod);
 
 
 
@@ -630,7 +622,6 @@ int main()
 		lightSphereShader.setMat4("projection", projection);
 		lightSphereShader.setMat4("view", view);
 
-		glBindVertexArray(lightVAO);
 		for (unsigned int i = 0; i < 4; i++)
 		{
 			model = model = glm::mat4(1.0f);
@@ -638,38 +629,59 @@ int main()
 			model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller sphere
 			lightSphereShader.setMat4("model", model);
 			// Draw the lights
-			glDrawElements(GL_TRIANGLES, light.getIndexCount(), GL_UNSIGNED_INT, (void*)0);
+			light.draw();
 
 		}
 
 
+		if (pathPlayer)
+			frameStats.endFrame();
+
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	// replay results, recorded path
+	// -----------------------------
+	if (pathPlayer)
+	{
+		frameStats.finish();
+		frameStats.print(cameraPath.getSegmentNames());
+		if (statsPath)
+			frameStats.writeCsv(statsPath, cameraPath.getSegmentNames());
+	}
+	if (recording)
+		cameraPath.save(recordPath);
+
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
 
-	glDeleteVertexArrays(1, &flossVAO);
-	glDeleteBuffers(1, &flossVBO);
-	glDeleteVertexArrays(1, &notebookVAO);
-	glDeleteBuffers(1, &notebookVBO);
-	glDeleteVertexArrays(1, &notebookSpiralVAO);
-	glDeleteBuffers(1, &notebookSpiralVBO);
-	glDeleteVertexArrays(1, &speakerVAO);
-	glDeleteBuffers(1, &speakerVBO);
-	glDeleteVertexArrays(1, &lightVAO);
-	glDeleteBuffers(1, &lightVBO);
-	glDeleteVertexArrays(1, &cupVAO);
-	glDeleteBuffers(1, &cupVBO);
-	glDeleteVertexArrays(1, &strawVAO);
-	glDeleteBuffers(1, &strawVBO);
-	glDeleteVertexArrays(1, &planeVAO);
-	glDeleteBuffers(1, &planeVBO);
+	// handles and meshes would only release their GL objects at the end of main, after the context is gone
+	flossVAO.reset();
+	flossVBO.reset();
+	flossEBO.reset();
+	notebookVAO.reset();
+	notebookVBO.reset();
+	notebookEBO.reset();
+	for (GLTexture* texture : { &specularMap, &planeTexture, &cupTexture, &strawTexture, &notebookTexture,
+		&flossTexture, &notebookSpiralTexture, &speakerTexture })
+	{
+		texture->reset();
+	}
+	light.releaseBuffers();
+	spiralCylinder.deleteMesh();
+	speakerCylinder.deleteMesh();
+	cupCylinder.deleteMesh();
+	strawCylinder.deleteMesh();
+	terrain.releaseBuffers();
+	marble.reset();
 	
 
+	// state cache counters of the last rendered frame
+	GLState::printCounters();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -684,20 +696,28 @@ void processInput(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 
+	// movement keys are gathered with the mouse input of the frame, so a recording can play them back
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		camera.ProcessKeyboard(FORWARD, deltaTime);
+		cameraInput.keys |= 1u << FORWARD;
 	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		camera.ProcessKeyboard(BACKWARD, deltaTime);
+		cameraInput.keys |= 1u << BACKWARD;
 	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		camera.ProcessKeyboard(LEFT, deltaTime);
+		cameraInput.keys |= 1u << LEFT;
 	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		camera.ProcessKeyboard(RIGHT, deltaTime);
+		cameraInput.keys |= 1u << RIGHT;
 	// Move camera up
 	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) // go up with Q
-		camera.ProcessKeyboard(UP, deltaTime);
+		cameraInput.keys |= 1u << UP;
 	// Move camera down
 	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) // go down with E
-		camera.ProcessKeyboard(DOWN, deltaTime);
+		cameraInput.keys |= 1u << DOWN;
+	cameraInput.apply(camera, deltaTime);
+
+	// next camera path segment
+	const bool segmentKey = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+	if (recording && segmentKey && !segmentKeyDown)
+		cameraPath.beginSegment("segment " + std::to_string(cameraPath.getSegmentNames().size()));
+	segmentKeyDown = segmentKey;
 
 	// perspective 
 	if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
@@ -713,7 +733,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	GLState::viewport(0, 0, width, height);
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -733,22 +753,23 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	lastX = xpos;
 	lastY = ypos;
 
-	camera.ProcessMouseMovement(xoffset, yoffset);
+	// applied with the keys of the next frame, see processInput
+	cameraInput.mouseX += xoffset;
+	cameraInput.mouseY += yoffset;
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-	camera.ProcessMouseScroll(yoffset);
+	cameraInput.scroll += (float)yoffset;
 }
 
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
-unsigned int loadTexture(char const* path)
+GLTexture loadTexture(char const* path)
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+	GLTexture texture = GLTexture::create();
 
 	int width, height, nrComponents;
 	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
@@ -762,7 +783,7 @@ unsigned int loadTexture(char const* path)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLState::bindTexture(0, GL_TEXTURE_2D, texture.get());
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -779,5 +800,48 @@ unsigned int loadTexture(char const* path)
 		stbi_image_free(data);
 	}
 
-	return textureID;
+	return texture;
+}
+
+// welds the triangle corners of a finely tessellated sphere back into an indexed mesh with indexVBO
+// ---------------------------------------------------------------------------------------------------
+void benchmarkSphereIndexing()
+{
+	const Sphere sphere(1.0f, 512, 256);
+	const float* positions = sphere.getVertices();
+	const float* normals = sphere.getNormals();
+	const float* texCoords = sphere.getTexCoords();
+
+	std::vector<glm::vec3> cornerPositions, cornerNormals;
+	std::vector<glm::vec2> cornerTexCoords;
+	cornerPositions.reserve(sphere.getIndexCount());
+	cornerNormals.reserve(sphere.getIndexCount());
+	cornerTexCoords.reserve(sphere.getIndexCount());
+	for (unsigned int i = 0; i < sphere.getIndexCount(); i++)
+	{
+		const unsigned int vertex = sphere.getIndices()[i];
+		cornerPositions.push_back(glm::make_vec3(positions + vertex * 3));
+		cornerNormals.push_back(glm::make_vec3(normals + vertex * 3));
+		cornerTexCoords.push_back(glm::make_vec2(texCoords + vertex * 2));
+	}
+
+	benchmarkIndexVBO(cornerPositions, cornerTexCoords, cornerNormals);
+}
+
+// builds a Mesh from the CPU data of a smooth sphere; tangents are left at zero, the lighting shaders don't read them
+// -------------------------------------------------------------------------------------------------------------------
+std::unique_ptr<Mesh> createSphereMesh(float radius, int sectorCount, int stackCount, std::vector<Texture>&& textures)
+{
+	const Sphere sphere(radius, sectorCount, stackCount);
+	std::vector<Vertex> vertices(sphere.getVertexCount());
+	for (unsigned int i = 0; i < sphere.getVertexCount(); i++)
+	{
+		vertices[i].Position = glm::make_vec3(sphere.getVertices() + i * 3);
+		vertices[i].Normal = glm::make_vec3(sphere.getNormals() + i * 3);
+		vertices[i].TexCoords = glm::make_vec2(sphere.getTexCoords() + i * 2);
+		vertices[i].Tangent = vertices[i].Bitangent = glm::vec3(0.0f);
+	}
+	std::vector<unsigned int> indices(sphere.getIndices(), sphere.getIndices() + sphere.getIndexCount());
+
+	return std::make_unique<Mesh>(std::move(vertices), std::move(indices), std::move(textures));
 }
\ No newline at end of file
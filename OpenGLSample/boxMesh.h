@@ -0,0 +1,333 @@
+#pragma once
+
+// STL
+#include <array>
+#include <cstddef>
+
+// GLAD
+#include <glad/glad.h>
+
+#include "glHandle.h"
+#include "glState.h"
+
+/**
+ * Compile-time generators for small indexed props: boxes, N-sided prisms and rounded boxes. Every mesh is a pair of
+ * std::array holding position / normal / tex coords vertices (8 floats) and 16 bit triangle indices, so a constexpr
+ * variable of it lives in the read-only data of the executable and is uploaded as is.
+ *
+ * Triangles are counter-clockwise seen from outside.
+ */
+namespace box_mesh {
+
+constexpr std::size_t FLOATS_PER_VERTEX = 8;
+
+/**
+ * Indexed triangle mesh with a vertex and index count known at compile time.
+ */
+template <std::size_t NumVertices, std::size_t NumIndices>
+struct IndexedMesh
+{
+    static_assert(NumVertices <= 65536, "Mesh vertices must fit 16 bit indices");
+
+    static constexpr std::size_t numVertices = NumVertices;
+    static constexpr std::size_t numIndices = NumIndices;
+
+    std::array<GLfloat, NumVertices * FLOATS_PER_VERTEX> vertices{};
+    std::array<GLushort, NumIndices> indices{};
+
+    constexpr void setVertex(std::size_t vertex, const double position[3], const double normal[3], double u, double v)
+    {
+        GLfloat* out = &vertices[vertex * FLOATS_PER_VERTEX];
+        for (int i = 0; i < 3; i++)
+        {
+            out[i] = static_cast<GLfloat>(position[i]);
+            out[3 + i] = static_cast<GLfloat>(normal[i]);
+        }
+        out[6] = static_cast<GLfloat>(u);
+        out[7] = static_cast<GLfloat>(v);
+    }
+
+    constexpr void setTriangle(std::size_t triangle, std::size_t a, std::size_t b, std::size_t c)
+    {
+        indices[triangle * 3] = static_cast<GLushort>(a);
+        indices[triangle * 3 + 1] = static_cast<GLushort>(b);
+        indices[triangle * 3 + 2] = static_cast<GLushort>(c);
+    }
+};
+
+namespace detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// std:: math is not constexpr, these are accurate to double precision on the ranges used here
+constexpr double sqrt(double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+
+    double result = x < 1.0 ? 1.0 : x;
+    for (int i = 0; i < 64; i++)
+    {
+        double next = 0.5 * (result + x / result);
+        if (next == result)
+            break;
+        result = next;
+    }
+    return result;
+}
+
+constexpr double sin(double x)
+{
+    // reduce to [-pi, pi], then Taylor series
+    while (x > PI)
+        x -= 2.0 * PI;
+    while (x < -PI)
+        x += 2.0 * PI;
+
+    double term = x;
+    double result = x;
+    for (int n = 1; n < 16; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        result += term;
+    }
+    return result;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + 0.5 * PI);
+}
+
+constexpr double tan(double x)
+{
+    return sin(x) / cos(x);
+}
+
+// one face of the box: outward axis, then the axes its s and t grid coordinates run along (s x t = outward, so the
+// quads are counter-clockwise seen from outside), and tex coords at s = t = 0 plus their change along s and t
+struct BoxFace
+{
+    int normalAxis;
+    double normalSign;
+    int sAxis;
+    double sSign;
+    int tAxis;
+    double tSign;
+    double uv[2];
+    double uvS[2];
+    double uvT[2];
+};
+
+// -Z, +Z, -X, +X, -Y, +Y; tex coords follow the hand-typed boxes this replaces
+constexpr BoxFace BOX_FACES[6] = {
+    { 2, -1.0, 0, -1.0, 1, 1.0, { 1.0, 0.0 }, { -1.0, 0.0 }, { 0.0, 1.0 } },
+    { 2, 1.0, 0, 1.0, 1, 1.0, { 0.0, 0.0 }, { 1.0, 0.0 }, { 0.0, 1.0 } },
+    { 0, -1.0, 2, 1.0, 1, 1.0, { 0.0, 1.0 }, { 0.0, -1.0 }, { 1.0, 0.0 } },
+    { 0, 1.0, 2, -1.0, 1, 1.0, { 0.0, 0.0 }, { 0.0, 1.0 }, { 1.0, 0.0 } },
+    { 1, -1.0, 0, 1.0, 2, 1.0, { 0.0, 1.0 }, { 1.0, 0.0 }, { 0.0, -1.0 } },
+    { 1, 1.0, 0, 1.0, 2, -1.0, { 0.0, 0.0 }, { 1.0, 0.0 }, { 0.0, 1.0 } }
+};
+
+// Grid line k of 2 * (segments + 1) along a face axis of half size halfExtent. The first and last segments + 1 lines
+// lie in the rounded band, spaced so the band vertices are evenly spread over its 45 degrees.
+constexpr double roundedGridLine(int k, int segments, double halfExtent, double radius)
+{
+    const bool upper = k > segments;
+    const int j = upper ? k - segments - 1 : segments - k;
+    const double angle = segments == 0 ? 0.25 * PI : 0.25 * PI * j / segments;
+    const double offset = (halfExtent - radius) + radius * tan(angle);
+    return upper ? offset : -offset;
+}
+
+} // namespace detail
+
+/**
+ * Box with rounded edges and corners, Segments quads per 45 degrees of rounding. Every face keeps its own [0, 1]
+ * tex coords, projected from the flat face, so the rounded band is shared by the two faces meeting there.
+ *
+ * @param halfX, halfY, halfZ  Half size of the box along each axis
+ * @param radius               Rounding radius, at most the smallest half size; 0 gives a plain box
+ */
+template <int Segments>
+constexpr IndexedMesh<6 * (2 * Segments + 2) * (2 * Segments + 2), 36 * (2 * Segments + 1) * (2 * Segments + 1)>
+makeRoundedBox(double halfX, double halfY, double halfZ, double radius)
+{
+    static_assert(Segments >= 0, "Segments must not be negative");
+
+    constexpr int rowSize = 2 * Segments + 2;
+    constexpr int cells = rowSize - 1;
+
+    IndexedMesh<6 * rowSize * rowSize, 36 * cells * cells> mesh;
+    const double halfExtents[3] = { halfX, halfY, halfZ };
+
+    std::size_t vertex = 0;
+    std::size_t triangle = 0;
+    for (const detail::BoxFace& face : detail::BOX_FACES)
+    {
+        const std::size_t base = vertex;
+        for (int j = 0; j < rowSize; j++)
+        {
+            for (int i = 0; i < rowSize; i++)
+            {
+                const double sLine = detail::roundedGridLine(i, Segments, halfExtents[face.sAxis], radius);
+                const double tLine = detail::roundedGridLine(j, Segments, halfExtents[face.tAxis], radius);
+                const double s = 0.5 + 0.5 * sLine / halfExtents[face.sAxis];
+                const double t = 0.5 + 0.5 * tLine / halfExtents[face.tAxis];
+
+                // point on the flat box, then pushed onto the rounding around the inner box
+                double position[3] = {};
+                position[face.normalAxis] = face.normalSign * halfExtents[face.normalAxis];
+                position[face.sAxis] = face.sSign * sLine;
+                position[face.tAxis] = face.tSign * tLine;
+
+                double normal[3] = {};
+                normal[face.normalAxis] = face.normalSign;
+                if (radius > 0.0)
+                {
+                    double inner[3] = {};
+                    double lengthSquared = 0.0;
+                    for (int a = 0; a < 3; a++)
+                    {
+                        const double limit = halfExtents[a] - radius;
+                        inner[a] = position[a] > limit ? limit : (position[a] < -limit ? -limit : position[a]);
+                        normal[a] = position[a] - inner[a];
+                        lengthSquared += normal[a] * normal[a];
+                    }
+
+                    const double invLength = 1.0 / detail::sqrt(lengthSquared);
+                    for (int a = 0; a < 3; a++)
+                    {
+                        normal[a] *= invLength;
+                        position[a] = inner[a] + radius * normal[a];
+                    }
+                }
+
+                mesh.setVertex(vertex++, position, normal,
+                               face.uv[0] + s * face.uvS[0] + t * face.uvT[0],
+                               face.uv[1] + s * face.uvS[1] + t * face.uvT[1]);
+            }
+        }
+
+        for (int j = 0; j < cells; j++)
+        {
+            for (int i = 0; i < cells; i++)
+            {
+                const std::size_t k1 = base + j * rowSize + i;
+                const std::size_t k2 = k1 + 1;
+                const std::size_t k3 = k1 + rowSize;
+                const std::size_t k4 = k3 + 1;
+                mesh.setTriangle(triangle++, k1, k2, k4);
+                mesh.setTriangle(triangle++, k1, k4, k3);
+            }
+        }
+    }
+    return mesh;
+}
+
+/**
+ * Box with one quad per face, 24 vertices and 36 indices.
+ */
+constexpr IndexedMesh<24, 36> makeBox(double halfX, double halfY, double halfZ)
+{
+    return makeRoundedBox<0>(halfX, halfY, halfZ, 0.0);
+}
+
+/**
+ * Flat shaded prism around the Y axis with Sides sides. The first side faces +X, sides wrap the texture once
+ * horizontally and the caps get a disc cut out of the texture. Sides = 4 gives a 24 vertex, 36 index box.
+ *
+ * @param radius      Distance from the axis to the side edges
+ * @param halfHeight  Half size along Y
+ */
+template <int Sides>
+constexpr IndexedMesh<6 * Sides, 12 * Sides - 12> makePrism(double radius, double halfHeight)
+{
+    static_assert(Sides >= 3, "A prism needs at least 3 sides");
+
+    IndexedMesh<6 * Sides, 12 * Sides - 12> mesh;
+
+    // edge angles, counter-clockwise seen from +Y (x = cos, z = -sin)
+    double cosines[Sides + 1] = {};
+    double sines[Sides + 1] = {};
+    for (int i = 0; i <= Sides; i++)
+    {
+        const double angle = 2.0 * detail::PI * (i - 0.5) / Sides;
+        cosines[i] = detail::cos(angle);
+        sines[i] = detail::sin(angle);
+    }
+
+    std::size_t vertex = 0;
+    std::size_t triangle = 0;
+    for (int i = 0; i < Sides; i++)
+    {
+        const double middle = 2.0 * detail::PI * i / Sides;
+        const double normal[3] = { detail::cos(middle), 0.0, -detail::sin(middle) };
+        const double corners[4][3] = {
+            { radius * cosines[i], -halfHeight, -radius * sines[i] },
+            { radius * cosines[i + 1], -halfHeight, -radius * sines[i + 1] },
+            { radius * cosines[i + 1], halfHeight, -radius * sines[i + 1] },
+            { radius * cosines[i], halfHeight, -radius * sines[i] }
+        };
+        const double u0 = static_cast<double>(i) / Sides;
+        const double u1 = static_cast<double>(i + 1) / Sides;
+
+        mesh.setVertex(vertex, corners[0], normal, u0, 0.0);
+        mesh.setVertex(vertex + 1, corners[1], normal, u1, 0.0);
+        mesh.setVertex(vertex + 2, corners[2], normal, u1, 1.0);
+        mesh.setVertex(vertex + 3, corners[3], normal, u0, 1.0);
+        mesh.setTriangle(triangle++, vertex, vertex + 1, vertex + 2);
+        mesh.setTriangle(triangle++, vertex, vertex + 2, vertex + 3);
+        vertex += 4;
+    }
+
+    // caps as fans around their first vertex
+    for (int cap = 0; cap < 2; cap++)
+    {
+        const bool top = cap == 1;
+        const double normal[3] = { 0.0, top ? 1.0 : -1.0, 0.0 };
+        const std::size_t base = vertex;
+        for (int i = 0; i < Sides; i++)
+        {
+            const double position[3] = { radius * cosines[i], top ? halfHeight : -halfHeight, -radius * sines[i] };
+            mesh.setVertex(vertex++, position, normal, 0.5 + 0.5 * cosines[i], 0.5 + (top ? -0.5 : 0.5) * sines[i]);
+        }
+        for (int i = 1; i + 1 < Sides; i++)
+        {
+            if (top)
+                mesh.setTriangle(triangle++, base, base + i, base + i + 1);
+            else
+                mesh.setTriangle(triangle++, base, base + i + 1, base + i);
+        }
+    }
+    return mesh;
+}
+
+/**
+ * Creates a VAO with exactly sized vertex and index buffers for the mesh. Vertices are position / normal /
+ * tex coords at attributes 0 / 1 / 2. Leaves the new VAO bound.
+ */
+template <std::size_t NumVertices, std::size_t NumIndices>
+void createVertexArray(const IndexedMesh<NumVertices, NumIndices>& mesh, GLVertexArray& vao, GLBuffer& vbo,
+                       GLBuffer& ebo)
+{
+    vao = GLVertexArray::create();
+    vbo = GLBuffer::create();
+    ebo = GLBuffer::create();
+
+    GLState::bindVertexArray(vao.get());
+    GLState::bindBuffer(GL_ARRAY_BUFFER, vbo.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mesh.vertices), mesh.vertices.data(), GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo.get());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(mesh.indices), mesh.indices.data(), GL_STATIC_DRAW);
+
+    const GLsizei stride = FLOATS_PER_VERTEX * sizeof(GLfloat);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(2);
+}
+
+} // namespace box_mesh
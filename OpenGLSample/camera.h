@@ -68,6 +68,16 @@ public:
 		return glm::lookAt(Position, Position + Front, Up);
 	}
 
+	// places the camera directly, e.g. from a recorded camera path
+	void SetPose(glm::vec3 position, float yaw, float pitch, float zoom)
+	{
+		Position = position;
+		Yaw = yaw;
+		Pitch = pitch;
+		Zoom = zoom;
+		updateCameraVectors();
+	}
+
 	// processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
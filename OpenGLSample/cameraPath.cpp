@@ -0,0 +1,315 @@
+// STL
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+// Project
+#include "cameraPath.h"
+
+namespace {
+
+	const int CAMERA_PATH_VERSION = 1;
+
+	const Camera_Movement MOVEMENTS[] = { FORWARD, BACKWARD, LEFT, RIGHT, UP, DOWN };
+
+	/**
+	 * Reads whitespace separated numbers off a line; hexadecimal floats as written by %a are read exactly.
+	 */
+	struct LineReader
+	{
+		const char* cursor;
+		bool ok = true;
+
+		explicit LineReader(const char* line) : cursor(line) {}
+
+		float readFloat()
+		{
+			char* end = nullptr;
+			const float value = std::strtof(cursor, &end);
+			ok = ok && end != cursor;
+			cursor = end;
+			return value;
+		}
+
+		unsigned int readUnsigned()
+		{
+			char* end = nullptr;
+			const unsigned long value = std::strtoul(cursor, &end, 10);
+			ok = ok && end != cursor;
+			cursor = end;
+			return static_cast<unsigned int>(value);
+		}
+
+		CameraPose readPose()
+		{
+			CameraPose pose;
+			pose.position.x = readFloat();
+			pose.position.y = readFloat();
+			pose.position.z = readFloat();
+			pose.yaw = readFloat();
+			pose.pitch = readFloat();
+			pose.zoom = readFloat();
+			return pose;
+		}
+	};
+
+	void writePose(FILE* file, const CameraPose& pose)
+	{
+		std::fprintf(file, "%a %a %a %a %a %a", pose.position.x, pose.position.y, pose.position.z, pose.yaw, pose.pitch,
+			pose.zoom);
+	}
+
+	CameraPose mixPoses(const CameraPose& a, const CameraPose& b, float t)
+	{
+		CameraPose pose;
+		pose.position = glm::mix(a.position, b.position, t);
+		pose.yaw = glm::mix(a.yaw, b.yaw, t);
+		pose.pitch = glm::mix(a.pitch, b.pitch, t);
+		pose.zoom = glm::mix(a.zoom, b.zoom, t);
+		return pose;
+	}
+
+	bool startsWith(const std::string& line, const char* word, size_t& rest)
+	{
+		const size_t length = std::char_traits<char>::length(word);
+		if (line.compare(0, length, word) != 0 || (line.size() > length && line[length] != ' ')) {
+			return false;
+		}
+		rest = std::min(line.size(), length + 1);
+		return true;
+	}
+
+} // namespace
+
+void CameraInput::apply(Camera& camera, float deltaTime) const
+{
+	if (mouseX != 0.0f || mouseY != 0.0f) {
+		camera.ProcessMouseMovement(mouseX, mouseY);
+	}
+	if (scroll != 0.0f) {
+		camera.ProcessMouseScroll(scroll);
+	}
+	for (Camera_Movement movement : MOVEMENTS)
+	{
+		if (keys & (1u << movement)) {
+			camera.ProcessKeyboard(movement, deltaTime);
+		}
+	}
+}
+
+CameraPose CameraPose::of(const Camera& camera)
+{
+	CameraPose pose;
+	pose.position = camera.Position;
+	pose.yaw = camera.Yaw;
+	pose.pitch = camera.Pitch;
+	pose.zoom = camera.Zoom;
+	return pose;
+}
+
+void CameraPose::apply(Camera& camera) const
+{
+	camera.SetPose(position, yaw, pitch, zoom);
+}
+
+void CameraPath::start(const Camera& camera)
+{
+	_startPose = CameraPose::of(camera);
+	_frames.clear();
+	_segmentNames.assign(1, "default");
+}
+
+void CameraPath::beginSegment(const std::string& name)
+{
+	if (_segmentNames.empty()) {
+		_segmentNames.push_back("default");
+	}
+
+	// a segment without frames is renamed instead of being left empty
+	if (_frames.empty() || _frames.back().segment != _segmentNames.size() - 1) {
+		_segmentNames.back() = name;
+	}
+	else {
+		_segmentNames.push_back(name);
+	}
+}
+
+void CameraPath::addFrame(float deltaTime, const CameraInput& input, const Camera& camera)
+{
+	if (_segmentNames.empty()) {
+		_segmentNames.push_back("default");
+	}
+
+	CameraPathFrame frame;
+	frame.deltaTime = deltaTime;
+	frame.input = input;
+	frame.pose = CameraPose::of(camera);
+	frame.segment = static_cast<unsigned int>(_segmentNames.size() - 1);
+	_frames.push_back(frame);
+}
+
+bool CameraPath::save(const char* path) const
+{
+	FILE* file = std::fopen(path, "w");
+	if (file == nullptr)
+	{
+		std::cout << "ERROR::CAMERA_PATH::FAILED_TO_WRITE " << path << std::endl;
+		return false;
+	}
+
+	std::fprintf(file, "camerapath %d\nstart ", CAMERA_PATH_VERSION);
+	writePose(file, _startPose);
+	std::fprintf(file, "\n");
+
+	unsigned int segment = ~0u;
+	for (const CameraPathFrame& frame : _frames)
+	{
+		if (frame.segment != segment)
+		{
+			segment = frame.segment;
+			std::fprintf(file, "segment %s\n", _segmentNames[segment].c_str());
+		}
+		std::fprintf(file, "frame %a %u %a %a %a ", frame.deltaTime, frame.input.keys, frame.input.mouseX,
+			frame.input.mouseY, frame.input.scroll);
+		writePose(file, frame.pose);
+		std::fprintf(file, "\n");
+	}
+
+	const bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	if (!ok) {
+		std::cout << "ERROR::CAMERA_PATH::FAILED_TO_WRITE " << path << std::endl;
+	}
+	return ok;
+}
+
+bool CameraPath::load(const char* path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::CAMERA_PATH::FAILED_TO_OPEN " << path << std::endl;
+		return false;
+	}
+
+	CameraPath result;
+	std::string line;
+	unsigned int lineNumber = 0;
+	bool valid = static_cast<bool>(std::getline(file, line)) && line == "camerapath " + std::to_string(CAMERA_PATH_VERSION);
+	while (valid && std::getline(file, line))
+	{
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		size_t rest = 0;
+		if (line.empty()) {
+			continue;
+		}
+		else if (startsWith(line, "start", rest))
+		{
+			LineReader reader(line.c_str() + rest);
+			result._startPose = reader.readPose();
+			valid = reader.ok;
+		}
+		else if (startsWith(line, "segment", rest))
+		{
+			result._segmentNames.push_back(line.substr(rest));
+		}
+		else if (startsWith(line, "frame", rest))
+		{
+			if (result._segmentNames.empty()) {
+				result._segmentNames.push_back("default");
+			}
+
+			LineReader reader(line.c_str() + rest);
+			CameraPathFrame frame;
+			frame.deltaTime = reader.readFloat();
+			frame.input.keys = reader.readUnsigned();
+			frame.input.mouseX = reader.readFloat();
+			frame.input.mouseY = reader.readFloat();
+			frame.input.scroll = reader.readFloat();
+			frame.pose = reader.readPose();
+			frame.segment = static_cast<unsigned int>(result._segmentNames.size() - 1);
+			result._frames.push_back(frame);
+			valid = reader.ok;
+		}
+		else {
+			valid = false;
+		}
+	}
+
+	if (!valid)
+	{
+		std::cout << "ERROR::CAMERA_PATH::INVALID_FILE " << path << " (line " << lineNumber + 1 << ")" << std::endl;
+		return false;
+	}
+	*this = std::move(result);
+	return true;
+}
+
+double CameraPath::getDuration() const
+{
+	double duration = 0.0;
+	for (const CameraPathFrame& frame : _frames) {
+		duration += frame.deltaTime;
+	}
+	return duration;
+}
+
+CameraPathPlayer::CameraPathPlayer(const CameraPath& path, CameraReplayMode mode, float timeStep)
+	: _path(path), _mode(mode), _timeStep(timeStep)
+{
+}
+
+void CameraPathPlayer::reset(Camera& camera)
+{
+	_path.getStartPose().apply(camera);
+	_frame = 0;
+	_segment = 0;
+	_cursor = 0;
+	_cursorTime = 0.0;
+}
+
+bool CameraPathPlayer::step(Camera& camera, float& deltaTime)
+{
+	const std::vector<CameraPathFrame>& frames = _path.getFrames();
+
+	if (_mode == CameraReplayMode::Input)
+	{
+		if (_frame >= frames.size()) {
+			return false;
+		}
+		const CameraPathFrame& frame = frames[_frame];
+		frame.input.apply(camera, _timeStep);
+		_segment = frame.segment;
+	}
+	else
+	{
+		// frame n shows the pose at (n + 1) time steps, as the recording showed its first pose after one frame;
+		// the time is computed from the frame number, so that it does not drift
+		const double time = (_frame + 1.0) * _timeStep;
+		while (_cursor < frames.size() && _cursorTime + frames[_cursor].deltaTime < time)
+		{
+			_cursorTime += frames[_cursor].deltaTime;
+			_cursor++;
+		}
+		if (_cursor >= frames.size()) {
+			return false;
+		}
+
+		const CameraPathFrame& frame = frames[_cursor];
+		const CameraPose& previous = _cursor > 0 ? frames[_cursor - 1].pose : _path.getStartPose();
+		const float t = frame.deltaTime > 0.0f ? static_cast<float>((time - _cursorTime) / frame.deltaTime) : 1.0f;
+		mixPoses(previous, frame.pose, glm::clamp(t, 0.0f, 1.0f)).apply(camera);
+		_segment = frame.segment;
+	}
+
+	deltaTime = _timeStep;
+	_frame++;
+	return true;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+// GLAD (camera.h needs the GL types)
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "camera.h"
+
+/**
+ * Camera input of one frame, without the window system: what processInput and the mouse callbacks gathered.
+ */
+struct CameraInput
+{
+    unsigned int keys = 0; // Bit (1 << Camera_Movement) for every movement key held
+    float mouseX = 0.0f; // Mouse offsets, as ProcessMouseMovement takes them
+    float mouseY = 0.0f;
+    float scroll = 0.0f; // Vertical wheel offset
+
+    /**
+     * Moves the camera: mouse and wheel first, then keys, the order live input always had.
+     */
+    void apply(Camera& camera, float deltaTime) const;
+};
+
+/**
+ * Everything that places the camera.
+ */
+struct CameraPose
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = YAW;
+    float pitch = PITCH;
+    float zoom = ZOOM;
+
+    static CameraPose of(const Camera& camera);
+    void apply(Camera& camera) const;
+};
+
+/**
+ * One recorded frame: its time step, the input it applied and the pose that resulted.
+ */
+struct CameraPathFrame
+{
+    float deltaTime = 0.0f;
+    CameraInput input;
+    CameraPose pose;
+    unsigned int segment = 0;
+};
+
+/**
+ * Recorded camera path, split in named segments ("approach", "orbit cup", ...) that frame statistics are tagged with.
+ *
+ * Saved as text, one line per frame, floats in hexadecimal so that they load back bit for bit:
+ *   camerapath 1
+ *   start <pose>
+ *   segment <name>
+ *   frame <deltaTime> <keys> <mouseX> <mouseY> <scroll> <pose>
+ * where <pose> is x y z yaw pitch zoom.
+ */
+class CameraPath
+{
+public:
+    /**
+     * Starts recording from the current camera pose, dropping frames recorded before.
+     */
+    void start(const Camera& camera);
+
+    /**
+     * Starts a new segment, following frames belong to it. Frames before the first call are in segment "default".
+     */
+    void beginSegment(const std::string& name);
+
+    /**
+     * Records a frame, after input was applied to the camera.
+     */
+    void addFrame(float deltaTime, const CameraInput& input, const Camera& camera);
+
+    bool save(const char* path) const;
+    bool load(const char* path);
+
+    const CameraPose& getStartPose() const { return _startPose; }
+    const std::vector<CameraPathFrame>& getFrames() const { return _frames; }
+    const std::vector<std::string>& getSegmentNames() const { return _segmentNames; }
+
+    /**
+     * Gets recorded time, sum of the frame time steps.
+     */
+    double getDuration() const;
+
+private:
+    CameraPose _startPose;
+    std::vector<CameraPathFrame> _frames;
+    std::vector<std::string> _segmentNames;
+};
+
+/**
+ * How CameraPathPlayer feeds a path back.
+ */
+enum class CameraReplayMode
+{
+    Input, // Recorded input, one recorded frame per replayed frame (same keys, mouse and wheel, fixed time step)
+    Poses  // Recorded poses interpolated at the fixed time step (same motion over time as the recording)
+};
+
+/**
+ * Plays a camera path back at a fixed time step, so that every replay renders the same frames whatever the
+ * frame rate. Input replays reproduce the recorded frame count, pose replays the recorded duration.
+ */
+class CameraPathPlayer
+{
+public:
+    CameraPathPlayer(const CameraPath& path, CameraReplayMode mode, float timeStep = 1.0f / 60.0f);
+
+    /**
+     * Puts the camera where the path starts and rewinds.
+     */
+    void reset(Camera& camera);
+
+    /**
+     * Moves the camera to the next frame of the path.
+     *
+     * @param deltaTime  Receives the time step the frame must use
+     * @return False when the path is over; the camera is left as it was.
+     */
+    bool step(Camera& camera, float& deltaTime);
+
+    /**
+     * Gets the segment of the frame of the last step.
+     */
+    unsigned int getSegment() const { return _segment; }
+
+    unsigned int getFrameIndex() const { return _frame; }
+
+private:
+    const CameraPath& _path;
+    CameraReplayMode _mode;
+    float _timeStep;
+    unsigned int _frame = 0;
+    unsigned int _segment = 0;
+    size_t _cursor = 0; // first recorded frame ending at or after the sampled time, pose replays only
+    double _cursorTime = 0.0; // time at which the frame before _cursor ended
+};
@@ -0,0 +1,63 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedFile.hpp"
+
+MappedFile::MappedFile(const char * path){
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	_file = file;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size))
+		return;
+	_size = (size_t)size.QuadPart;
+	_isOpen = true;
+	if (_size == 0)
+		return;
+	_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (_mapping != NULL)
+		_data = (const char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+	_isOpen = _data != NULL;
+#else
+	_file = open(path, O_RDONLY);
+	if (_file < 0)
+		return;
+	struct stat info;
+	if (fstat(_file, &info) != 0)
+		return;
+	_size = (size_t)info.st_size;
+	_isOpen = true;
+	if (_size == 0)
+		return;
+	void * data = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+	if (data != MAP_FAILED){
+		_data = (const char*)data;
+		madvise(data, _size, MADV_SEQUENTIAL);
+	}
+	_isOpen = _data != NULL;
+#endif
+}
+
+MappedFile::~MappedFile(){
+#ifdef _WIN32
+	if (_data != NULL)
+		UnmapViewOfFile(_data);
+	if (_mapping != NULL)
+		CloseHandle(_mapping);
+	if (_file != NULL)
+		CloseHandle(_file);
+#else
+	if (_data != NULL)
+		munmap((void*)_data, _size);
+	if (_file >= 0)
+		close(_file);
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+
+// Read-only view of a whole file, mapped into memory (MapViewOfFile / mmap).
+// An empty file is open but has no data.
+class MappedFile
+{
+public:
+	explicit MappedFile(const char * path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return _isOpen; }
+	const char * data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+#ifdef _WIN32
+	void * _file = NULL;    // HANDLEs, kept opaque so that users do not pull in windows.h
+	void * _mapping = NULL;
+#else
+	int _file = -1;
+#endif
+	const char * _data = NULL;
+	size_t _size = 0;
+	bool _isOpen = false;
+};
+
+#endif
@@ -0,0 +1,354 @@
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <cfloat>
+#include <stdio.h>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include "meshCache.hpp"
+#include "mappedFile.hpp"
+#include "objloader.hpp"
+#include "tangentspace.hpp"
+#include "vboindexer.hpp"
+#include "../qtangent.h"
+#include "../glState.h"
+
+namespace {
+
+	struct PlainVertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// same layout as CompactVertex in mesh.h
+	struct QTangentVertex {
+		glm::vec3 position;
+		glm::i16vec4 qtangent;
+		glm::vec2 uv;
+	};
+
+	const uint64_t FNV_OFFSET = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t hashBytes(const char * data, size_t size){
+		uint64_t hash = FNV_OFFSET;
+		for (size_t i = 0; i < size; i++){
+			hash ^= (unsigned char)data[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	uint64_t alignOffset(uint64_t offset){
+		return (offset + COOKED_MESH_ALIGNMENT - 1) / COOKED_MESH_ALIGNMENT * COOKED_MESH_ALIGNMENT;
+	}
+
+	// Size and last write time of a file, false if it does not exist
+	bool getSourceStamp(const char * path, uint64_t & size, int64_t & time){
+		std::error_code error;
+		size = std::filesystem::file_size(path, error);
+		if (error)
+			return false;
+		time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		return !error;
+	}
+
+	bool readHeader(const char * path, CookedMeshHeader & header){
+		std::ifstream file(path, std::ios::binary);
+		if (!file.read((char*)&header, sizeof(header)))
+			return false;
+		return memcmp(header.magic, COOKED_MESH_MAGIC, sizeof(header.magic)) == 0 && header.version == COOKED_MESH_VERSION;
+	}
+
+	// Bytes of one component of an attribute type, 0 for types cooked meshes do not use
+	uint32_t getComponentSize(uint32_t type){
+		switch (type){
+		case GL_FLOAT: return 4;
+		case GL_SHORT: return 2;
+		default: return 0;
+		}
+	}
+
+	// Header fields that must fit the file they were read from
+	bool isConsistent(const CookedMeshHeader & header, size_t fileSize){
+		if (header.attributeCount > COOKED_MESH_MAX_ATTRIBUTES || header.vertexStride == 0)
+			return false;
+		if (!(header.indexType == GL_UNSIGNED_SHORT && header.indexSize == 2)
+			&& !(header.indexType == GL_UNSIGNED_INT && header.indexSize == 4))
+			return false;
+		// every attribute has to lie inside the vertex, so glVertexAttribPointer never reads past it
+		for (uint32_t i = 0; i < header.attributeCount; i++){
+			const CookedAttribute & attribute = header.attributes[i];
+			const uint64_t size = (uint64_t)attribute.components * getComponentSize(attribute.type);
+			if (attribute.components == 0 || attribute.components > 4 || size == 0
+				|| (uint64_t)attribute.offset + size > header.vertexStride)
+				return false;
+		}
+		if (header.vertexBytes != (uint64_t)header.vertexCount * header.vertexStride
+			|| header.indexBytes != (uint64_t)header.indexCount * header.indexSize)
+			return false;
+		if (header.vertexOffset % COOKED_MESH_ALIGNMENT != 0 || header.indexOffset % COOKED_MESH_ALIGNMENT != 0)
+			return false;
+		return header.vertexOffset >= sizeof(CookedMeshHeader)
+			&& header.indexOffset >= header.vertexOffset + header.vertexBytes
+			&& header.indexOffset + header.indexBytes <= fileSize;
+	}
+
+	void setAttribute(CookedMeshHeader & header, uint32_t location, uint32_t components, uint32_t type, bool normalized, size_t offset){
+		CookedAttribute & attribute = header.attributes[header.attributeCount++];
+		attribute.location = location;
+		attribute.components = components;
+		attribute.type = type;
+		attribute.normalized = normalized ? 1 : 0;
+		attribute.offset = (uint32_t)offset;
+	}
+
+	template <typename T>
+	void appendBytes(std::vector<char> & blob, const std::vector<T> & data){
+		const char * bytes = (const char*)data.data();
+		blob.insert(blob.end(), bytes, bytes + data.size() * sizeof(T));
+	}
+
+}
+
+bool cookOBJ(const char * objPath, const char * cookedPath, uint32_t flags){
+	CookedMeshHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, COOKED_MESH_MAGIC, sizeof(header.magic));
+	header.version = COOKED_MESH_VERSION;
+	header.flags = flags;
+
+	{
+		MappedFile source(objPath);
+		if (!source.isOpen()){
+			printf("Impossible to open %s\n", objPath);
+			return false;
+		}
+		header.sourceHash = hashBytes(source.data(), source.size());
+	}
+	if (!getSourceStamp(objPath, header.sourceSize, header.sourceTime))
+		return false;
+
+	std::vector<glm::vec3> corners;
+	std::vector<glm::vec2> cornerUVs;
+	std::vector<glm::vec3> cornerNormals;
+	if (!loadOBJ(objPath, corners, cornerUVs, cornerNormals))
+		return false;
+	if (corners.empty()){
+		printf("%s has no triangles\n", objPath);
+		return false;
+	}
+
+	// weld the triangle corners into indexed vertices
+	std::vector<unsigned int> indices;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> tangents;
+	std::vector<glm::vec3> bitangents;
+	const bool withTangents = (flags & COOKED_MESH_TANGENTS) != 0;
+	if (withTangents){
+		std::vector<glm::vec3> cornerTangents;
+		std::vector<glm::vec3> cornerBitangents;
+		computeTangentBasis(corners, cornerUVs, cornerNormals, cornerTangents, cornerBitangents, 0);
+		indexVBO_TBN(corners, cornerUVs, cornerNormals, cornerTangents, cornerBitangents,
+			indices, positions, uvs, normals, tangents, bitangents, 0);
+	}else{
+		indexVBO(corners, cornerUVs, cornerNormals, indices, positions, uvs, normals, 0);
+	}
+
+	std::vector<unsigned int> remap;
+	optimizeMesh(indices, &positions[0].x, sizeof(glm::vec3), (unsigned int)positions.size(), remap);
+	remapVertices(positions, remap);
+	remapVertices(uvs, remap);
+	remapVertices(normals, remap);
+	remapVertices(tangents, remap);
+	remapVertices(bitangents, remap);
+
+	glm::vec3 boundsMin(FLT_MAX);
+	glm::vec3 boundsMax(-FLT_MAX);
+	for (const glm::vec3 & position : positions){
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+	memcpy(header.boundsMin, &boundsMin.x, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &boundsMax.x, sizeof(header.boundsMax));
+
+	std::vector<char> vertexBlob;
+	if (withTangents){
+		std::vector<QTangentVertex> vertices(positions.size());
+		for (size_t i = 0; i < vertices.size(); i++){
+			vertices[i].position = positions[i];
+			vertices[i].qtangent = packQTangent(encodeQTangent(normals[i], tangents[i], bitangents[i]));
+			vertices[i].uv = uvs[i];
+		}
+		appendBytes(vertexBlob, vertices);
+		header.vertexStride = sizeof(QTangentVertex);
+		setAttribute(header, 0, 3, GL_FLOAT, false, offsetof(QTangentVertex, position));
+		setAttribute(header, 1, 4, GL_SHORT, true, offsetof(QTangentVertex, qtangent));
+		setAttribute(header, 2, 2, GL_FLOAT, false, offsetof(QTangentVertex, uv));
+	}else{
+		std::vector<PlainVertex> vertices(positions.size());
+		for (size_t i = 0; i < vertices.size(); i++){
+			vertices[i].position = positions[i];
+			vertices[i].normal = normals[i];
+			vertices[i].uv = uvs[i];
+		}
+		appendBytes(vertexBlob, vertices);
+		header.vertexStride = sizeof(PlainVertex);
+		setAttribute(header, 0, 3, GL_FLOAT, false, offsetof(PlainVertex, position));
+		setAttribute(header, 1, 3, GL_FLOAT, false, offsetof(PlainVertex, normal));
+		setAttribute(header, 2, 2, GL_FLOAT, false, offsetof(PlainVertex, uv));
+	}
+
+	std::vector<unsigned char> indexBlob;
+	header.indexType = packIndexVBO(indices, positions.size(), indexBlob);
+	header.indexSize = header.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+
+	header.vertexCount = (uint32_t)positions.size();
+	header.indexCount = (uint32_t)indices.size();
+	header.vertexOffset = alignOffset(sizeof(CookedMeshHeader));
+	header.vertexBytes = vertexBlob.size();
+	header.indexOffset = alignOffset(header.vertexOffset + header.vertexBytes);
+	header.indexBytes = indexBlob.size();
+
+	// written aside and renamed, so a failed write never leaves a file that looks valid
+	const std::string tempPath = std::string(cookedPath) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		const std::vector<char> padding(COOKED_MESH_ALIGNMENT, 0);
+		file.write((const char*)&header, sizeof(header));
+		file.write(padding.data(), header.vertexOffset - sizeof(header));
+		file.write(vertexBlob.data(), vertexBlob.size());
+		file.write(padding.data(), header.indexOffset - header.vertexOffset - header.vertexBytes);
+		file.write((const char*)indexBlob.data(), indexBlob.size());
+		if (!file){
+			printf("Impossible to write %s\n", tempPath.c_str());
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, cookedPath, error);
+	if (error){
+		printf("Impossible to write %s : %s\n", cookedPath, error.message().c_str());
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+CookedMesh::CookedMesh(){
+	memset(&_header, 0, sizeof(_header));
+}
+
+CookedMesh::~CookedMesh() = default;
+
+bool CookedMesh::load(const char * objPath, uint32_t flags){
+	const std::string cookedPath = std::string(objPath) + ".cooked";
+	_file.reset(); // a mapped file could not be replaced
+
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!getSourceStamp(objPath, sourceSize, sourceTime))
+		return loadCooked(cookedPath.c_str());
+
+	CookedMeshHeader header;
+	bool upToDate = readHeader(cookedPath.c_str(), header) && header.flags == flags && header.sourceSize == sourceSize;
+	if (upToDate && header.sourceTime != sourceTime){
+		// touched (copied, checked out...) : only a changed content needs a new cook
+		MappedFile source(objPath);
+		upToDate = source.isOpen() && hashBytes(source.data(), source.size()) == header.sourceHash;
+		if (upToDate){
+			// remember the new time, so the next load skips the hash; a file that cannot be updated is cooked
+			// again (which replaces it as a whole) rather than hashed on every load
+			std::fstream file(cookedPath, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(offsetof(CookedMeshHeader, sourceTime));
+			file.write((const char*)&sourceTime, sizeof(sourceTime));
+			file.flush();
+			upToDate = (bool)file;
+		}
+	}
+
+	if (!upToDate){
+		printf("Cooking %s...\n", objPath);
+		if (!cookOBJ(objPath, cookedPath.c_str(), flags))
+			return false;
+	}
+	return loadCooked(cookedPath.c_str());
+}
+
+bool CookedMesh::loadCooked(const char * cookedPath){
+	_file.reset(new MappedFile(cookedPath));
+	if (!_file->isOpen() || _file->size() < sizeof(CookedMeshHeader)){
+		printf("Impossible to open %s\n", cookedPath);
+		_file.reset();
+		return false;
+	}
+	memcpy(&_header, _file->data(), sizeof(_header));
+	if (memcmp(_header.magic, COOKED_MESH_MAGIC, sizeof(_header.magic)) != 0 || _header.version != COOKED_MESH_VERSION
+		|| !isConsistent(_header, _file->size())){
+		printf("%s is not a valid cooked mesh (version %u expected)\n", cookedPath, COOKED_MESH_VERSION);
+		memset(&_header, 0, sizeof(_header));
+		_file.reset();
+		return false;
+	}
+	return true;
+}
+
+const void * CookedMesh::getVertices() const {
+	return _file ? _file->data() + _header.vertexOffset : NULL;
+}
+
+const void * CookedMesh::getIndices() const {
+	return _file ? _file->data() + _header.indexOffset : NULL;
+}
+
+void CookedMesh::upload(){
+	if (!_file)
+		return;
+
+	if (!_vao)
+		_vao = GLVertexArray::create();
+	if (!_buffer)
+		_buffer = GLBuffer::create();
+
+	// vertices and indices sit in the file like they sit in the buffer, so one copy covers both
+	GLState::bindVertexArray(_vao.get());
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _buffer.get());
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(_header.indexOffset + _header.indexBytes - _header.vertexOffset),
+		getVertices(), GL_STATIC_DRAW);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffer.get());
+
+	for (uint32_t i = 0; i < _header.attributeCount; i++){
+		const CookedAttribute & attribute = _header.attributes[i];
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type,
+			attribute.normalized ? GL_TRUE : GL_FALSE, _header.vertexStride, (void*)(uintptr_t)attribute.offset);
+	}
+	GLState::bindVertexArray(0);
+
+	_file.reset();
+}
+
+void CookedMesh::draw() const {
+	if (!_vao)
+		return;
+	GLState::bindVertexArray(_vao.get());
+	glDrawElements(GL_TRIANGLES, _header.indexCount, _header.indexType,
+		(void*)(uintptr_t)(_header.indexOffset - _header.vertexOffset));
+}
+
+void CookedMesh::releaseBuffers(){
+	_vao.reset();
+	_buffer.reset();
+}
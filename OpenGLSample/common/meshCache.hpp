@@ -0,0 +1,108 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <cstdint>
+#include <memory>
+
+#include "../glHandle.h"
+
+class MappedFile;
+
+// Cooked meshes: OBJ files welded, indexed and optimized once, then stored next to the source as "<file>.obj.cooked"
+// in the exact layout the GPU wants. Loading a cooked mesh is a file mapping and one glBufferData.
+//
+// File layout : CookedMeshHeader, then the vertex blob and the index blob, both starting at a multiple of
+// COOKED_MESH_ALIGNMENT so the mapped data can be handed to GL as is. Files are in native byte order, a cook on
+// another platform is simply redone.
+
+const char COOKED_MESH_MAGIC[8] = { 'M', 'E', 'S', 'H', 'C', 'O', 'O', 'K' };
+const uint32_t COOKED_MESH_VERSION = 2;
+const uint32_t COOKED_MESH_ALIGNMENT = 64;
+const uint32_t COOKED_MESH_MAX_ATTRIBUTES = 4;
+
+// Cook options, stored in CookedMeshHeader::flags
+const uint32_t COOKED_MESH_TANGENTS = 1; // tangent frames packed as QTangents (see qtangent.h) instead of normals
+
+// One vertex attribute, as passed to glVertexAttribPointer
+struct CookedAttribute {
+	uint32_t location;
+	uint32_t components;
+	uint32_t type;           // GL_FLOAT or GL_SHORT
+	uint32_t normalized;
+	uint32_t offset;         // bytes from the start of the vertex
+};
+
+struct CookedMeshHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+
+	// source the file was cooked from : size and last write time are checked on every load, the hash only when
+	// they differ (a touched but unchanged file is not cooked again)
+	uint64_t sourceSize;
+	int64_t sourceTime;      // std::filesystem::file_time_type ticks
+	uint64_t sourceHash;     // FNV-1a of the whole file
+
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	uint32_t indexCount;
+	uint32_t indexType;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t indexSize;      // bytes per index
+	uint32_t attributeCount;
+	CookedAttribute attributes[COOKED_MESH_MAX_ATTRIBUTES];
+
+	float boundsMin[3];
+	float boundsMax[3];
+
+	// blobs, in bytes from the start of the file
+	uint64_t vertexOffset;
+	uint64_t vertexBytes;
+	uint64_t indexOffset;
+	uint64_t indexBytes;
+};
+
+static_assert(sizeof(CookedMeshHeader) == 200, "cooked mesh header layout changed, bump COOKED_MESH_VERSION");
+
+// Cooks an OBJ file to cookedPath. Vertices are position / normal / uv floats at attributes 0 / 1 / 2, or with
+// COOKED_MESH_TANGENTS position / QTangent (normalized shorts) / uv floats, as Mesh uses them.
+bool cookOBJ(const char * objPath, const char * cookedPath, uint32_t flags = 0);
+
+// Cooked mesh, drawn with one VAO over one buffer holding vertices then indices.
+class CookedMesh
+{
+public:
+	CookedMesh();
+	~CookedMesh();
+
+	CookedMesh(const CookedMesh&) = delete;
+	CookedMesh& operator=(const CookedMesh&) = delete;
+
+	// Maps "<objPath>.cooked", cooking it first if it is missing, was cooked with other flags or the OBJ changed
+	// since. Without the OBJ, an existing cooked file is used as is.
+	bool load(const char * objPath, uint32_t flags = 0);
+
+	// Maps a cooked file without looking for its source
+	bool loadCooked(const char * cookedPath);
+
+	// Creates the GL objects and uploads the mapped data, then drops the mapping
+	void upload();
+
+	// Draws all triangles with the bound program
+	void draw() const;
+
+	// Deletes the GL objects, must be called while the GL context is alive
+	void releaseBuffers();
+
+	const CookedMeshHeader & getHeader() const { return _header; }
+	// mapped blobs, NULL after upload()
+	const void * getVertices() const;
+	const void * getIndices() const;
+
+private:
+	CookedMeshHeader _header;
+	std::unique_ptr<MappedFile> _file;
+	GLVertexArray _vao;
+	GLBuffer _buffer;
+};
+
+#endif
@@ -2,20 +2,190 @@
 #include <stdio.h>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <thread>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 
 #include "objloader.hpp"
+#include "mappedFile.hpp"
 
-// Very, VERY simple OBJ loader.
-// Here is a short list of features a real function would provide : 
-// - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
-// - Animations & bones (includes bones weights)
-// - Multiple UVs
-// - All attributes should be optional, not "forced"
-// - More stable. Change a line in the OBJ file and it crashes.
-// - More secure. Change another line and you can inject code.
-// - Loading from memory, stream, etc
+// OBJ loader for big files.
+// The file is memory-mapped and cut into line-aligned chunks, which are parsed in parallel (std::from_chars, no
+// locale or token copies). Chunk results are merged afterwards, as indices of a face may refer to attributes
+// defined in any earlier chunk.
+// Supported : v / vt / vn, faces with any number of corners (fanned into triangles), corners as v, v/vt, v//vn or
+// v/vt/vn, negative (relative) indices. Missing UVs become (0,0), missing normals get the flat face normal.
+// Anything else (groups, materials, smoothing, curves) is skipped.
+
+namespace {
+
+	// Face corner attribute indices, 0-based. Relative (negative) indices are turned into positions in the chunk
+	// they were read in, which the merge shifts by the number of attributes defined in the chunks before. Such a
+	// position is negative when the index reaches back into an earlier chunk.
+	const int32_t MISSING_INDEX = INT32_MIN;
+	const uint8_t LOCAL_VERTEX = 1, LOCAL_UV = 2, LOCAL_NORMAL = 4;
+
+	struct Corner {
+		int32_t vertex;
+		int32_t uv;
+		int32_t normal;
+		uint8_t localMask; // LOCAL_* flags of the indices that are chunk positions
+	};
+
+	// What one thread read from its part of the file
+	struct ObjChunk {
+		const char * begin;
+		const char * end;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::vector<Corner> corners; // 3 per triangle
+		size_t firstVertex = 0, firstUv = 0, firstNormal = 0, firstCorner = 0; // offsets in the merged arrays
+		bool failed = false;
+		const char * errorLine = NULL;
+	};
+
+	// Smallest chunk worth a thread of its own
+	const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+	inline const char * skipBlanks(const char * p, const char * end){
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		return p;
+	}
+
+	inline const char * parseFloat(const char * p, const char * end, float & value){
+		p = skipBlanks(p, end);
+		if (p < end && *p == '+') // from_chars does not take an explicit plus sign
+			p++;
+		const std::from_chars_result result = std::from_chars(p, end, value);
+		return result.ec == std::errc() ? result.ptr : NULL;
+	}
+
+	// Reads one attribute index of a face corner, absolute (1-based) or relative (negative)
+	inline const char * parseIndex(const char * p, const char * end, size_t localCount, uint8_t localFlag, Corner & corner, int32_t & index){
+		int32_t value = 0;
+		const std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec != std::errc() || value == 0 || value == MISSING_INDEX)
+			return NULL;
+
+		if (value > 0){
+			index = value - 1;
+		}else{
+			index = (int32_t)localCount + value;
+			corner.localMask |= localFlag;
+		}
+		return result.ptr;
+	}
+
+	void parseChunk(ObjChunk & chunk){
+		std::vector<Corner> face;
+		const char * p = chunk.begin;
+		const char * end = chunk.end;
+		while (p < end){
+			const char * lineEnd = (const char*)memchr(p, '\n', end - p);
+			if (lineEnd == NULL)
+				lineEnd = end;
+			const char * line = p;
+			p = lineEnd + 1;
+
+			const char * q = skipBlanks(line, lineEnd);
+			if (q + 1 >= lineEnd)
+				continue;
+
+			bool ok = true;
+			if (q[0] == 'v' && (q[1] == ' ' || q[1] == '\t')){
+				glm::vec3 vertex;
+				ok = (q = parseFloat(q + 2, lineEnd, vertex.x)) && (q = parseFloat(q, lineEnd, vertex.y)) && (q = parseFloat(q, lineEnd, vertex.z));
+				chunk.vertices.push_back(vertex);
+			}else if (q[0] == 'v' && q[1] == 't' && q + 2 < lineEnd && (q[2] == ' ' || q[2] == '\t')){
+				glm::vec2 uv(0.0f);
+				ok = (q = parseFloat(q + 3, lineEnd, uv.x)) != NULL;
+				if (ok && !parseFloat(q, lineEnd, uv.y)) // 1D texture coordinates leave v at 0
+					uv.y = 0.0f;
+				uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+				chunk.uvs.push_back(uv);
+			}else if (q[0] == 'v' && q[1] == 'n' && q + 2 < lineEnd && (q[2] == ' ' || q[2] == '\t')){
+				glm::vec3 normal;
+				ok = (q = parseFloat(q + 3, lineEnd, normal.x)) && (q = parseFloat(q, lineEnd, normal.y)) && (q = parseFloat(q, lineEnd, normal.z));
+				chunk.normals.push_back(normal);
+			}else if (q[0] == 'f' && (q[1] == ' ' || q[1] == '\t')){
+				face.clear();
+				q = skipBlanks(q + 2, lineEnd);
+				while (ok && q < lineEnd && *q != '\r' && *q != '#'){
+					Corner corner = { MISSING_INDEX, MISSING_INDEX, MISSING_INDEX, 0 };
+					ok = (q = parseIndex(q, lineEnd, chunk.vertices.size(), LOCAL_VERTEX, corner, corner.vertex)) != NULL;
+					if (ok && q < lineEnd && *q == '/'){
+						q++;
+						if (q < lineEnd && *q != '/')
+							ok = (q = parseIndex(q, lineEnd, chunk.uvs.size(), LOCAL_UV, corner, corner.uv)) != NULL;
+						if (ok && q < lineEnd && *q == '/')
+							ok = (q = parseIndex(q + 1, lineEnd, chunk.normals.size(), LOCAL_NORMAL, corner, corner.normal)) != NULL;
+					}
+					face.push_back(corner);
+					if (ok)
+						q = skipBlanks(q, lineEnd);
+				}
+				ok = ok && face.size() >= 3;
+
+				// fan n-gons into triangles
+				for (size_t i = 1; ok && i + 1 < face.size(); i++){
+					chunk.corners.push_back(face[0]);
+					chunk.corners.push_back(face[i]);
+					chunk.corners.push_back(face[i + 1]);
+				}
+			}
+
+			if (!ok){
+				chunk.failed = true;
+				chunk.errorLine = line;
+				return;
+			}
+		}
+	}
+
+	// Index of a corner attribute in the merged array. Missing attributes give MISSING, indices out of the
+	// array give INVALID.
+	const size_t MISSING = (size_t)-1;
+	const size_t INVALID = (size_t)-2;
+
+	inline size_t resolveIndex(int32_t index, bool local, size_t chunkFirst, size_t count){
+		if (index == MISSING_INDEX)
+			return MISSING;
+		const long long global = local ? (long long)chunkFirst + index : index;
+		return global >= 0 && (size_t)global < count ? (size_t)global : INVALID;
+	}
+
+	template <typename T>
+	void gather(std::vector<ObjChunk> & chunks, std::vector<T> ObjChunk::* source, size_t ObjChunk::* first, std::vector<T> & merged){
+		size_t total = 0;
+		for (ObjChunk & chunk : chunks){
+			chunk.*first = total;
+			total += (chunk.*source).size();
+		}
+		merged.resize(total);
+		for (ObjChunk & chunk : chunks){
+			if (!(chunk.*source).empty())
+				memcpy(&merged[chunk.*first], (chunk.*source).data(), (chunk.*source).size() * sizeof(T));
+			std::vector<T>().swap(chunk.*source);
+		}
+	}
+
+	template <typename Function>
+	void forEachChunk(std::vector<ObjChunk> & chunks, Function function){
+		std::vector<std::thread> threads;
+		threads.reserve(chunks.size() - 1);
+		for (size_t i = 1; i < chunks.size(); i++)
+			threads.emplace_back(function, std::ref(chunks[i]));
+		function(chunks[0]);
+		for (std::thread & thread : threads)
+			thread.join();
+	}
+
+} // namespace
 
 bool loadOBJ(
 	const char * path, 
@@ -25,88 +195,101 @@ bool loadOBJ(
 ){
 	printf("Loading OBJ file %s...\n", path);
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices; 
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-
-
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
+	MappedFile file(path);
+	if( !file.isOpen() ){
 		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
 		getchar();
 		return false;
 	}
 
-	while( 1 ){
-
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
-
-		// else : parse lineHeader
-		
-		if ( strcmp( lineHeader, "v" ) == 0 ){
-			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
-			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-				fclose(file);
-				return false;
-			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
+	// Line-aligned chunks, one per hardware thread at most
+	const char * data = file.data();
+	const size_t size = file.size();
+	size_t numChunks = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), size / MIN_CHUNK_BYTES));
+	std::vector<ObjChunk> chunks(numChunks);
+	const char * begin = data;
+	for (size_t i = 0; i < numChunks; i++){
+		const char * end = data + size * (i + 1) / numChunks;
+		if (i + 1 < numChunks){
+			const char * newline = end > begin ? (const char*)memchr(end, '\n', data + size - end) : NULL;
+			end = newline != NULL ? newline + 1 : data + size;
 		}
+		chunks[i].begin = begin;
+		chunks[i].end = std::max(begin, end);
+		begin = chunks[i].end;
+	}
 
+	forEachChunk(chunks, parseChunk);
+	for (const ObjChunk & chunk : chunks){
+		if (chunk.failed){
+			const char * lineEnd = (const char*)memchr(chunk.errorLine, '\n', chunk.end - chunk.errorLine);
+			const std::string line(chunk.errorLine, lineEnd != NULL ? lineEnd : chunk.end);
+			printf("File can't be read by our OBJ parser :-( Unsupported or broken line: %s\n", line.c_str());
+			return false;
+		}
 	}
 
-	// For each vertex of each triangle
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-		
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
-		
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
-	
+	// Merge attributes, then every chunk expands its own triangles straight into the output
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	gather(chunks, &ObjChunk::vertices, &ObjChunk::firstVertex, vertices);
+	gather(chunks, &ObjChunk::uvs, &ObjChunk::firstUv, uvs);
+	gather(chunks, &ObjChunk::normals, &ObjChunk::firstNormal, normals);
+
+	size_t numCorners = out_vertices.size();
+	for (ObjChunk & chunk : chunks){
+		chunk.firstCorner = numCorners;
+		numCorners += chunk.corners.size();
+	}
+	out_vertices.resize(numCorners);
+	out_uvs.resize(numCorners);
+	out_normals.resize(numCorners);
+
+	forEachChunk(chunks, [&](ObjChunk & chunk){
+		for (size_t i = 0; i < chunk.corners.size(); i += 3){
+			const size_t out = chunk.firstCorner + i;
+			bool missingNormal = false;
+			for (size_t k = 0; k < 3; k++){
+				const Corner & corner = chunk.corners[i + k];
+				const size_t vertexIndex = resolveIndex(corner.vertex, (corner.localMask & LOCAL_VERTEX) != 0, chunk.firstVertex, vertices.size());
+				const size_t uvIndex = resolveIndex(corner.uv, (corner.localMask & LOCAL_UV) != 0, chunk.firstUv, uvs.size());
+				const size_t normalIndex = resolveIndex(corner.normal, (corner.localMask & LOCAL_NORMAL) != 0, chunk.firstNormal, normals.size());
+				if (vertexIndex >= INVALID || uvIndex == INVALID || normalIndex == INVALID){
+					chunk.failed = true;
+					return;
+				}
+
+				out_vertices[out + k] = vertices[vertexIndex];
+				out_uvs[out + k] = uvIndex != MISSING ? uvs[uvIndex] : glm::vec2(0.0f);
+				if (normalIndex != MISSING)
+					out_normals[out + k] = normals[normalIndex];
+				else
+					missingNormal = true;
+			}
+
+			if (missingNormal){
+				const glm::vec3 faceNormal = glm::cross(out_vertices[out + 1] - out_vertices[out], out_vertices[out + 2] - out_vertices[out]);
+				const float length = glm::length(faceNormal);
+				const glm::vec3 normal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+				for (size_t k = 0; k < 3; k++){
+					if (chunk.corners[i + k].normal == MISSING_INDEX)
+						out_normals[out + k] = normal;
+				}
+			}
+		}
+	});
+
+	for (const ObjChunk & chunk : chunks){
+		if (chunk.failed){
+			printf("File can't be read by our OBJ parser :-( A face refers to an attribute that does not exist\n");
+			out_vertices.resize(chunks[0].firstCorner);
+			out_uvs.resize(chunks[0].firstCorner);
+			out_normals.resize(chunks[0].firstCorner);
+			return false;
+		}
 	}
-	fclose(file);
+
 	return true;
 }
 
@@ -0,0 +1,165 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+// expects the OpenGL loader (glad or GLEW) to be included before this header
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+
+// Stores linked program binaries (glGetProgramBinary) on disk, so later launches
+// can skip compiling and linking GLSL from source.
+// Cache files are keyed by a hash of everything that affects the linked result:
+// the full shader source text, the injected defines and the driver strings.
+class ProgramCache
+{
+public:
+	// builds the cache key for a program made from the given sources
+	// ------------------------------------------------------------------------
+	static std::string makeKey(const std::vector<std::string>& sources, const std::string& defines = "")
+	{
+		uint64_t hash = FNV_OFFSET;
+		for (const auto& source : sources)
+			hash = hashString(hash, source);
+		hash = hashString(hash, defines);
+		hash = hashString(hash, glString(GL_VENDOR));
+		hash = hashString(hash, glString(GL_RENDERER));
+		hash = hashString(hash, glString(GL_VERSION));
+
+		std::stringstream key;
+		key << std::hex << std::setw(16) << std::setfill('0') << hash;
+		return key.str();
+	}
+	// true, if the driver can hand out program binaries at all
+	// ------------------------------------------------------------------------
+	static bool isSupported()
+	{
+		if (glGetProgramBinary == nullptr || glProgramBinary == nullptr)
+			return false;
+		GLint numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		return numFormats > 0;
+	}
+	// must be called before glLinkProgram, otherwise some drivers refuse to return the binary
+	// ------------------------------------------------------------------------
+	static void prepareForLink(GLuint program)
+	{
+		if (isSupported())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	// restores a program from the cache; returns false if there is no usable binary
+	// and the caller has to compile from source (a rejected binary is removed from disk)
+	// ------------------------------------------------------------------------
+	static bool load(const std::string& key, GLuint program)
+	{
+		if (!isSupported())
+			return false;
+
+		std::ifstream file(cachePath(key), std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		Header header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+		if (!file || header.magic != MAGIC || header.version != VERSION || header.length <= 0)
+			return false;
+
+		std::vector<char> binary(header.length);
+		file.read(binary.data(), header.length);
+		if (!file)
+			return false;
+		file.close();
+
+		glProgramBinary(program, header.format, binary.data(), header.length);
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			// driver update or a different GPU; drop the stale entry and rebuild it
+			std::remove(cachePath(key).c_str());
+			return false;
+		}
+		return true;
+	}
+	// writes the binary of a successfully linked program to the cache
+	// ------------------------------------------------------------------------
+	static void store(const std::string& key, GLuint program)
+	{
+		if (!isSupported())
+			return;
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+			return;
+
+		Header header;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+		if (header.length <= 0)
+			return;
+
+		std::vector<char> binary(header.length);
+		glGetProgramBinary(program, header.length, nullptr, &header.format, binary.data());
+
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_DIRECTORY, error);
+		std::ofstream file(cachePath(key), std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::PROGRAM_CACHE::FILE_NOT_WRITABLE " << cachePath(key) << std::endl;
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(binary.data(), header.length);
+	}
+
+private:
+	static constexpr const char* CACHE_DIRECTORY = "shadercache";
+	static constexpr uint32_t MAGIC = 0x50474c42; // "BLGP"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	struct Header
+	{
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		GLenum format = 0;
+		GLint length = 0;
+	};
+
+	static std::string cachePath(const std::string& key)
+	{
+		return std::string(CACHE_DIRECTORY) + "/" + key + ".bin";
+	}
+
+	static std::string glString(GLenum name)
+	{
+		const GLubyte* value = glGetString(name);
+		return value ? reinterpret_cast<const char*>(value) : "";
+	}
+
+	// 64 bit FNV-1a, the length is mixed in so that ("ab", "c") and ("a", "bc") differ
+	static uint64_t hashString(uint64_t hash, const std::string& text)
+	{
+		for (unsigned char c : text)
+		{
+			hash ^= c;
+			hash *= FNV_PRIME;
+		}
+		uint64_t length = text.size();
+		for (int i = 0; i < 8; i++)
+		{
+			hash ^= (length >> (i * 8)) & 0xff;
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+};
+#endif
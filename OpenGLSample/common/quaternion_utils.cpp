@@ -5,6 +5,7 @@
 using namespace glm;
 
 #include "quaternion_utils.hpp"
+#include "simdLanes.hpp"
 
 
 // Returns a quaternion such that q*start = dest
@@ -98,7 +99,8 @@ quat RotateTowards(quat q1, quat q2, float maxAngle){
 		cosTheta *= -1.0f;
 	}
 	
-	float angle = acos(cosTheta);
+	// (q2 = -q1 can round cosTheta above 1)
+	float angle = acos(min(cosTheta, 1.0f));
 	
 	// If there is only a 2 difference, and we are allowed 5,
 	// then we arrived.
@@ -108,7 +110,6 @@ quat RotateTowards(quat q1, quat q2, float maxAngle){
 
 	// This is just like slerp(), but with a custom t
 	float t = maxAngle / angle;
-	angle = maxAngle;
 	
 	quat res = (sin((1.0f - t) * angle) * q1 + sin(t * angle) * q2) / sin(angle);
 	res = normalize(res);
@@ -118,6 +119,331 @@ quat RotateTowards(quat q1, quat q2, float maxAngle){
 
 
 
+// SIMD versions. Single quaternions keep x, y, z, w in the 4 lanes of an SSE register; batches keep one
+// component per register, one quaternion per lane (see simdLanes.hpp), and branches become selects.
+
+namespace {
+
+	using namespace simd;
+
+	// acos(x) for x in [0, 1], absolute error below 2e-8 (Abramowitz & Stegun 4.4.46)
+	template <typename F>
+	F acosPositive(F x){
+		F p = splat<F>(-0.0012624911f);
+		p = p * x + splat<F>(0.0066700901f);
+		p = p * x + splat<F>(-0.0170881256f);
+		p = p * x + splat<F>(0.0308918810f);
+		p = p * x + splat<F>(-0.0501743046f);
+		p = p * x + splat<F>(0.0889789874f);
+		p = p * x + splat<F>(-0.2145988016f);
+		p = p * x + splat<F>(1.5707963050f);
+		return sqrt(splat<F>(1.0f) - x) * p;
+	}
+
+	// sin(x) for x in [0, pi/2] : Taylor series up to x^11, error below 1e-7
+	template <typename F>
+	F sinQuarter(F x){
+		const F x2 = x * x;
+		F p = splat<F>(-1.0f / 39916800.0f);
+		p = p * x2 + splat<F>(1.0f / 362880.0f);
+		p = p * x2 + splat<F>(-1.0f / 5040.0f);
+		p = p * x2 + splat<F>(1.0f / 120.0f);
+		p = p * x2 + splat<F>(-1.0f / 6.0f);
+		p = p * x2 + splat<F>(1.0f);
+		return p * x;
+	}
+
+	// Above this cosine, slerp falls back to nlerp : sin(angle) is too small to divide by
+	const float SLERP_NLERP_COSINE = 0.9995f;
+
+	template <typename F>
+	struct Quat {
+		F x, y, z, w;
+
+		static Quat load(const QuatStream & s, size_t i){
+			return { F::load(&s.x[i]), F::load(&s.y[i]), F::load(&s.z[i]), F::load(&s.w[i]) };
+		}
+		void store(QuatStream & s, size_t i) const {
+			x.store(&s.x[i]); y.store(&s.y[i]); z.store(&s.z[i]); w.store(&s.w[i]);
+		}
+	};
+
+	template <typename F>
+	Vec3<F> loadVec3(const Vec3Stream & s, size_t i){
+		return { F::load(&s.x[i]), F::load(&s.y[i]), F::load(&s.z[i]) };
+	}
+
+	template <typename F>
+	F dot(const Quat<F> & a, const Quat<F> & b){
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	// a * wa + b * wb
+	template <typename F>
+	Quat<F> combine(const Quat<F> & a, F wa, const Quat<F> & b, F wb){
+		return { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+	}
+
+	template <typename F>
+	Quat<F> select(F mask, const Quat<F> & a, const Quat<F> & b){
+		return { select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z), select(mask, a.w, b.w) };
+	}
+
+	template <typename F>
+	Quat<F> negateIfNegative(const Quat<F> & q, F test){
+		return { negateIfNegative(q.x, test), negateIfNegative(q.y, test), negateIfNegative(q.z, test), negateIfNegative(q.w, test) };
+	}
+
+	template <typename F>
+	Quat<F> normalize(const Quat<F> & q){
+		const F inverseLength = splat<F>(1.0f) / sqrt(dot(q, q));
+		return { q.x * inverseLength, q.y * inverseLength, q.z * inverseLength, q.w * inverseLength };
+	}
+
+	template <typename F>
+	Quat<F> multiply(const Quat<F> & a, const Quat<F> & b){
+		return {
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		};
+	}
+
+	// v + 2w (u x v) + 2 u x (u x v), u the vector part of q
+	template <typename F>
+	Vec3<F> rotate(const Quat<F> & q, const Vec3<F> & v){
+		const Vec3<F> u = { q.x, q.y, q.z };
+		const Vec3<F> t = cross(u, v) * splat<F>(2.0f);
+		return v + t * q.w + cross(u, t);
+	}
+
+	// Weights of a and b in slerp(a, b, t), b already on the side of a. cosTheta in [0, 1], t in [0, 1]
+	template <typename F>
+	void slerpWeights(F cosTheta, F t, F & wa, F & wb){
+		const F one = splat<F>(1.0f);
+		const F angle = acosPositive(min(cosTheta, one));
+		const F inverseSin = one / sqrt(max(one - cosTheta * cosTheta, splat<F>(1e-12f)));
+		const F near = greaterThan(cosTheta, splat<F>(SLERP_NLERP_COSINE));
+		wa = select(near, one - t, sinQuarter((one - t) * angle) * inverseSin);
+		wb = select(near, t, sinQuarter(t * angle) * inverseSin);
+	}
+
+	template <typename F>
+	Quat<F> slerp(const Quat<F> & a, const Quat<F> & b, F t){
+		const F cosTheta = dot(a, b);
+		F wa, wb;
+		slerpWeights(abs(cosTheta), t, wa, wb);
+		return normalize(combine(a, wa, negateIfNegative(b, cosTheta), wb));
+	}
+
+	// Same steps as the scalar RotateTowards, every branch computed and selected
+	template <typename F>
+	Quat<F> rotateTowards(const Quat<F> & q1, const Quat<F> & q2, F maxAngle){
+		const F one = splat<F>(1.0f);
+		const F cosTheta = dot(q1, q2);
+		const Quat<F> from = negateIfNegative(q1, cosTheta);
+		const F cosAbs = min(abs(cosTheta), one);
+		const F angle = acosPositive(cosAbs);
+
+		// t = maxAngle / angle, kept finite in the lanes that return q1 or q2
+		const F t = min(maxAngle / max(angle, splat<F>(1e-6f)), one);
+		const F inverseSin = one / sqrt(max(one - cosAbs * cosAbs, splat<F>(1e-12f)));
+		const F w1 = sinQuarter((one - t) * angle) * inverseSin;
+		const F w2 = sinQuarter(t * angle) * inverseSin;
+		const Quat<F> res = normalize(combine(from, w1, q2, w2));
+
+		const F returnQ1 = lessThan(maxAngle, splat<F>(0.001f));
+		const F returnQ2 = greaterThan(cosTheta, splat<F>(0.9999f)) | lessThan(angle, maxAngle);
+		return select(returnQ1, q1, select(returnQ2, q2, res));
+	}
+
+	template <typename F>
+	Quat<F> fromQuat(const quat & q){
+		return { splat<F>(q.x), splat<F>(q.y), splat<F>(q.z), splat<F>(q.w) };
+	}
+
+#ifdef SIMD_LANES_SSE
+	// x, y, z, w in lanes 0 to 3 ; the components are read one by one, whatever glm's storage order
+	__m128 load4(const quat & q){ return _mm_setr_ps(q.x, q.y, q.z, q.w); }
+	quat toQuat(__m128 v){
+		float f[4];
+		_mm_storeu_ps(f, v);
+		return quat(f[3], f[0], f[1], f[2]);
+	}
+
+	template <int I>
+	__m128 lane(__m128 v){ return _mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I)); }
+
+	// 4 component dot product, in every lane
+	__m128 dot4(__m128 a, __m128 b){
+		__m128 m = _mm_mul_ps(a, b);
+		m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+
+	// cross product of the x, y, z lanes ; w is 0 when it is equal in a and b
+	__m128 cross4(__m128 a, __m128 b){
+		const __m128 c = _mm_sub_ps(
+			_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))),
+			_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	__m128 normalize4(__m128 q){ return _mm_div_ps(q, _mm_sqrt_ps(dot4(q, q))); }
+#endif
+
+} // namespace
+
+
+quat QuatMultiply(const quat & a, const quat & b){
+#ifdef SIMD_LANES_SSE
+	const __m128 va = load4(a), vb = load4(b);
+	__m128 r = _mm_mul_ps(lane<3>(va), vb);
+	r = _mm_add_ps(r, _mm_mul_ps(lane<0>(va),
+		_mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(0, 1, 2, 3)), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f))));
+	r = _mm_add_ps(r, _mm_mul_ps(lane<1>(va),
+		_mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(1, 0, 3, 2)), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f))));
+	r = _mm_add_ps(r, _mm_mul_ps(lane<2>(va),
+		_mm_xor_ps(_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 3, 0, 1)), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f))));
+	return toQuat(r);
+#else
+	return a * b;
+#endif
+}
+
+vec3 QuatRotate(const quat & q, const vec3 & v){
+#ifdef SIMD_LANES_SSE
+	const __m128 vq = load4(q);
+	const __m128 vv = _mm_setr_ps(v.x, v.y, v.z, 0.0f);
+	const __m128 t = _mm_add_ps(cross4(vq, vv), cross4(vq, vv));
+	const __m128 r = _mm_add_ps(_mm_add_ps(vv, _mm_mul_ps(lane<3>(vq), t)), cross4(vq, t));
+	float f[4];
+	_mm_storeu_ps(f, r);
+	return vec3(f[0], f[1], f[2]);
+#else
+	return q * v;
+#endif
+}
+
+quat QuatNormalize(const quat & q){
+#ifdef SIMD_LANES_SSE
+	return toQuat(normalize4(load4(q)));
+#else
+	return normalize(q);
+#endif
+}
+
+quat QuatNlerp(const quat & a, const quat & b, float t){
+#ifdef SIMD_LANES_SSE
+	const __m128 va = load4(a), vb = load4(b);
+	// flip b by the sign of the dot product, for the shortest path
+	const __m128 sign = _mm_and_ps(dot4(va, vb), _mm_set1_ps(-0.0f));
+	const __m128 r = _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(vb, sign), va), _mm_set1_ps(t)));
+	return toQuat(normalize4(r));
+#else
+	const quat r = dot(a, b) < 0.0f ? -b : b;
+	return normalize(a + (r - a) * t);
+#endif
+}
+
+quat QuatSlerp(const quat & a, const quat & b, float t){
+#ifdef SIMD_LANES_SSE
+	const __m128 va = load4(a), vb = load4(b);
+	const __m128 cosTheta = dot4(va, vb);
+	Float1 wa, wb;
+	slerpWeights(abs(Float1{ _mm_cvtss_f32(cosTheta) }), Float1{ t }, wa, wb);
+	const __m128 sign = _mm_and_ps(cosTheta, _mm_set1_ps(-0.0f));
+	const __m128 r = _mm_add_ps(_mm_mul_ps(va, _mm_set1_ps(wa.v)), _mm_mul_ps(_mm_xor_ps(vb, sign), _mm_set1_ps(wb.v)));
+	return toQuat(normalize4(r));
+#else
+	const Quat<Float1> r = slerp(fromQuat<Float1>(a), fromQuat<Float1>(b), Float1{ t });
+	return quat(r.w.v, r.x.v, r.y.v, r.z.v);
+#endif
+}
+
+
+void QuatMultiply(const QuatStream & a, const QuatStream & b, QuatStream & out){
+	const size_t count = a.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		multiply(Quat<F>::load(a, i), Quat<F>::load(b, i)).store(out, i);
+	});
+}
+
+void QuatRotate(const QuatStream & q, const Vec3Stream & v, Vec3Stream & out){
+	const size_t count = q.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		const Vec3<F> r = rotate(Quat<F>::load(q, i), loadVec3<F>(v, i));
+		r.x.store(&out.x[i]);
+		r.y.store(&out.y[i]);
+		r.z.store(&out.z[i]);
+	});
+}
+
+void QuatNormalize(const QuatStream & q, QuatStream & out){
+	const size_t count = q.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		normalize(Quat<F>::load(q, i)).store(out, i);
+	});
+}
+
+void QuatNlerp(const QuatStream & a, const QuatStream & b, float t, QuatStream & out){
+	const size_t count = a.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		const Quat<F> qa = Quat<F>::load(a, i);
+		const Quat<F> qb = Quat<F>::load(b, i);
+		const F weight = splat<F>(t);
+		const Quat<F> r = combine(qa, splat<F>(1.0f) - weight, negateIfNegative(qb, dot(qa, qb)), weight);
+		normalize(r).store(out, i);
+	});
+}
+
+void QuatSlerp(const QuatStream & a, const QuatStream & b, float t, QuatStream & out){
+	const size_t count = a.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		slerp(Quat<F>::load(a, i), Quat<F>::load(b, i), splat<F>(t)).store(out, i);
+	});
+}
+
+void QuatSlerp(const QuatStream & a, const QuatStream & b, const std::vector<float> & t, QuatStream & out){
+	const size_t count = a.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		slerp(Quat<F>::load(a, i), Quat<F>::load(b, i), F::load(&t[i])).store(out, i);
+	});
+}
+
+void RotateTowards(const QuatStream & from, const QuatStream & to, float maxAngle, QuatStream & out){
+	const size_t count = from.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		rotateTowards(Quat<F>::load(from, i), Quat<F>::load(to, i), splat<F>(maxAngle)).store(out, i);
+	});
+}
+
+void RotateTowards(const QuatStream & from, const QuatStream & to, const std::vector<float> & maxAngles, QuatStream & out){
+	const size_t count = from.size();
+	out.resize(count);
+	forEachBatch(0, count, [&](auto lanes, size_t i){
+		typedef decltype(lanes) F;
+		rotateTowards(Quat<F>::load(from, i), Quat<F>::load(to, i), F::load(&maxAngles[i])).store(out, i);
+	});
+}
+
+
+
 
 
 
@@ -1,11 +1,62 @@
 #ifndef QUATERNION_UTILS_H
 #define QUATERNION_UTILS_H
 
-quat RotationBetweenVectors(vec3 start, vec3 dest);
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
-quat LookAt(vec3 direction, vec3 desiredUp);
+glm::quat RotationBetweenVectors(glm::vec3 start, glm::vec3 dest);
 
-quat RotateTowards(quat q1, quat q2, float maxAngle);
+glm::quat LookAt(glm::vec3 direction, glm::vec3 desiredUp);
 
+glm::quat RotateTowards(glm::quat q1, glm::quat q2, float maxAngle);
 
-#endif // QUATERNION_UTILS_H
\ No newline at end of file
+
+// Single quaternions, with SSE when the compiler targets it (glm's own SIMD path only covers a few operations).
+// Quaternions are loaded unaligned : glm::quat is only 4 bytes aligned, aligned ones load just as fast.
+glm::quat QuatMultiply(const glm::quat & a, const glm::quat & b); // a * b
+glm::vec3 QuatRotate(const glm::quat & q, const glm::vec3 & v);   // q * v, q unit length
+glm::quat QuatNormalize(const glm::quat & q);
+// Shortest path interpolations between unit quaternions, t in [0, 1]. Nlerp is normalized lerp : cheaper, but
+// its angular speed is not constant.
+glm::quat QuatNlerp(const glm::quat & a, const glm::quat & b, float t);
+glm::quat QuatSlerp(const glm::quat & a, const glm::quat & b, float t);
+
+
+// Quaternions in structure of arrays : element i is quat(w[i], x[i], y[i], z[i]). The functions below run on
+// 8 (AVX) or 4 (SSE2) elements at a time, the remainder one by one.
+struct QuatStream {
+	std::vector<float> x, y, z, w;
+
+	QuatStream(size_t count = 0){ resize(count); }
+	size_t size() const { return x.size(); }
+	void resize(size_t count){ x.resize(count); y.resize(count); z.resize(count); w.resize(count, 1.0f); }
+	glm::quat get(size_t i) const { return glm::quat(w[i], x[i], y[i], z[i]); }
+	void set(size_t i, const glm::quat & q){ x[i] = q.x; y[i] = q.y; z[i] = q.z; w[i] = q.w; }
+};
+
+struct Vec3Stream {
+	std::vector<float> x, y, z;
+
+	Vec3Stream(size_t count = 0){ resize(count); }
+	size_t size() const { return x.size(); }
+	void resize(size_t count){ x.resize(count); y.resize(count); z.resize(count); }
+	glm::vec3 get(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+	void set(size_t i, const glm::vec3 & v){ x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+};
+
+// Outputs are resized to the size of the first input, other inputs must be at least as long. Outputs may be
+// the inputs.
+void QuatMultiply(const QuatStream & a, const QuatStream & b, QuatStream & out);
+void QuatRotate(const QuatStream & q, const Vec3Stream & v, Vec3Stream & out);
+void QuatNormalize(const QuatStream & q, QuatStream & out);
+void QuatNlerp(const QuatStream & a, const QuatStream & b, float t, QuatStream & out);
+void QuatSlerp(const QuatStream & a, const QuatStream & b, float t, QuatStream & out);
+void QuatSlerp(const QuatStream & a, const QuatStream & b, const std::vector<float> & t, QuatStream & out);
+
+// RotateTowards on every element : e.g. turns objects towards their targets at maxAngle radians per frame
+void RotateTowards(const QuatStream & from, const QuatStream & to, float maxAngle, QuatStream & out);
+void RotateTowards(const QuatStream & from, const QuatStream & to, const std::vector<float> & maxAngles, QuatStream & out);
+
+
+#endif // QUATERNION_UTILS_H
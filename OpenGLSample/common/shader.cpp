@@ -13,6 +13,7 @@ using namespace std;
 #include <GL/glew.h>
 
 #include "shader.hpp"
+#include "programCache.h"
 
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
 
@@ -44,6 +45,15 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		FragmentShaderStream.close();
 	}
 
+	// Reuse the program binary from a previous launch if the driver accepts it
+	GLuint ProgramID = glCreateProgram();
+	std::string CacheKey = ProgramCache::makeKey({ VertexShaderCode, FragmentShaderCode });
+	if ( ProgramCache::load(CacheKey, ProgramID) ){
+		glDeleteShader(VertexShaderID);
+		glDeleteShader(FragmentShaderID);
+		return ProgramID;
+	}
+
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
@@ -84,9 +94,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 
 	// Link the program
 	printf("Linking program\n");
-	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	ProgramCache::prepareForLink(ProgramID);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -105,6 +115,8 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	ProgramCache::store(CacheKey, ProgramID);
+
 	return ProgramID;
 }
 
@@ -0,0 +1,156 @@
+#ifndef SIMDLANES_HPP
+#define SIMDLANES_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_LANES_SSE 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define SIMD_LANES_AVX 1
+#include <immintrin.h>
+#endif
+
+// Float lanes for SoA batches : the same templated code runs on 8 (AVX, when the compiler targets it), 4 (SSE2) or
+// 1 floats, forEachBatch runs full batches on the widest lanes and the remainder on the scalar ones.
+// Comparisons return masks (all bits set where true) for select, and for | and & between masks.
+
+namespace simd {
+
+	struct Float1 {
+		static const int WIDTH = 1;
+		float v;
+
+		static Float1 load(const float * p){ return { *p }; }
+		void store(float * p) const { *p = v; }
+		friend Float1 operator+(Float1 a, Float1 b){ return { a.v + b.v }; }
+		friend Float1 operator-(Float1 a, Float1 b){ return { a.v - b.v }; }
+		friend Float1 operator*(Float1 a, Float1 b){ return { a.v * b.v }; }
+		friend Float1 operator/(Float1 a, Float1 b){ return { a.v / b.v }; }
+		friend Float1 sqrt(Float1 a){ return { std::sqrt(a.v) }; }
+		friend Float1 abs(Float1 a){ return { std::fabs(a.v) }; }
+		friend Float1 min(Float1 a, Float1 b){ return { std::min(a.v, b.v) }; }
+		friend Float1 max(Float1 a, Float1 b){ return { std::max(a.v, b.v) }; }
+		// -value where test < 0
+		friend Float1 negateIfNegative(Float1 value, Float1 test){ return { test.v < 0.0f ? value.v * -1.0f : value.v }; }
+
+		friend Float1 lessThan(Float1 a, Float1 b){ return mask(a.v < b.v); }
+		friend Float1 greaterThan(Float1 a, Float1 b){ return mask(a.v > b.v); }
+		friend Float1 operator|(Float1 a, Float1 b){ return { fromBits(bits(a.v) | bits(b.v)) }; }
+		friend Float1 operator&(Float1 a, Float1 b){ return { fromBits(bits(a.v) & bits(b.v)) }; }
+		// a where mask, b elsewhere
+		friend Float1 select(Float1 mask, Float1 a, Float1 b){ return bits(mask.v) != 0 ? a : b; }
+
+	private:
+		static uint32_t bits(float f){ uint32_t b; std::memcpy(&b, &f, sizeof(b)); return b; }
+		static float fromBits(uint32_t b){ float f; std::memcpy(&f, &b, sizeof(f)); return f; }
+		static Float1 mask(bool test){ return { fromBits(test ? ~0u : 0u) }; }
+	};
+
+#ifdef SIMD_LANES_SSE
+	struct Float4 {
+		static const int WIDTH = 4;
+		__m128 v;
+
+		static Float4 load(const float * p){ return { _mm_loadu_ps(p) }; }
+		void store(float * p) const { _mm_storeu_ps(p, v); }
+		friend Float4 operator+(Float4 a, Float4 b){ return { _mm_add_ps(a.v, b.v) }; }
+		friend Float4 operator-(Float4 a, Float4 b){ return { _mm_sub_ps(a.v, b.v) }; }
+		friend Float4 operator*(Float4 a, Float4 b){ return { _mm_mul_ps(a.v, b.v) }; }
+		friend Float4 operator/(Float4 a, Float4 b){ return { _mm_div_ps(a.v, b.v) }; }
+		friend Float4 sqrt(Float4 a){ return { _mm_sqrt_ps(a.v) }; }
+		friend Float4 abs(Float4 a){ return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+		friend Float4 min(Float4 a, Float4 b){ return { _mm_min_ps(a.v, b.v) }; }
+		friend Float4 max(Float4 a, Float4 b){ return { _mm_max_ps(a.v, b.v) }; }
+		friend Float4 negateIfNegative(Float4 value, Float4 test){
+			const __m128 negative = _mm_cmplt_ps(test.v, _mm_setzero_ps());
+			return { _mm_xor_ps(value.v, _mm_and_ps(negative, _mm_set1_ps(-0.0f))) };
+		}
+
+		friend Float4 lessThan(Float4 a, Float4 b){ return { _mm_cmplt_ps(a.v, b.v) }; }
+		friend Float4 greaterThan(Float4 a, Float4 b){ return { _mm_cmpgt_ps(a.v, b.v) }; }
+		friend Float4 operator|(Float4 a, Float4 b){ return { _mm_or_ps(a.v, b.v) }; }
+		friend Float4 operator&(Float4 a, Float4 b){ return { _mm_and_ps(a.v, b.v) }; }
+		friend Float4 select(Float4 mask, Float4 a, Float4 b){
+			return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+		}
+	};
+#endif
+
+#ifdef SIMD_LANES_AVX
+	struct Float8 {
+		static const int WIDTH = 8;
+		__m256 v;
+
+		static Float8 load(const float * p){ return { _mm256_loadu_ps(p) }; }
+		void store(float * p) const { _mm256_storeu_ps(p, v); }
+		friend Float8 operator+(Float8 a, Float8 b){ return { _mm256_add_ps(a.v, b.v) }; }
+		friend Float8 operator-(Float8 a, Float8 b){ return { _mm256_sub_ps(a.v, b.v) }; }
+		friend Float8 operator*(Float8 a, Float8 b){ return { _mm256_mul_ps(a.v, b.v) }; }
+		friend Float8 operator/(Float8 a, Float8 b){ return { _mm256_div_ps(a.v, b.v) }; }
+		friend Float8 sqrt(Float8 a){ return { _mm256_sqrt_ps(a.v) }; }
+		friend Float8 abs(Float8 a){ return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+		friend Float8 min(Float8 a, Float8 b){ return { _mm256_min_ps(a.v, b.v) }; }
+		friend Float8 max(Float8 a, Float8 b){ return { _mm256_max_ps(a.v, b.v) }; }
+		friend Float8 negateIfNegative(Float8 value, Float8 test){
+			const __m256 negative = _mm256_cmp_ps(test.v, _mm256_setzero_ps(), _CMP_LT_OQ);
+			return { _mm256_xor_ps(value.v, _mm256_and_ps(negative, _mm256_set1_ps(-0.0f))) };
+		}
+
+		friend Float8 lessThan(Float8 a, Float8 b){ return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+		friend Float8 greaterThan(Float8 a, Float8 b){ return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+		friend Float8 operator|(Float8 a, Float8 b){ return { _mm256_or_ps(a.v, b.v) }; }
+		friend Float8 operator&(Float8 a, Float8 b){ return { _mm256_and_ps(a.v, b.v) }; }
+		friend Float8 select(Float8 mask, Float8 a, Float8 b){ return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+	};
+#endif
+
+	template <typename F>
+	F splat(float value){
+		float values[F::WIDTH];
+		std::fill(values, values + F::WIDTH, value);
+		return F::load(values);
+	}
+
+	template <typename F>
+	struct Vec3 {
+		F x, y, z;
+
+		friend Vec3 operator+(const Vec3 & a, const Vec3 & b){ return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		friend Vec3 operator-(const Vec3 & a, const Vec3 & b){ return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		friend Vec3 operator*(const Vec3 & a, F s){ return { a.x * s, a.y * s, a.z * s }; }
+	};
+
+	template <typename F>
+	F dot(const Vec3<F> & a, const Vec3<F> & b){
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	template <typename F>
+	Vec3<F> cross(const Vec3<F> & a, const Vec3<F> & b){
+		return { a.y * b.z - b.y * a.z, a.z * b.x - b.z * a.x, a.x * b.y - b.x * a.y };
+	}
+
+	// Calls function(F(), i) over [begin, end) : widest lanes first, scalar for the remainder
+	template <typename Function>
+	void forEachBatch(size_t begin, size_t end, Function function){
+		size_t i = begin;
+#ifdef SIMD_LANES_AVX
+		for (; i + Float8::WIDTH <= end; i += Float8::WIDTH)
+			function(Float8(), i);
+#endif
+#ifdef SIMD_LANES_SSE
+		for (; i + Float4::WIDTH <= end; i += Float4::WIDTH)
+			function(Float4(), i);
+#endif
+		for (; i < end; i++)
+			function(Float1(), i);
+	}
+
+} // namespace simd
+
+#endif // SIMDLANES_HPP
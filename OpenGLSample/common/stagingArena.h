@@ -0,0 +1,89 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+  Bump allocator of chunked pages, used to stage vertex / index data before it is uploaded to the GPU.
+  All meshes built in a frame share one arena, so building many meshes does not allocate per mesh;
+  reset() makes all pages reusable at once. Not thread safe.
+*/
+class StagingArena
+{
+public:
+	static const size_t DEFAULT_PAGE_SIZE; //!< Size of a regular page (256 KB)
+	static const size_t ALIGNMENT; //!< Alignment of every allocation (16 bytes)
+
+	/**
+	  Block of staging memory. Stays valid until the arena is reset.
+	*/
+	struct Allocation
+	{
+		unsigned char* data = nullptr; //!< Start of the block
+		size_t capacity = 0; //!< Usable size of the block in bytes
+		unsigned int generation = 0; //!< Arena generation the block belongs to
+	};
+
+	explicit StagingArena(size_t pageSize = DEFAULT_PAGE_SIZE);
+
+	/** \brief Gets arena shared by all VertexBufferObjects (unless they are given their own one).
+	*   \return Shared staging arena.
+	*/
+	static StagingArena& getShared();
+
+	/** \brief Allocates a block, bigger requests than the page size get their own page.
+	*   \param sizeBytes Requested size in bytes
+	*   \return New block, empty if sizeBytes is 0.
+	*/
+	Allocation allocate(size_t sizeBytes);
+
+	/** \brief Grows a block, keeping its first usedBytes. The block grows in place if it is the last one of
+	*          its page and the page has room, otherwise it moves (the old space is reclaimed by reset()).
+	*   \param allocation  Block to grow, updated to the new place
+	*   \param usedBytes   Number of bytes to keep
+	*   \param newCapacity Requested capacity in bytes
+	*/
+	void grow(Allocation& allocation, size_t usedBytes, size_t newCapacity);
+
+	/** \brief Gives a block back. Its space is reused immediately if it is the last allocation, otherwise after reset().
+	*   \param allocation Block to release, cleared afterwards
+	*/
+	void release(Allocation& allocation);
+
+	/** \brief Checks, if a block was allocated after the last reset().
+	*   \return True if the block can be used.
+	*/
+	bool isValid(const Allocation& allocation) const;
+
+	/** \brief Makes all pages reusable, invalidating all blocks. Pages bigger than the page size are freed. */
+	void reset();
+
+	/** \brief Gets number of bytes in use since the last reset.
+	*   \return Used bytes (including alignment padding).
+	*/
+	size_t getBytesUsed() const;
+
+	/** \brief Gets number of bytes held by all pages.
+	*   \return Reserved bytes.
+	*/
+	size_t getBytesReserved() const;
+
+private:
+	struct Page
+	{
+		std::unique_ptr<unsigned char[]> memory; //!< Page memory, left uninitialized
+		size_t size = 0; //!< Page size in bytes
+		size_t used = 0; //!< Bytes allocated from the page
+		size_t lastOffset = 0; //!< Offset of the last allocation (for growing / releasing in place)
+	};
+
+	std::vector<Page> _pages; //!< All pages, the ones after the current page are empty
+	size_t _currentPage = 0; //!< Page allocations are taken from
+	size_t _pageSize; //!< Size of regular pages
+	unsigned int _generation = 1; //!< Incremented on every reset
+
+	bool isLastAllocation(const Allocation& allocation) const;
+};
+
@@ -1,12 +1,35 @@
 #pragma once
 
+#include <vector>
+
+#include <glm/glm.hpp>
+
 #include "vertextBufferObject.h"
 
 
 namespace static_meshes_3D {
 
 /**
-	Represents generic 3D static mesh.
+	Placement of vertex attributes in the VBO of a static mesh.
+*/
+enum class VertexLayout
+{
+	Planar, //!< All positions, then all texture coordinates, then all normals
+	Interleaved, //!< Position, texture coordinate and normal of one vertex next to each other
+	PositionSplit //!< All positions, then texture coordinates and normals interleaved (position-only passes fetch one tight stream)
+};
+
+/**
+	Where one vertex attribute lives in the VBO.
+*/
+struct VertexAttributeLocation
+{
+	size_t offset = 0; //!< Byte offset of the attribute of the first vertex
+	GLsizei stride = 0; //!< Byte distance between the attribute of two consecutive vertices
+};
+
+/**
+	Represents generic 3D static mesh. Owns its GL objects, so it can be moved but not copied.
 */
 class StaticMesh3D
 {
@@ -15,9 +38,15 @@ public:
 	static const int TEXTURE_COORDINATE_ATTRIBUTE_INDEX; //!< Vertex attribute index of texture coordinate (1)
 	static const int NORMAL_ATTRIBUTE_INDEX; //!< Vertex attribute index of vertex normal (2)
 
-	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout = VertexLayout::Interleaved);
 	virtual ~StaticMesh3D();
 
+	StaticMesh3D(const StaticMesh3D&) = delete;
+	StaticMesh3D& operator=(const StaticMesh3D&) = delete;
+	StaticMesh3D(StaticMesh3D&& other) noexcept;
+	StaticMesh3D& operator=(StaticMesh3D&& other) noexcept;
+
 	/** \brief  Renders static mesh. */
 	virtual void render() const = 0;
 
@@ -47,20 +76,60 @@ public:
 	*/
 	int getVertexByteSize() const;
 
+	/** \brief  Gets layout of the vertex attributes in the VBO.
+	*   \return Vertex layout selected at construction.
+	*/
+	VertexLayout getVertexLayout() const;
+
+	/** \brief  Finds where an attribute is stored, depending on the vertex layout.
+	*   \param  attributeIndex  One of POSITION / TEXTURE_COORDINATE / NORMAL_ATTRIBUTE_INDEX
+	*   \param  numVertices     Number of vertices present in the buffer
+	*   \return Offset and stride of the attribute (zero stride if the mesh does not have it).
+	*/
+	VertexAttributeLocation getAttributeLocation(int attributeIndex, int numVertices) const;
+
 protected:
 	bool _hasPositions = false; //!< Flag telling, if we have vertex positions
 	bool _hasTextureCoordinates = false; //!< Flag telling, if we have texture coordinates
 	bool _hasNormals = false; //!< Flag telling, if we have vertex normals
+	VertexLayout _vertexLayout; //!< Placement of the vertex attributes in the VBO
 
 	bool _isInitialized = false; //!< Is mesh initialized flag
-	GLuint _vao = 0; //!< VAO ID from OpenGL
+	GLVertexArray _vao; //!< VAO from OpenGL
 	VertexBufferObject _vbo; //!< Our VBO wrapper class holding static mesh data
 
 	/** \brief  Initializes vertex data. */
 	virtual void initializeData() {};
 
-	/** \brief  Sets vertex attribute pointers in a standard way. */
+	/** \brief  Sets vertex attribute pointers according to the vertex layout. */
 	void setVertexAttributesPointers(int numVertices);
 };
 
+/**
+	Writes vertex attributes of a static mesh straight to the staging memory of a VBO, at the places given by
+	the mesh vertex layout, so that generators do not need to know the layout. Attributes the mesh does not
+	have are skipped. The writer is valid until more data is added to the VBO. If the VBO cannot stage the data,
+	the writer reports it and drops all writes; generators check isValid before uploading.
+*/
+class VertexWriter
+{
+public:
+	VertexWriter(const StaticMesh3D& mesh, int numVertices, VertexBufferObject& vbo);
+
+	void setPosition(int vertex, const glm::vec3& position);
+	void setTextureCoordinate(int vertex, const glm::vec2& textureCoordinate);
+	void setNormal(int vertex, const glm::vec3& normal);
+
+	//* \brief Tells, if the staging memory was obtained, false means the mesh must not be uploaded.
+	bool isValid() const { return _data != nullptr; }
+
+private:
+	unsigned char* _data; //!< Staged vertex data of the VBO
+	VertexAttributeLocation _position; //!< Location of positions in the raw data
+	VertexAttributeLocation _textureCoordinate; //!< Location of texture coordinates in the raw data
+	VertexAttributeLocation _normal; //!< Location of normals in the raw data
+
+	void write(const VertexAttributeLocation& location, int vertex, const void* value, size_t size);
+};
+
 }; // namespace static_meshes_3D
\ No newline at end of file
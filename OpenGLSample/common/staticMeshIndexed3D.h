@@ -10,9 +10,13 @@ namespace static_meshes_3D {
 class StaticMeshIndexed3D : public StaticMesh3D
 {
 public:
-	StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout = VertexLayout::Interleaved);
 	virtual ~StaticMeshIndexed3D();
 
+	StaticMeshIndexed3D(StaticMeshIndexed3D&&) = default;
+	StaticMeshIndexed3D& operator=(StaticMeshIndexed3D&&) = default;
+
 	void deleteMesh() override;
 
 protected:
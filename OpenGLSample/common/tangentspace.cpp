@@ -1,73 +1,207 @@
 #include <vector>
+#include <cmath>
+#include <thread>
+#include <algorithm>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
+#include "simdLanes.hpp"
 #include "tangentspace.hpp"
+#include "../qtangent.h"
 
-void computeTangentBasis(
-	// inputs
-	std::vector<glm::vec3> & vertices,
-	std::vector<glm::vec2> & uvs,
-	std::vector<glm::vec3> & normals,
-	// outputs
-	std::vector<glm::vec3> & tangents,
-	std::vector<glm::vec3> & bitangents
-){
-
-	for (unsigned int i=0; i<vertices.size(); i+=3 ){
+// Tangents are computed on SoA batches of triangles or vertices, on the float lanes of simdLanes.hpp.
 
-		// Shortcuts for vertices
-		glm::vec3 & v0 = vertices[i+0];
-		glm::vec3 & v1 = vertices[i+1];
-		glm::vec3 & v2 = vertices[i+2];
+namespace {
 
-		// Shortcuts for UVs
-		glm::vec2 & uv0 = uvs[i+0];
-		glm::vec2 & uv1 = uvs[i+1];
-		glm::vec2 & uv2 = uvs[i+2];
+	using namespace simd;
 
-		// Edges of the triangle : postion delta
-		glm::vec3 deltaPos1 = v1-v0;
-		glm::vec3 deltaPos2 = v2-v0;
+	// AoS -> SoA : element index(first + k) goes to lane k
+	template <typename F, typename Index>
+	Vec3<F> gather(const glm::vec3 * data, size_t first, Index index){
+		float x[F::WIDTH], y[F::WIDTH], z[F::WIDTH];
+		for (int k = 0; k < F::WIDTH; k++){
+			const glm::vec3 & value = data[index(first + k)];
+			x[k] = value.x;
+			y[k] = value.y;
+			z[k] = value.z;
+		}
+		return { F::load(x), F::load(y), F::load(z) };
+	}
 
-		// UV delta
-		glm::vec2 deltaUV1 = uv1-uv0;
-		glm::vec2 deltaUV2 = uv2-uv0;
+	template <typename F, typename Index>
+	void gather(const glm::vec2 * data, size_t first, Index index, F & u, F & v){
+		float x[F::WIDTH], y[F::WIDTH];
+		for (int k = 0; k < F::WIDTH; k++){
+			const glm::vec2 & value = data[index(first + k)];
+			x[k] = value.x;
+			y[k] = value.y;
+		}
+		u = F::load(x);
+		v = F::load(y);
+	}
 
-		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-		glm::vec3 tangent = (deltaPos1 * deltaUV2.y   - deltaPos2 * deltaUV1.y)*r;
-		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x   - deltaPos1 * deltaUV2.x)*r;
+	template <typename F, typename Index>
+	void scatter(const Vec3<F> & value, glm::vec3 * data, size_t first, Index index){
+		float x[F::WIDTH], y[F::WIDTH], z[F::WIDTH];
+		value.x.store(x);
+		value.y.store(y);
+		value.z.store(z);
+		for (int k = 0; k < F::WIDTH; k++)
+			data[index(first + k)] = glm::vec3(x[k], y[k], z[k]);
+	}
 
-		// Set the same tangent for all three vertices of the triangle.
-		// They will be merged later, in vboindexer.cpp
-		tangents.push_back(tangent);
-		tangents.push_back(tangent);
-		tangents.push_back(tangent);
+	// Tangent and bitangent of triangles first .. first + WIDTH - 1, corner c of triangle t being vertex corner(t, c)
+	template <typename F, typename Corner>
+	void triangleBasis(size_t first, Corner corner, const glm::vec3 * vertices, const glm::vec2 * uvs,
+		Vec3<F> & tangent, Vec3<F> & bitangent){
+		auto corner0 = [&](size_t t){ return corner(t, 0); };
+		auto corner1 = [&](size_t t){ return corner(t, 1); };
+		auto corner2 = [&](size_t t){ return corner(t, 2); };
 
-		// Same thing for binormals
-		bitangents.push_back(bitangent);
-		bitangents.push_back(bitangent);
-		bitangents.push_back(bitangent);
+		// Edges of the triangle : postion delta
+		const Vec3<F> v0 = gather<F>(vertices, first, corner0);
+		const Vec3<F> deltaPos1 = gather<F>(vertices, first, corner1) - v0;
+		const Vec3<F> deltaPos2 = gather<F>(vertices, first, corner2) - v0;
 
+		// UV delta
+		F u0, w0, u1, w1, u2, w2;
+		gather(uvs, first, corner0, u0, w0);
+		gather(uvs, first, corner1, u1, w1);
+		gather(uvs, first, corner2, u2, w2);
+		const F deltaU1 = u1 - u0, deltaV1 = w1 - w0;
+		const F deltaU2 = u2 - u0, deltaV2 = w2 - w0;
+
+		const F r = splat<F>(1.0f) / (deltaU1 * deltaV2 - deltaV1 * deltaU2);
+		tangent = (deltaPos1 * deltaV2 - deltaPos2 * deltaV1) * r;
+		bitangent = (deltaPos2 * deltaU1 - deltaPos1 * deltaU2) * r;
 	}
 
-	// See "Going Further"
-	for (unsigned int i=0; i<vertices.size(); i+=1 )
-	{
-		glm::vec3 & n = normals[i];
-		glm::vec3 & t = tangents[i];
-		glm::vec3 & b = bitangents[i];
-		
-		// Gram-Schmidt orthogonalize
-		t = glm::normalize(t - n * glm::dot(n, t));
-		
-		// Calculate handedness
-		if (glm::dot(glm::cross(n, t), b) < 0.0f){
-			t = t * -1.0f;
-		}
+	// Gram-Schmidt orthogonalize, then flip the tangent for mirrored UVs (see "Going Further")
+	template <typename F>
+	Vec3<F> orthogonalize(const Vec3<F> & n, const Vec3<F> & t, const Vec3<F> & b){
+		Vec3<F> result = t - n * dot(n, t);
+		result = result * (splat<F>(1.0f) / sqrt(dot(result, result)));
+		const F handedness = dot(cross(n, result), b);
+		return { negateIfNegative(result.x, handedness), negateIfNegative(result.y, handedness), negateIfNegative(result.z, handedness) };
+	}
 
+	// Splits [0, count) in contiguous ranges, one per thread (at least minPerThread elements each)
+	template <typename Function>
+	void forEachRange(size_t count, unsigned int numThreads, size_t minPerThread, Function function){
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		numThreads = (unsigned int)std::max<size_t>(1, std::min<size_t>(numThreads, count / minPerThread));
+
+		std::vector<std::thread> threads;
+		for (unsigned int i = 1; i < numThreads; i++)
+			threads.emplace_back(function, count * i / numThreads, count * (i + 1) / numThreads);
+		function((size_t)0, count / numThreads);
+		for (std::thread & thread : threads)
+			thread.join();
 	}
 
+	// triangles or vertices, below that a thread costs more than it saves
+	const size_t MIN_PER_THREAD = 8192;
+
+} // namespace
+
+void computeTangentBasis(
+	// inputs
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads
+){
+	// Every corner gets the tangent of its triangle, they will be merged later, in vboindexer.cpp
+	tangents.resize(vertices.size());
+	bitangents.resize(vertices.size());
+
+	auto corner = [](size_t t, size_t c){ return 3 * t + c; };
+	forEachRange(vertices.size() / 3, numThreads, MIN_PER_THREAD, [&](size_t begin, size_t end){
+		forEachBatch(begin, end, [&](auto lanes, size_t first){
+			typedef decltype(lanes) F;
+			Vec3<F> tangent, bitangent;
+			triangleBasis<F>(first, corner, vertices.data(), uvs.data(), tangent, bitangent);
+			for (size_t c = 0; c < 3; c++){
+				auto cornerC = [c](size_t t){ return 3 * t + c; };
+				const Vec3<F> normal = gather<F>(normals.data(), first, cornerC);
+				scatter(orthogonalize(normal, tangent, bitangent), tangents.data(), first, cornerC);
+				scatter(bitangent, bitangents.data(), first, cornerC);
+			}
+		});
+	});
+}
 
+void computeTangentBasis(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads
+){
+	const size_t numTriangles = indices.size() / 3;
+	std::vector<glm::vec3> triangleTangents(numTriangles);
+	std::vector<glm::vec3> triangleBitangents(numTriangles);
+	auto corner = [&indices](size_t t, size_t c){ return indices[3 * t + c]; };
+	auto self = [](size_t t){ return t; };
+	forEachRange(numTriangles, numThreads, MIN_PER_THREAD, [&](size_t begin, size_t end){
+		forEachBatch(begin, end, [&](auto lanes, size_t first){
+			typedef decltype(lanes) F;
+			Vec3<F> tangent, bitangent;
+			triangleBasis<F>(first, corner, vertices.data(), uvs.data(), tangent, bitangent);
+			scatter(tangent, triangleTangents.data(), first, self);
+			scatter(bitangent, triangleBitangents.data(), first, self);
+		});
+	});
+
+	// Sum over the triangles around each vertex : every thread owns a range of vertices and adds in triangle order,
+	// so the sums do not depend on the thread count. Triangle tangents are not normalized, so their length weighs
+	// them, like the sums of indexVBO_TBN
+	tangents.assign(vertices.size(), glm::vec3(0.0f));
+	bitangents.assign(vertices.size(), glm::vec3(0.0f));
+	forEachRange(vertices.size(), numThreads, MIN_PER_THREAD, [&](size_t begin, size_t end){
+		for (size_t i = 0; i < numTriangles * 3; i++){
+			const size_t vertex = indices[i];
+			if (vertex >= begin && vertex < end){
+				tangents[vertex] += triangleTangents[i / 3];
+				bitangents[vertex] += triangleBitangents[i / 3];
+			}
+		}
+	});
+
+	forEachRange(vertices.size(), numThreads, MIN_PER_THREAD, [&](size_t begin, size_t end){
+		forEachBatch(begin, end, [&](auto lanes, size_t first){
+			typedef decltype(lanes) F;
+			const Vec3<F> normal = gather<F>(normals.data(), first, self);
+			const Vec3<F> tangent = gather<F>(tangents.data(), first, self);
+			const Vec3<F> bitangent = gather<F>(bitangents.data(), first, self);
+			scatter(orthogonalize(normal, tangent, bitangent), tangents.data(), first, self);
+		});
+	});
 }
 
+void computeQTangentBasis(
+	// inputs
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::i16vec4> & qtangents
+){
+	std::vector<glm::vec3> tangents;
+	std::vector<glm::vec3> bitangents;
+	computeTangentBasis(vertices, uvs, normals, tangents, bitangents);
 
+	qtangents.reserve(qtangents.size() + vertices.size());
+	for (unsigned int i=0; i<vertices.size(); i++)
+	{
+		qtangents.push_back(packQTangent(encodeQTangent(normals[i], tangents[i], bitangents[i])));
+	}
+}
@@ -1,6 +1,9 @@
 #ifndef TANGENTSPACE_HPP
 #define TANGENTSPACE_HPP
 
+// Per corner tangents of a triangle list (3 corners per triangle), orthogonalized against the corner normal.
+// Outputs are resized to the corner count. Batches of triangles run with SSE / AVX, on numThreads threads
+// (0 : all of them).
 void computeTangentBasis(
 	// inputs
 	std::vector<glm::vec3> & vertices,
@@ -8,7 +11,32 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & normals,
 	// outputs
 	std::vector<glm::vec3> & tangents,
-	std::vector<glm::vec3> & bitangents
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads = 1
+);
+
+// Per vertex tangents of an indexed mesh : sums of the tangents of the triangles around each vertex, then
+// orthogonalized against the vertex normal. Outputs are resized to the vertex count.
+void computeTangentBasis(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents,
+	unsigned int numThreads = 1
+);
+
+// Same frames packed to one QTangent per vertex (see qtangent.h), 8 bytes instead of 24
+void computeQTangentBasis(
+	// inputs
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::i16vec4> & qtangents
 );
 
 
@@ -5,13 +5,26 @@
 
 #include <glad\glad.h>
 
+#include "stagingArena.h"
+#include "../glHandle.h"
+
 /**
   Wraps OpenGL's vertex buffer object to a higher level class.
+  Data added before uploading is staged in a StagingArena, shared by all VBOs unless given otherwise.
+  The object owns its GL buffer and staging memory, so it can be moved but not copied.
 */
 
 class VertexBufferObject
 {
 public:
+	explicit VertexBufferObject(StagingArena& stagingArena = StagingArena::getShared());
+	~VertexBufferObject();
+
+	VertexBufferObject(const VertexBufferObject&) = delete;
+	VertexBufferObject& operator=(const VertexBufferObject&) = delete;
+	VertexBufferObject(VertexBufferObject&& other) noexcept;
+	VertexBufferObject& operator=(VertexBufferObject&& other) noexcept;
+
 	/** \brief Creates a new VBO, with optional reserved buffer size.
 	*   \param size Buffer size reservation, in bytes (so that memory allocations don't take place while adding data)
 	*/
@@ -39,6 +52,12 @@ public:
 		addRawData(&obj, sizeof(T), repeat);
 	}
 
+	/** \brief Appends uninitialized bytes to the in-memory buffer, for generators writing data in place.
+	*   \param dataSizeBytes Number of bytes to append
+	*   \return Pointer to the appended bytes, valid until the next add / append call, or nullptr on failure.
+	*/
+	unsigned char* appendRawData(uint32_t dataSizeBytes);
+
 	/** \brief Gets pointer to the data from in-memory buffer (only before uploading them).
 	*   \return Pointer to the raw data.
 	*/
@@ -80,13 +99,13 @@ public:
 	void deleteVBO();
 
 private:
-	GLuint _bufferID = 0; //! OpenGL assigned buffer ID
-	int _bufferType; //! Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
+	GLBuffer _buffer; //! OpenGL assigned buffer, empty until createVBO
+	int _bufferType = GL_ARRAY_BUFFER; //! Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
 
-	std::vector<unsigned char> _rawData; //! In-memory raw data buffer, used to gather the data for VBO.
+	StagingArena* _stagingArena; //! Arena holding the data before upload
+	StagingArena::Allocation _staging; //! In-memory raw data buffer, used to gather the data for VBO.
 	size_t _bytesAdded = 0; //! Number of bytes added to the buffer so far
-	uint32_t _uploadedDataSize; //! Holds buffer data size after uploading to GPU
+	uint32_t _uploadedDataSize = 0; //! Holds buffer data size after uploading to GPU
 
-	bool _isBufferCreated = false;
 	bool _isDataUploaded = false; //! Flag telling, if data has been uploaded to GPU already.
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 // Project
 #include "cube.h"
+#include "glState.h"
 
 namespace static_meshes_3D {
 
@@ -57,7 +58,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
@@ -67,7 +68,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
         glDrawArrays(GL_POINTS, 0, 36);
     }
 
@@ -77,7 +78,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
 
         if (facesBitmask & CUBE_FRONT_FACE) {
             glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -106,7 +107,7 @@ namespace static_meshes_3D {
         }
 
         glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
 
         const auto numVertices = 36;
         const auto vertexByteSize = getVertexByteSize();
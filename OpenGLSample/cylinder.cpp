@@ -1,4 +1,5 @@
 // STL
+#include <cmath>
 #include <vector>
 
 // GLM
@@ -10,10 +11,9 @@
 
 namespace static_meshes_3D {
 
-	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals)
-		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+		: RevolvedMesh3D(numSlices, withPositions, withTextureCoordinates, withNormals, vertexLayout)
 		, _radius(radius)
-		, _numSlices(numSlices)
 		, _height(height)
 	{
 		initializeData();
@@ -24,11 +24,6 @@ namespace static_meshes_3D {
 		return _radius;
 	}
 
-	int Cylinder::getSlices() const
-	{
-		return _numSlices;
-	}
-
 	float Cylinder::getHeight() const
 	{
 		return _height;
@@ -36,150 +31,147 @@ namespace static_meshes_3D {
 
 	void Cylinder::initializeData()
 	{
-		if (_isInitialized) {
-			return;
-		}
-
-		// Calculate and cache numbers of vertices
-		_numVerticesSide = (_numSlices + 1) * 2;
-		_numVerticesTopBottom = _numSlices + 2;
-		_numVerticesTotal = _numVerticesSide + _numVerticesTopBottom * 2;
-
-		// Generate VAO and VBO for vertex attributes
-		glGenVertexArrays(1, &_vao);
-		glBindVertexArray(_vao);
-		_vbo.createVBO(getVertexByteSize() * _numVerticesTotal);
-
-		// Pre-calculate sines / cosines for given number of slices
-		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
-		auto currentSliceAngle = 0.0f;
-		std::vector<float> sines, cosines;
-		for (auto i = 0; i <= _numSlices; i++)
-		{
-			sines.push_back(sin(currentSliceAngle));
-			cosines.push_back(cos(currentSliceAngle));
+		// Side is a single band from the top ring to the bottom ring, covers have their own rings
+		// as their normals differs. I have decided to map the texture twice around cylinder, looks fine
+		const std::vector<ProfilePoint> profile = {
+			{ _radius, _height / 2.0f, 1.0f, 0.0f, 1.0f },
+			{ _radius, -_height / 2.0f, 1.0f, 0.0f, 0.0f }
+		};
+		const std::vector<CapDisc> caps = {
+			{ _radius, _height / 2.0f, true },
+			{ _radius, -_height / 2.0f, false }
+		};
+		buildMesh(profile, 2.0f, caps);
+	}
 
-			// Update slice angle
-			currentSliceAngle += sliceAngleStep;
-		}
+	Cone::Cone(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+		: RevolvedMesh3D(numSlices, withPositions, withTextureCoordinates, withNormals, vertexLayout)
+		, _radius(radius)
+		, _height(height)
+	{
+		initializeData();
+	}
 
-		if (hasPositions())
-		{
-			// Pre-calculate X and Z coordinates
-			std::vector<float> x;
-			std::vector<float> z;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				x.push_back(cosines[i] * _radius);
-				z.push_back(sines[i] * _radius);
-			}
-
-			// Add cylinder side vertices
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-
-			// Add top cylinder cover
-			glm::vec3 topCenterPosition(0.0f, _height / 2.0f, 0.0f);
-			_vbo.addRawData(&topCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-			}
-
-			// Add bottom cylinder cover
-			glm::vec3 bottomCenterPosition(0.0f, -_height / 2.0f, 0.0f);
-			_vbo.addRawData(&bottomCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, -z[i]);
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-		}
+	float Cone::getRadius() const
+	{
+		return _radius;
+	}
 
-		if (hasTextureCoordinates())
-		{
-			// Pre-calculate step size in texture coordinate U
-			// I have decided to map the texture twice around cylinder, looks fine
-			const auto sliceTextureStepU = 2.0f / float(_numSlices);
-
-			auto currentSliceTexCoordU = 0.0f;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 1.0f));
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 0.0f));
-
-				// Update texture coordinate of current slice 
-				currentSliceTexCoordU += sliceTextureStepU;
-			}
-
-			// Generate circle texture coordinates for cylinder top cover
-			glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
-			}
-
-			// Generate circle texture coordinates for cylinder bottom cover
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
-			}
-		}
+	float Cone::getHeight() const
+	{
+		return _height;
+	}
 
-		if (hasNormals())
-		{
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec3(cosines[i], 0.0f, sines[i]), 2);
-			}
+	void Cone::initializeData()
+	{
+		// Side normal is perpendicular to the slant, the apex ring keeps it too, so the tip is shaded per slice
+		const auto slantLength = std::sqrt(_radius * _radius + _height * _height);
+		const auto normalRadial = _height / slantLength;
+		const auto normalY = _radius / slantLength;
+		const std::vector<ProfilePoint> profile = {
+			{ 0.0f, _height / 2.0f, normalRadial, normalY, 1.0f },
+			{ _radius, -_height / 2.0f, normalRadial, normalY, 0.0f }
+		};
+		const std::vector<CapDisc> caps = {
+			{ _radius, -_height / 2.0f, false }
+		};
+		buildMesh(profile, 1.0f, caps);
+	}
 
-			// Add normal for every vertex of cylinder top cover
-			_vbo.addData(glm::vec3(0.0f, 1.0f, 0.0f), _numVerticesTopBottom);
+	Capsule::Capsule(float radius, int numSlices, int numStacks, float height, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+		: RevolvedMesh3D(numSlices, withPositions, withTextureCoordinates, withNormals, vertexLayout)
+		, _radius(radius)
+		, _numStacks(numStacks < 1 ? 1 : numStacks)
+		, _height(height)
+	{
+		initializeData();
+	}
 
-			// Add normal for every vertex of cylinder bottom cover
-			_vbo.addData(glm::vec3(0.0f, -1.0f, 0.0f), _numVerticesTopBottom);
-		}
+	float Capsule::getRadius() const
+	{
+		return _radius;
+	}
 
-		// Finally upload data to the GPU
-		_vbo.bindVBO();
-		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
-		setVertexAttributesPointers(_numVerticesTotal);
+	int Capsule::getStacks() const
+	{
+		return _numStacks;
+	}
 
-		_isInitialized = true;
+	float Capsule::getHeight() const
+	{
+		return _height;
 	}
 
-	void Cylinder::render() const
+	void Capsule::initializeData()
 	{
-		if (!_isInitialized) {
-			return;
+		// Profile goes from the top pole over both equators to the bottom pole; the normals are continuous,
+		// so the cylindrical part is just the band between the two equator rings.
+		// Texture coordinate V follows the length of the profile
+		const auto quarterArc = glm::half_pi<float>() * _radius;
+		const auto profileLength = 2.0f * quarterArc + _height;
+		const auto stackAngleStep = glm::half_pi<float>() / float(_numStacks);
+
+		std::vector<ProfilePoint> profile;
+		profile.reserve(2 * (_numStacks + 1));
+		for (auto j = 0; j <= _numStacks; j++)
+		{
+			const auto angle = stackAngleStep * j; // from the pole towards the equator
+			const auto radius = j == 0 ? 0.0f : _radius * std::sin(angle);
+			const auto normalRadial = j == 0 ? 0.0f : std::sin(angle);
+			profile.push_back({ radius, _height / 2.0f + _radius * std::cos(angle), normalRadial, std::cos(angle),
+				1.0f - quarterArc * j / _numStacks / profileLength });
 		}
+		for (auto j = _height > 0.0f ? 0 : 1; j <= _numStacks; j++)
+		{
+			const auto angle = stackAngleStep * j; // from the equator towards the pole
+			const auto radius = j == _numStacks ? 0.0f : _radius * std::cos(angle);
+			const auto normalRadial = j == _numStacks ? 0.0f : std::cos(angle);
+			profile.push_back({ radius, -_height / 2.0f - _radius * std::sin(angle), normalRadial, -std::sin(angle),
+				quarterArc * (_numStacks - j) / _numStacks / profileLength });
+		}
+		buildMesh(profile, 1.0f, {});
+	}
 
-		glBindVertexArray(_vao);
+	Torus::Torus(float mainRadius, float tubeRadius, int numMainSegments, int numTubeSegments, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+		: RevolvedMesh3D(numMainSegments, withPositions, withTextureCoordinates, withNormals, vertexLayout)
+		, _mainRadius(mainRadius)
+		, _tubeRadius(tubeRadius)
+		, _numTubeSegments(numTubeSegments < 3 ? 3 : numTubeSegments)
+	{
+		initializeData();
+	}
 
-		// Render cylinder side first
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVerticesSide);
+	float Torus::getMainRadius() const
+	{
+		return _mainRadius;
+	}
 
-		// Render top cover
-		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom);
+	float Torus::getTubeRadius() const
+	{
+		return _tubeRadius;
+	}
 
-		// Render bottom cover
-		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
+	int Torus::getTubeSegments() const
+	{
+		return _numTubeSegments;
 	}
 
-	void Cylinder::renderPoints() const
+	void Torus::initializeData()
 	{
-		if (!_isInitialized) {
-			return;
-		}
+		// Profile is the tube circle walked clockwise (outer side from top to bottom), so the surface faces outwards.
+		// Last point repeats the first one for the texture seam
+		const auto tubeAngleStep = 2.0f * glm::pi<float>() / float(_numTubeSegments);
 
-		// Just render all points as they are stored in the VBO
-		glBindVertexArray(_vao);
-		glDrawArrays(GL_POINTS, 0, _numVerticesTotal);
+		std::vector<ProfilePoint> profile;
+		profile.reserve(_numTubeSegments + 1);
+		for (auto j = 0; j <= _numTubeSegments; j++)
+		{
+			const auto angle = j == _numTubeSegments ? 0.0f : -tubeAngleStep * j;
+			const auto cosine = std::cos(angle);
+			const auto sine = std::sin(angle);
+			profile.push_back({ _mainRadius + _tubeRadius * cosine, _tubeRadius * sine, cosine, sine, float(j) / float(_numTubeSegments) });
+		}
+		buildMesh(profile, 1.0f, {});
 	}
 
-} // namespace static_meshes_3D
\ No newline at end of file
+} // namespace static_meshes_3D
@@ -1,30 +1,23 @@
 #pragma once
-#include "common/staticMesh3D.h"
+#include "revolvedMesh3D.h"
 
 namespace static_meshes_3D {
 
 	/**
 	* Cylinder static mesh with given radius, number of slices and height.
 	*/
-	class Cylinder : public StaticMesh3D
+	class Cylinder : public RevolvedMesh3D
 	{
 	public:
 		Cylinder(float radius, int numSlices, float height,
-			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
-
-		void render() const override;
-		void renderPoints() const override;
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved);
 
 		/**
 		 * Gets cylinder radius.
 		 */
 		float getRadius() const;
 
-		/**
-		 * Gets number of cylinder slices.
-		 */
-		int getSlices() const;
-
 		/**
 		 * Gets cylinder height.
 		 */
@@ -32,14 +25,102 @@ namespace static_meshes_3D {
 
 	private:
 		float _radius; // Cylinder radius (distance from the center of cylinder to surface)
-		int _numSlices; // Number of cylinder slices
 		float _height; // Height of the cylinder
 
-		int _numVerticesSide; // How many vertices to render side of the cylinder
-		int _numVerticesTopBottom; // How many vertices to render top / bottom of the cylinder
-		int _numVerticesTotal; // Just a sum of both numbers above
+		void initializeData() override;
+	};
+
+	/**
+	* Cone static mesh standing on its base, apex up, with given base radius, number of slices and height.
+	*/
+	class Cone : public RevolvedMesh3D
+	{
+	public:
+		Cone(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved);
+
+		/**
+		 * Gets cone base radius.
+		 */
+		float getRadius() const;
+
+		/**
+		 * Gets cone height.
+		 */
+		float getHeight() const;
+
+	private:
+		float _radius; // Radius of the cone base
+		float _height; // Height of the cone
+
+		void initializeData() override;
+	};
+
+	/**
+	* Capsule static mesh: a cylinder of given height closed with two hemispheres of the same radius.
+	*/
+	class Capsule : public RevolvedMesh3D
+	{
+	public:
+		Capsule(float radius, int numSlices, int numStacks, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved);
+
+		/**
+		 * Gets capsule radius.
+		 */
+		float getRadius() const;
+
+		/**
+		 * Gets number of stacks of one hemisphere.
+		 */
+		int getStacks() const;
+
+		/**
+		 * Gets height of the cylindrical part (total height is height + 2 * radius).
+		 */
+		float getHeight() const;
+
+	private:
+		float _radius; // Radius of both the cylinder and the hemispheres
+		int _numStacks; // Number of stacks of one hemisphere
+		float _height; // Height of the cylindrical part
+
+		void initializeData() override;
+	};
+
+	/**
+	* Torus static mesh lying in the XZ plane.
+	*/
+	class Torus : public RevolvedMesh3D
+	{
+	public:
+		Torus(float mainRadius, float tubeRadius, int numMainSegments, int numTubeSegments,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved);
+
+		/**
+		 * Gets distance from the torus center to the center of the tube.
+		 */
+		float getMainRadius() const;
+
+		/**
+		 * Gets radius of the tube.
+		 */
+		float getTubeRadius() const;
+
+		/**
+		 * Gets number of segments around the tube.
+		 */
+		int getTubeSegments() const;
+
+	private:
+		float _mainRadius; // Distance from the torus center to the center of the tube
+		float _tubeRadius; // Radius of the tube
+		int _numTubeSegments; // Number of segments around the tube
 
 		void initializeData() override;
 	};
 
-} // namespace static_meshes_3D
\ No newline at end of file
+} // namespace static_meshes_3D
@@ -1,58 +0,0 @@
-#define _USE_MATH_DEFINES // for C++
-#include <cmath>
-
-#include "floss.h"
-
-using namespace std; // Standard namespace
-
-
-vector<GLfloat>* Floss::drawFloss()
-{
-    vector<GLfloat>* vec = new vector<GLfloat>{
-		// positions          // normals           // texture coords
-// positions          // normals           // texture coords
--0.5f, -0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
- 0.5f, -0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
- 0.5f,  0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
- 0.5f,  0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
--0.5f,  0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
--0.5f, -0.25f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-
--0.5f, -0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
- 0.5f, -0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
- 0.5f,  0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
- 0.5f,  0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
--0.5f,  0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
--0.5f, -0.25f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-
--0.5f,  0.25f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
--0.5f,  0.25f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
--0.5f, -0.25f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
--0.5f, -0.25f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
--0.5f, -0.25f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
--0.5f,  0.25f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
- 0.5f,  0.25f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
- 0.5f,  0.25f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
- 0.5f, -0.25f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
- 0.5f, -0.25f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
- 0.5f, -0.25f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
- 0.5f,  0.25f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
--0.5f, -0.25f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
- 0.5f, -0.25f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
- 0.5f, -0.25f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
- 0.5f, -0.25f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
--0.5f, -0.25f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
--0.5f, -0.25f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-
--0.5f,  0.25f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
- 0.5f,  0.25f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
- 0.5f,  0.25f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
- 0.5f,  0.25f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
--0.5f,  0.25f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
--0.5f,  0.25f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-
-    };
-    return vec;
-}
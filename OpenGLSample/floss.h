@@ -1,12 +1,9 @@
 #pragma once
-#pragma once
-#include <glad/glad.h>
-#include <vector>
-
-using namespace std; // Standard namespace
+#include "boxMesh.h"
 
 class Floss
 {
 public:
-	static vector<GLfloat>* drawFloss();
+	// floss box, generated at compile time
+	static constexpr auto MESH = box_mesh::makeBox(0.5, 0.25, 0.5);
 };
@@ -0,0 +1,159 @@
+// STL
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "frameStats.h"
+
+namespace {
+
+	/**
+	 * Summary of one column of frame times.
+	 */
+	struct TimeSummary
+	{
+		double mean = 0.0;
+		double median = 0.0;
+		double p95 = 0.0;
+		double worst = 0.0;
+		size_t count = 0;
+	};
+
+	TimeSummary summarize(std::vector<double>& times)
+	{
+		TimeSummary summary;
+		summary.count = times.size();
+		if (times.empty()) {
+			return summary;
+		}
+
+		std::sort(times.begin(), times.end());
+		for (double time : times) {
+			summary.mean += time;
+		}
+		summary.mean /= times.size();
+		summary.median = times[times.size() / 2];
+		summary.p95 = times[std::min(times.size() - 1, times.size() * 95 / 100)];
+		summary.worst = times.back();
+		return summary;
+	}
+
+	void printSummary(const char* name, const TimeSummary& summary)
+	{
+		if (summary.count == 0)
+		{
+			std::cout << "  " << std::setw(4) << name << "  n/a" << std::endl;
+			return;
+		}
+		std::cout << "  " << std::setw(4) << name << std::fixed << std::setprecision(3)
+			<< "  mean " << std::setw(8) << summary.mean
+			<< "  median " << std::setw(8) << summary.median
+			<< "  p95 " << std::setw(8) << summary.p95
+			<< "  max " << std::setw(8) << summary.worst << " ms" << std::endl;
+	}
+
+} // namespace
+
+void FrameStats::beginFrame(unsigned int segment)
+{
+	if (_queries[0] == 0) {
+		glGenQueries(NUM_QUERIES, _queries);
+	}
+
+	const size_t frame = _frames.size();
+	_frames.push_back({ segment, 0.0, -1.0 });
+
+	// the query of this slot measured a frame NUM_QUERIES frames ago, long done on the GPU by now
+	const unsigned int slot = static_cast<unsigned int>(frame % NUM_QUERIES);
+	readQuery(slot);
+	glBeginQuery(GL_TIME_ELAPSED, _queries[slot]);
+	_queryFrames[slot] = frame;
+	_queryPending[slot] = true;
+
+	_frameStart = std::chrono::steady_clock::now();
+}
+
+void FrameStats::endFrame()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	_frames.back().cpuMilliseconds =
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _frameStart).count();
+}
+
+void FrameStats::finish()
+{
+	if (_queries[0] == 0) {
+		return;
+	}
+
+	for (unsigned int slot = 0; slot < NUM_QUERIES; slot++) {
+		readQuery(slot);
+	}
+	glDeleteQueries(NUM_QUERIES, _queries);
+	std::fill(_queries, _queries + NUM_QUERIES, 0u);
+}
+
+void FrameStats::readQuery(unsigned int slot)
+{
+	if (!_queryPending[slot]) {
+		return;
+	}
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(_queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	_frames[_queryFrames[slot]].gpuMilliseconds = nanoseconds / 1.0e6;
+	_queryPending[slot] = false;
+}
+
+void FrameStats::print(const std::vector<std::string>& segmentNames) const
+{
+	std::cout << "===== Frame times by path segment =====" << std::endl;
+	for (unsigned int segment = 0; segment < segmentNames.size(); segment++)
+	{
+		std::vector<double> cpu, gpu;
+		for (const Frame& frame : _frames)
+		{
+			if (frame.segment != segment) {
+				continue;
+			}
+			cpu.push_back(frame.cpuMilliseconds);
+			if (frame.gpuMilliseconds >= 0.0) {
+				gpu.push_back(frame.gpuMilliseconds);
+			}
+		}
+		if (cpu.empty()) {
+			continue;
+		}
+
+		std::cout << segmentNames[segment] << " (" << cpu.size() << " frames)" << std::endl;
+		printSummary("cpu", summarize(cpu));
+		printSummary("gpu", summarize(gpu));
+	}
+}
+
+bool FrameStats::writeCsv(const char* path, const std::vector<std::string>& segmentNames) const
+{
+	FILE* file = std::fopen(path, "w");
+	if (file == nullptr)
+	{
+		std::cout << "ERROR::FRAME_STATS::FAILED_TO_WRITE " << path << std::endl;
+		return false;
+	}
+
+	std::fprintf(file, "frame,segment,cpu_ms,gpu_ms\n");
+	for (size_t i = 0; i < _frames.size(); i++)
+	{
+		const Frame& frame = _frames[i];
+		const char* name = frame.segment < segmentNames.size() ? segmentNames[frame.segment].c_str() : "";
+		std::fprintf(file, "%zu,\"%s\",%.4f,%.4f\n", i, name, frame.cpuMilliseconds, frame.gpuMilliseconds);
+	}
+
+	const bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	return ok;
+}
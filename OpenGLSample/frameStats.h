@@ -0,0 +1,53 @@
+#pragma once
+
+// STL
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Frame times of a benchmark run, tagged with the camera path segment each frame belongs to.
+ * CPU time runs from beginFrame to endFrame; GPU time is measured over the same commands with GL_TIME_ELAPSED
+ * queries, read back a few frames later so that the CPU never waits for the GPU.
+ *
+ * Needs a current OpenGL 3.3+ context from the first beginFrame until finish().
+ */
+class FrameStats
+{
+public:
+    void beginFrame(unsigned int segment);
+    void endFrame();
+
+    /**
+     * Waits for the outstanding GPU times and deletes the queries.
+     */
+    void finish();
+
+    /**
+     * Prints frame count and mean / median / 95th percentile / worst CPU and GPU times of every segment.
+     */
+    void print(const std::vector<std::string>& segmentNames) const;
+
+    /**
+     * Writes one line per frame: frame, segment, CPU and GPU milliseconds.
+     */
+    bool writeCsv(const char* path, const std::vector<std::string>& segmentNames) const;
+
+private:
+    struct Frame
+    {
+        unsigned int segment;
+        double cpuMilliseconds;
+        double gpuMilliseconds; // negative until the query result is read
+    };
+
+    static const unsigned int NUM_QUERIES = 4;
+
+    void readQuery(unsigned int slot);
+
+    std::vector<Frame> _frames;
+    std::chrono::steady_clock::time_point _frameStart;
+    unsigned int _queries[NUM_QUERIES] = {};
+    size_t _queryFrames[NUM_QUERIES] = {}; // frame measured by each query, valid while the query is pending
+    bool _queryPending[NUM_QUERIES] = {};
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+// GLAD
+#include <glad/glad.h>
+
+#include "glState.h"
+
+/**
+ * Move-only owner of one OpenGL object name. The object is deleted through GLState (so the binding cache forgets
+ * the name) when the handle is destroyed, reset or assigned another object.
+ *
+ * Deleting needs the GL context: handles that would outlive it must be reset() before it is destroyed.
+ */
+template <typename Traits>
+class GLHandle
+{
+public:
+    GLHandle() = default;
+    explicit GLHandle(GLuint name) : _name(name) {}
+    ~GLHandle() { reset(); }
+
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    GLHandle(GLHandle&& other) noexcept : _name(other.release()) {}
+
+    GLHandle& operator=(GLHandle&& other) noexcept
+    {
+        if (this != &other)
+            reset(other.release());
+        return *this;
+    }
+
+    /**
+     * Generates a new object of the handle type.
+     */
+    static GLHandle create() { return GLHandle(Traits::create()); }
+
+    /**
+     * Gets the owned name, 0 if there is none. The handle keeps owning it.
+     */
+    GLuint get() const { return _name; }
+
+    explicit operator bool() const { return _name != 0; }
+
+    /**
+     * Gives up ownership without deleting the object.
+     */
+    GLuint release()
+    {
+        const GLuint name = _name;
+        _name = 0;
+        return name;
+    }
+
+    /**
+     * Deletes the owned object and takes ownership of name instead.
+     */
+    void reset(GLuint name = 0)
+    {
+        if (_name != 0)
+            Traits::destroy(_name);
+        _name = name;
+    }
+
+private:
+    GLuint _name = 0;
+};
+
+struct GLBufferTraits
+{
+    static GLuint create()
+    {
+        GLuint name = 0;
+        glGenBuffers(1, &name);
+        return name;
+    }
+
+    static void destroy(GLuint name) { GLState::deleteBuffers(1, &name); }
+};
+
+struct GLVertexArrayTraits
+{
+    static GLuint create()
+    {
+        GLuint name = 0;
+        glGenVertexArrays(1, &name);
+        return name;
+    }
+
+    static void destroy(GLuint name) { GLState::deleteVertexArrays(1, &name); }
+};
+
+struct GLTextureTraits
+{
+    static GLuint create()
+    {
+        GLuint name = 0;
+        glGenTextures(1, &name);
+        return name;
+    }
+
+    static void destroy(GLuint name) { GLState::deleteTextures(1, &name); }
+};
+
+struct GLProgramTraits
+{
+    static GLuint create() { return glCreateProgram(); }
+    static void destroy(GLuint name) { GLState::deleteProgram(name); }
+};
+
+using GLBuffer = GLHandle<GLBufferTraits>;
+using GLVertexArray = GLHandle<GLVertexArrayTraits>;
+using GLTexture = GLHandle<GLTextureTraits>;
+using GLProgram = GLHandle<GLProgramTraits>;
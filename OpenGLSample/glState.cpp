@@ -0,0 +1,345 @@
+#include <cstring>
+#include <iostream>
+
+#include "glState.h"
+
+GLuint GLState::_program = GLState::UNKNOWN;
+GLuint GLState::_vertexArray = GLState::UNKNOWN;
+GLuint GLState::_buffers[GLState::NUM_BUFFER_TARGETS];
+GLuint GLState::_activeUnit = GLState::UNKNOWN;
+GLuint GLState::_textures2D[GLState::MAX_TEXTURE_UNITS];
+GLuint GLState::_texturesCube[GLState::MAX_TEXTURE_UNITS];
+GLuint GLState::_depthTest = GLState::UNKNOWN;
+GLuint GLState::_blend = GLState::UNKNOWN;
+GLuint GLState::_cullFace = GLState::UNKNOWN;
+GLuint GLState::_polygonOffsetFill = GLState::UNKNOWN;
+GLuint GLState::_depthFunc = GLState::UNKNOWN;
+GLuint GLState::_blendSource = GLState::UNKNOWN;
+GLuint GLState::_blendDestination = GLState::UNKNOWN;
+GLint GLState::_viewport[4] = { -1, -1, -1, -1 };
+GLState::Counter GLState::_counters[GLState::NUM_CATEGORIES];
+std::unordered_map<GLuint, std::vector<GLState::UniformValue>> GLState::_uniforms;
+std::vector<GLState::UniformValue>* GLState::_programUniforms = nullptr;
+
+namespace {
+
+// Static arrays above are zero-initialized, which is a valid GL name, so fill them with UNKNOWN before main runs
+struct InitialState
+{
+	InitialState() { GLState::invalidate(); }
+} initialState;
+
+} // namespace
+
+bool GLState::changed(GLuint& cached, GLuint value, Category category)
+{
+	if (cached == value)
+	{
+		_counters[category].skipped++;
+		return false;
+	}
+
+	cached = value;
+	_counters[category].issued++;
+	return true;
+}
+
+void GLState::useProgram(GLuint program)
+{
+	if (changed(_program, program, PROGRAM))
+	{
+		glUseProgram(program);
+		_programUniforms = &_uniforms[program];
+	}
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (changed(_vertexArray, vao, VERTEX_ARRAY))
+	{
+		glBindVertexArray(vao);
+		_buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	const auto index = bufferTargetIndex(target);
+	if (index < 0)
+	{
+		_counters[BUFFER].issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+
+	if (changed(_buffers[index], buffer, BUFFER)) {
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLState::activeTexture(GLuint unit)
+{
+	if (changed(_activeUnit, unit, ACTIVE_TEXTURE)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	GLuint* slot = nullptr;
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		if (target == GL_TEXTURE_2D) {
+			slot = &_textures2D[unit];
+		}
+		else if (target == GL_TEXTURE_CUBE_MAP) {
+			slot = &_texturesCube[unit];
+		}
+	}
+
+	if (slot == nullptr)
+	{
+		activeTexture(unit);
+		_counters[TEXTURE].issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (*slot == texture)
+	{
+		_counters[TEXTURE].skipped++;
+		return;
+	}
+
+	activeTexture(unit);
+	changed(*slot, texture, TEXTURE);
+	glBindTexture(target, texture);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+	GLuint* slot = capabilitySlot(capability);
+	if (slot != nullptr && !changed(*slot, enabled ? 1 : 0, CAPABILITY)) {
+		return;
+	}
+
+	if (slot == nullptr) {
+		_counters[CAPABILITY].issued++;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	}
+	else {
+		glDisable(capability);
+	}
+}
+
+void GLState::depthFunc(GLenum func)
+{
+	if (changed(_depthFunc, func, DEPTH_FUNC)) {
+		glDepthFunc(func);
+	}
+}
+
+void GLState::blendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (_blendSource == sourceFactor && _blendDestination == destinationFactor)
+	{
+		_counters[BLEND_FUNC].skipped++;
+		return;
+	}
+
+	_blendSource = sourceFactor;
+	_blendDestination = destinationFactor;
+	_counters[BLEND_FUNC].issued++;
+	glBlendFunc(sourceFactor, destinationFactor);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (_viewport[0] == x && _viewport[1] == y && _viewport[2] == width && _viewport[3] == height)
+	{
+		_counters[VIEWPORT].skipped++;
+		return;
+	}
+
+	_viewport[0] = x;
+	_viewport[1] = y;
+	_viewport[2] = width;
+	_viewport[3] = height;
+	_counters[VIEWPORT].issued++;
+	glViewport(x, y, width, height);
+}
+
+bool GLState::uniformChanged(GLint location, GLuint bits)
+{
+	if (location < 0) {
+		return false;
+	}
+	if (_programUniforms == nullptr)
+	{
+		_counters[UNIFORM].issued++;
+		return true;
+	}
+
+	if ((size_t)location >= _programUniforms->size()) {
+		_programUniforms->resize(location + 1);
+	}
+	UniformValue& cached = (*_programUniforms)[location];
+	if (cached.known && cached.bits == bits)
+	{
+		_counters[UNIFORM].skipped++;
+		return false;
+	}
+
+	cached.known = true;
+	cached.bits = bits;
+	_counters[UNIFORM].issued++;
+	return true;
+}
+
+void GLState::uniform1i(GLint location, GLint value)
+{
+	GLuint bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	if (uniformChanged(location, bits)) {
+		glUniform1i(location, value);
+	}
+}
+
+void GLState::uniform1f(GLint location, GLfloat value)
+{
+	GLuint bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	if (uniformChanged(location, bits)) {
+		glUniform1f(location, value);
+	}
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	for (auto i = 0; i < count; i++)
+	{
+		for (auto& bound : _buffers)
+		{
+			if (bound == buffers[i]) {
+				bound = UNKNOWN;
+			}
+		}
+	}
+	glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vaos)
+{
+	for (auto i = 0; i < count; i++)
+	{
+		if (_vertexArray == vaos[i]) {
+			_vertexArray = UNKNOWN;
+		}
+	}
+	glDeleteVertexArrays(count, vaos);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures)
+{
+	for (auto i = 0; i < count; i++)
+	{
+		for (auto unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+		{
+			if (_textures2D[unit] == textures[i]) {
+				_textures2D[unit] = UNKNOWN;
+			}
+			if (_texturesCube[unit] == textures[i]) {
+				_texturesCube[unit] = UNKNOWN;
+			}
+		}
+	}
+	glDeleteTextures(count, textures);
+}
+
+void GLState::deleteProgram(GLuint program)
+{
+	if (_program == program)
+	{
+		_program = UNKNOWN;
+		_programUniforms = nullptr;
+	}
+	_uniforms.erase(program);
+	glDeleteProgram(program);
+}
+
+void GLState::invalidate()
+{
+	_program = UNKNOWN;
+	_programUniforms = nullptr;
+	_uniforms.clear();
+	_vertexArray = UNKNOWN;
+	for (auto& buffer : _buffers) {
+		buffer = UNKNOWN;
+	}
+	_activeUnit = UNKNOWN;
+	for (auto unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+	{
+		_textures2D[unit] = UNKNOWN;
+		_texturesCube[unit] = UNKNOWN;
+	}
+	_depthTest = _blend = _cullFace = _polygonOffsetFill = UNKNOWN;
+	_depthFunc = UNKNOWN;
+	_blendSource = _blendDestination = UNKNOWN;
+	for (auto& value : _viewport) {
+		value = -1;
+	}
+}
+
+const GLState::Counter& GLState::getCounter(Category category)
+{
+	return _counters[category];
+}
+
+void GLState::resetCounters()
+{
+	for (auto& counter : _counters) {
+		counter = Counter();
+	}
+}
+
+void GLState::printCounters()
+{
+	static const char* names[NUM_CATEGORIES] = {
+		"program", "vertex array", "buffer", "active texture", "texture",
+		"capability", "depth func", "blend func", "viewport", "uniform"
+	};
+
+	std::cout << "===== GL state calls (issued / skipped) =====" << std::endl;
+	for (auto i = 0; i < NUM_CATEGORIES; i++) {
+		std::cout << names[i] << ": " << _counters[i].issued << " / " << _counters[i].skipped << std::endl;
+	}
+}
+
+int GLState::bufferTargetIndex(GLenum target)
+{
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_ELEMENT_ARRAY_BUFFER: return 1;
+		case GL_UNIFORM_BUFFER: return 2;
+		case GL_DRAW_INDIRECT_BUFFER: return 3;
+		case GL_SHADER_STORAGE_BUFFER: return 4;
+		case GL_COPY_WRITE_BUFFER: return 5;
+		default: return -1;
+	}
+}
+
+GLuint* GLState::capabilitySlot(GLenum capability)
+{
+	switch (capability)
+	{
+		case GL_DEPTH_TEST: return &_depthTest;
+		case GL_BLEND: return &_blend;
+		case GL_CULL_FACE: return &_cullFace;
+		case GL_POLYGON_OFFSET_FILL: return &_polygonOffsetFill;
+		default: return nullptr;
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// STL
+#include <unordered_map>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Thin shadow of the OpenGL binding state. Every bind / enable in the project goes through here,
+ * so calls that would not change anything never reach the driver.
+ *
+ * State changed behind its back (third-party code, direct GL calls) must be followed by invalidate().
+ */
+class GLState
+{
+public:
+    /**
+     * Categories of state changes tracked by the counters.
+     */
+    enum Category
+    {
+        PROGRAM = 0,
+        VERTEX_ARRAY,
+        BUFFER,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        CAPABILITY,
+        DEPTH_FUNC,
+        BLEND_FUNC,
+        VIEWPORT,
+        UNIFORM,
+        NUM_CATEGORIES
+    };
+
+    /**
+     * Issued / skipped call counters of one category.
+     */
+    struct Counter
+    {
+        unsigned int issued = 0;
+        unsigned int skipped = 0;
+    };
+
+    /**
+     * Binds shader program (glUseProgram).
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * Binds vertex array object. Also forgets the element buffer binding, as that is part of VAO state.
+     */
+    static void bindVertexArray(GLuint vao);
+
+    /**
+     * Binds buffer to the given target. Targets that are not tracked are passed through.
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Selects active texture unit.
+     *
+     * @param unit  Zero based unit index (not GL_TEXTURE0 + unit)
+     */
+    static void activeTexture(GLuint unit);
+
+    /**
+     * Binds texture to the given unit, switching active unit only when needed.
+     *
+     * @param unit     Zero based unit index
+     * @param target   GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP (other targets are passed through)
+     * @param texture  Texture name
+     */
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /**
+     * Enables / disables capability. GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE and
+     * GL_POLYGON_OFFSET_FILL are tracked, the rest is passed through.
+     */
+    static void setEnabled(GLenum capability, bool enabled);
+
+    static void depthFunc(GLenum func);
+    static void blendFunc(GLenum sourceFactor, GLenum destinationFactor);
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Sets int / float uniform of the current program, skipped when the program already holds the value.
+     * Values are remembered per program, so a uniform set through here must not also be set directly.
+     * Location -1 (not in the program) is ignored.
+     */
+    static void uniform1i(GLint location, GLint value);
+    static void uniform1f(GLint location, GLfloat value);
+
+    /**
+     * Deletes GL objects and forgets them in the cache, so that a recycled name gets bound again.
+     */
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+    static void deleteVertexArrays(GLsizei count, const GLuint* vaos);
+    static void deleteTextures(GLsizei count, const GLuint* textures);
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Marks whole cached state as unknown, next call of every kind is issued.
+     */
+    static void invalidate();
+
+    /**
+     * Gets counters of given category since last resetCounters().
+     */
+    static const Counter& getCounter(Category category);
+
+    /**
+     * Resets all counters (typically once per frame).
+     */
+    static void resetCounters();
+
+    /**
+     * Prints issued / skipped counters of all categories to the standard output.
+     */
+    static void printCounters();
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFF; // Value of state, that has not been set through the cache yet
+    static const int MAX_TEXTURE_UNITS = 32; // How many texture units are tracked
+    static const int NUM_BUFFER_TARGETS = 6; // Number of tracked buffer targets
+
+    static GLuint _program;
+    static GLuint _vertexArray;
+    static GLuint _buffers[NUM_BUFFER_TARGETS];
+    static GLuint _activeUnit;
+    static GLuint _textures2D[MAX_TEXTURE_UNITS];
+    static GLuint _texturesCube[MAX_TEXTURE_UNITS];
+    static GLuint _depthTest, _blend, _cullFace, _polygonOffsetFill;
+    static GLuint _depthFunc;
+    static GLuint _blendSource, _blendDestination;
+    static GLint _viewport[4];
+    static Counter _counters[NUM_CATEGORIES];
+
+    /**
+     * Last value set through the cache, int or float bits.
+     */
+    struct UniformValue
+    {
+        bool known = false;
+        GLuint bits = 0;
+    };
+
+    static std::unordered_map<GLuint, std::vector<UniformValue>> _uniforms; // by program, indexed by location
+    static std::vector<UniformValue>* _programUniforms; // uniforms of _program, null while it is unknown
+
+    static int bufferTargetIndex(GLenum target);
+    static GLuint* capabilitySlot(GLenum capability);
+    static bool changed(GLuint& cached, GLuint value, Category category);
+    static bool uniformChanged(GLint location, GLuint bits);
+};
@@ -0,0 +1,328 @@
+#ifdef _WIN32
+#define _USE_MATH_DEFINES // for C++
+#include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
+#endif
+
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include "icosphere.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+// 12 vertices of an icosahedron on the unit sphere (golden ratio rectangles)
+// and its 20 counter-clockwise faces
+const float ICOSAHEDRON_A = 0.525731112f;  // 1 / sqrt(1 + phi^2)
+const float ICOSAHEDRON_B = 0.850650808f;  // phi / sqrt(1 + phi^2)
+const float ICOSAHEDRON_VERTICES[12][3] = {
+    { -ICOSAHEDRON_A,  ICOSAHEDRON_B, 0 }, {  ICOSAHEDRON_A,  ICOSAHEDRON_B, 0 },
+    { -ICOSAHEDRON_A, -ICOSAHEDRON_B, 0 }, {  ICOSAHEDRON_A, -ICOSAHEDRON_B, 0 },
+    { 0, -ICOSAHEDRON_A,  ICOSAHEDRON_B }, { 0,  ICOSAHEDRON_A,  ICOSAHEDRON_B },
+    { 0, -ICOSAHEDRON_A, -ICOSAHEDRON_B }, { 0,  ICOSAHEDRON_A, -ICOSAHEDRON_B },
+    {  ICOSAHEDRON_B, 0, -ICOSAHEDRON_A }, {  ICOSAHEDRON_B, 0,  ICOSAHEDRON_A },
+    { -ICOSAHEDRON_B, 0, -ICOSAHEDRON_A }, { -ICOSAHEDRON_B, 0,  ICOSAHEDRON_A }
+};
+const unsigned int ICOSAHEDRON_FACES[20][3] = {
+    { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+    { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+    { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+    { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+};
+
+// largest triangle circumradius (radians) is 0.6524 for the icosahedron, finer
+// levels approach 0.764 / 2^level from below (measured up to level 6)
+const float LEVEL0_CIRCUMRADIUS = 0.6524f;
+const float CIRCUMRADIUS_SCALE = 0.764f;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// key of an undirected edge for hash maps
+///////////////////////////////////////////////////////////////////////////////
+static unsigned long long edgeKey(unsigned int i1, unsigned int i2)
+{
+    return i1 < i2 ? ((unsigned long long)i1 << 32) | i2 : ((unsigned long long)i2 << 32) | i1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// vertices on the z axis have no longitude, their s is taken per triangle
+///////////////////////////////////////////////////////////////////////////////
+static bool isPole(const float* position)
+{
+    return position[0] * position[0] + position[1] * position[1] < 1e-8f;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tex coords of one triangle, unwrapped so they do not jump across the seam
+// at s = 0/1; wrapped[i] tells which corners got s + 1
+///////////////////////////////////////////////////////////////////////////////
+static void unwrapTexCoords(const bool pole[3], float s[3], bool wrapped[3])
+{
+    float minS = 1, maxS = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        wrapped[i] = false;
+        if (pole[i])
+            continue;
+        minS = s[i] < minS ? s[i] : minS;
+        maxS = s[i] > maxS ? s[i] : maxS;
+    }
+
+    if (maxS - minS > 0.5f)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!pole[i] && s[i] < 0.5f)
+            {
+                s[i] += 1;
+                wrapped[i] = true;
+            }
+        }
+    }
+
+    // pole takes the middle of the other 2 corners
+    for (int i = 0; i < 3; ++i)
+    {
+        if (pole[i])
+            s[i] = (s[(i + 1) % 3] + s[(i + 2) % 3]) * 0.5f;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+Icosphere::Icosphere(float radius, int subdivision, bool smooth) : SphereMesh("Icosphere")
+{
+    set(radius, subdivision, smooth);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// tessellation estimates
+///////////////////////////////////////////////////////////////////////////////
+int Icosphere::getSubdivisionForError(float radius, float maxError)
+{
+    const float angle = getAngleForError(radius, maxError);
+    if (LEVEL0_CIRCUMRADIUS <= angle)
+        return 0;
+
+    for (int level = 1; level < MAX_SUBDIVISION; ++level)
+    {
+        if (CIRCUMRADIUS_SCALE / (1 << level) <= angle)
+            return level;
+    }
+    return MAX_SUBDIVISION;
+}
+
+unsigned int Icosphere::getTriangleCountForError(float radius, float maxError)
+{
+    return getTriangleCount(getSubdivisionForError(radius, maxError));
+}
+
+unsigned int Icosphere::getTriangleCount(int subdivision)
+{
+    return 20u << (2 * subdivision);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build vertices with smooth shading
+// vertices are shared, except along the tex coord seam (they get a copy with
+// s + 1) and at the poles (a copy per triangle)
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildVerticesSmooth()
+{
+    std::vector<float> positions;
+    std::vector<unsigned int> triangles;
+    buildUnitIcosphere(positions, triangles);
+
+    const std::size_t vertexCount = positions.size() / 3;
+    const std::size_t triangleCount = triangles.size() / 3;
+    reserveArrays(vertexCount + vertexCount / 8, triangles.size(), triangleCount * 3);
+
+    float s, t;
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = &positions[i * 3];
+        computeTexCoord(p, s, t);
+        addVertex(radius * p[0], radius * p[1], radius * p[2], p[0], p[1], p[2], s, t);
+    }
+
+    std::unordered_map<unsigned int, unsigned int> seamCopies;
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        unsigned int corners[3];
+        bool pole[3], wrapped[3];
+        float ts[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            corners[k] = triangles[i * 3 + k];
+            pole[k] = isPole(&positions[corners[k] * 3]);
+            ts[k] = texCoords[corners[k] * 2];
+        }
+        unwrapTexCoords(pole, ts, wrapped);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const float* p = &positions[triangles[i * 3 + k] * 3];
+            const float tt = texCoords[triangles[i * 3 + k] * 2 + 1];
+            if (wrapped[k])
+            {
+                auto copy = seamCopies.find(corners[k]);
+                if (copy == seamCopies.end())
+                {
+                    copy = seamCopies.emplace(corners[k], getVertexCount()).first;
+                    addVertex(radius * p[0], radius * p[1], radius * p[2], p[0], p[1], p[2], ts[k], tt);
+                }
+                corners[k] = copy->second;
+            }
+            else if (pole[k])
+            {
+                corners[k] = getVertexCount();
+                addVertex(radius * p[0], radius * p[1], radius * p[2], p[0], p[1], p[2], ts[k], tt);
+            }
+        }
+        addIndices(corners[0], corners[1], corners[2]);
+    }
+
+    buildLineIndices(triangles, indices.data());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// generate vertices with flat shading
+// each triangle is independent (no shared vertices)
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildVerticesFlat()
+{
+    std::vector<float> positions;
+    std::vector<unsigned int> triangles;
+    buildUnitIcosphere(positions, triangles);
+
+    const std::size_t triangleCount = triangles.size() / 3;
+    reserveArrays(triangles.size(), triangles.size(), triangleCount * 3);
+
+    for (std::size_t i = 0; i < triangleCount; ++i)
+    {
+        const float* p[3];
+        bool pole[3], wrapped[3];
+        float s[3], t[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            p[k] = &positions[triangles[i * 3 + k] * 3];
+            pole[k] = isPole(p[k]);
+            computeTexCoord(p[k], s[k], t[k]);
+        }
+        unwrapTexCoords(pole, s, wrapped);
+
+        float n[3];
+        computeFaceNormal(p[0], p[1], p[2], n);
+
+        unsigned int index = getVertexCount();
+        for (int k = 0; k < 3; ++k)
+            addVertex(radius * p[k][0], radius * p[k][1], radius * p[k][2], n[0], n[1], n[2], s[k], t[k]);
+        addIndices(index, index + 1, index + 2);
+    }
+
+    buildLineIndices(triangles, indices.data());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// subdivide the icosahedron on the unit sphere
+// positions: x,y,z of shared vertices, triangles: 3 indices per triangle
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildUnitIcosphere(std::vector<float>& positions, std::vector<unsigned int>& triangles) const
+{
+    // V = 10 * 4^n + 2, F = 20 * 4^n
+    positions.reserve(((std::size_t)10 * (1 << (2 * subdivision)) + 2) * 3);
+    triangles.reserve((std::size_t)getTriangleCount(subdivision) * 3);
+
+    positions.assign(&ICOSAHEDRON_VERTICES[0][0], &ICOSAHEDRON_VERTICES[0][0] + 12 * 3);
+    triangles.assign(&ICOSAHEDRON_FACES[0][0], &ICOSAHEDRON_FACES[0][0] + 20 * 3);
+
+    std::vector<unsigned int> coarse;
+    std::unordered_map<unsigned long long, unsigned int> midpoints;
+    for (int level = 0; level < subdivision; ++level)
+    {
+        coarse.swap(triangles);
+        triangles.clear();
+        midpoints.clear();
+        midpoints.reserve(coarse.size() / 2);     // E = 3/2 F
+
+        // new vertex in the middle of an edge, pushed onto the sphere; shared by both triangles of the edge
+        auto midpoint = [&](unsigned int i1, unsigned int i2)
+        {
+            auto inserted = midpoints.emplace(edgeKey(i1, i2), (unsigned int)(positions.size() / 3));
+            if (inserted.second)
+            {
+                float x = positions[i1 * 3] + positions[i2 * 3];
+                float y = positions[i1 * 3 + 1] + positions[i2 * 3 + 1];
+                float z = positions[i1 * 3 + 2] + positions[i2 * 3 + 2];
+                float scale = 1.0f / sqrtf(x * x + y * y + z * z);
+                positions.push_back(x * scale);
+                positions.push_back(y * scale);
+                positions.push_back(z * scale);
+            }
+            return inserted.first->second;
+        };
+
+        // every triangle v1-v2-v3 is split into 4, n1/n2/n3 are the midpoints of v1-v2, v2-v3, v3-v1
+        for (std::size_t i = 0; i < coarse.size(); i += 3)
+        {
+            unsigned int v1 = coarse[i], v2 = coarse[i + 1], v3 = coarse[i + 2];
+            unsigned int n1 = midpoint(v1, v2);
+            unsigned int n2 = midpoint(v2, v3);
+            unsigned int n3 = midpoint(v3, v1);
+            unsigned int split[] = { v1, n1, n3,  n1, v2, n2,  n1, n2, n3,  n3, n2, v3 };
+            triangles.insert(triangles.end(), split, split + 12);
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one line per edge of the shared topology
+// corners: vertex index of each triangle corner in the final arrays
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildLineIndices(const std::vector<unsigned int>& triangles, const unsigned int* corners)
+{
+    std::unordered_set<unsigned long long> edges;
+    edges.reserve(triangles.size() / 2);
+    for (std::size_t i = 0; i < triangles.size(); i += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            std::size_t k2 = i + (k + 1) % 3;
+            if (edges.insert(edgeKey(triangles[i + k], triangles[k2])).second)
+                addLineIndices(corners[i + k], corners[k2]);
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// spherical tex coords with the same layout as Sphere
+// s: longitude around z from +x [0, 1), t: 0 at north pole (+z), 1 at south
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::computeTexCoord(const float* position, float& s, float& t)
+{
+    const float PI = acos(-1);
+
+    s = atan2f(position[1], position[0]) / (2 * PI);
+    if (s < 0)
+        s += 1;
+
+    float z = position[2];
+    z = z > 1 ? 1 : (z < -1 ? -1 : z);
+    t = acosf(z) / PI;
+}
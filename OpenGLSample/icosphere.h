@@ -0,0 +1,31 @@
+#ifndef GEOMETRY_ICOSPHERE_H
+#define GEOMETRY_ICOSPHERE_H
+
+#include "sphereMesh.h"
+
+// Sphere made by subdividing an icosahedron: each level splits every triangle
+// into 4 and pushes the new vertices onto the sphere, so triangles stay
+// almost equilateral and evenly spread (no crowding at the poles like Sphere)
+// triangle count = 20 * 4^subdivision
+class Icosphere : public SphereMesh
+{
+public:
+    Icosphere(float radius = 1.0f, int subdivision = 3, bool smooth = true);
+
+    // tessellation estimates for a silhouette error (max distance between the mesh and the true sphere)
+    static int getSubdivisionForError(float radius, float maxError);
+    static unsigned int getTriangleCountForError(float radius, float maxError);
+    static unsigned int getTriangleCount(int subdivision);
+    using SphereMesh::getTriangleCount;
+
+protected:
+    void buildVerticesSmooth() override;
+    void buildVerticesFlat() override;
+
+private:
+    void buildUnitIcosphere(std::vector<float>& positions, std::vector<unsigned int>& triangles) const;
+    void buildLineIndices(const std::vector<unsigned int>& triangles, const unsigned int* corners);
+    static void computeTexCoord(const float* position, float& s, float& t);
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h> // holds all OpenGL type declarations
+
+#include "shader.h"
+#include "glState.h"
+
+#include <string>
+#include <vector>
+
+// a texture as loaded for a mesh, type is one of texture_diffuse/specular/normal/height
+struct Texture {
+	unsigned int id;
+	std::string type;
+	std::string path;
+};
+
+// a float uniform owned by the material (shininess, roughness...)
+struct MaterialParameter {
+	std::string name;
+	float value;
+};
+
+// Everything a mesh needs to bind before drawing, worked out once when the mesh is loaded:
+// sampler uniform names and texture units are fixed in the constructor, uniform locations are
+// looked up once per program (prepare), which also sets the sampler units in that program.
+// Binding afterwards does no allocations and no string handling, and uniform values go through
+// GLState, so only the ones that differ from what the program holds reach the driver.
+class Material {
+public:
+	Material() {}
+
+	// assigns texture units in order and builds the sampler names (texture_diffuseN, texture_specularN...)
+	Material(const std::vector<Texture>& textures, const std::vector<MaterialParameter>& parameters = {})
+	{
+		unsigned int diffuseNr = 1;
+		unsigned int specularNr = 1;
+		unsigned int normalNr = 1;
+		unsigned int heightNr = 1;
+		samplers.reserve(textures.size());
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			std::string name = textures[i].type;
+			if (name == "texture_diffuse")
+				name += std::to_string(diffuseNr++);
+			else if (name == "texture_specular")
+				name += std::to_string(specularNr++);
+			else if (name == "texture_normal")
+				name += std::to_string(normalNr++);
+			else if (name == "texture_height")
+				name += std::to_string(heightNr++);
+
+			samplers.push_back({ name, textures[i].id, i });
+		}
+
+		floats.reserve(parameters.size());
+		for (const auto& parameter : parameters)
+			floats.push_back({ parameter.name, parameter.value });
+	}
+
+	// looks up the uniform locations in the shader's program and points its samplers at the material's
+	// texture units; call it at load time for every program the material will be drawn with (bind does
+	// it on first use otherwise). Leaves the program in use.
+	void prepare(const Shader& shader)
+	{
+		findProgram(shader.ID);
+	}
+
+	// binds textures and uploads parameters for the given (already used) shader
+	void bind(const Shader& shader)
+	{
+		const ProgramBinding& program = findProgram(shader.ID);
+
+		for (size_t i = 0; i < samplers.size(); i++)
+		{
+			// units were set by prepare, this only sends one if another material moved the sampler
+			GLState::uniform1i(program.samplerLocations[i], (GLint)samplers[i].unit);
+			GLState::bindTexture(samplers[i].unit, GL_TEXTURE_2D, samplers[i].texture);
+		}
+		for (size_t i = 0; i < floats.size(); i++)
+			GLState::uniform1f(program.floatLocations[i], floats[i].value);
+	}
+
+	// changes a parameter value, returns false if the material has no such parameter
+	bool setParameter(const std::string& name, float value)
+	{
+		for (auto& parameter : floats)
+		{
+			if (parameter.name == name)
+			{
+				parameter.value = value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	unsigned int getTextureCount() const { return (unsigned int)samplers.size(); }
+
+	// ShaderVariants key of the program the material draws with (the #defines its textures and parameters need),
+	// worked out by the loader; 0 when the material is drawn with a plain Shader
+	unsigned int variantKey = 0;
+
+private:
+	struct SamplerBinding {
+		std::string name;
+		unsigned int texture;
+		unsigned int unit;
+	};
+	struct FloatBinding {
+		std::string name;
+		float value;
+	};
+	// uniform locations in one program, in the order of samplers / floats
+	struct ProgramBinding {
+		unsigned int program;
+		std::vector<GLint> samplerLocations;
+		std::vector<GLint> floatLocations;
+	};
+
+	std::vector<SamplerBinding> samplers;
+	std::vector<FloatBinding> floats;
+	std::vector<ProgramBinding> programs;	// usually one, a few with shader variants
+	size_t lastProgram = 0;
+
+	// locations in the given program, looked up (and sampler units set) the first time it is seen
+	const ProgramBinding& findProgram(unsigned int program)
+	{
+		if (lastProgram < programs.size() && programs[lastProgram].program == program)
+			return programs[lastProgram];
+		for (lastProgram = 0; lastProgram < programs.size(); lastProgram++)
+		{
+			if (programs[lastProgram].program == program)
+				return programs[lastProgram];
+		}
+
+		ProgramBinding binding;
+		binding.program = program;
+		binding.samplerLocations.reserve(samplers.size());
+		for (const auto& sampler : samplers)
+			binding.samplerLocations.push_back(glGetUniformLocation(program, sampler.name.c_str()));
+		binding.floatLocations.reserve(floats.size());
+		for (const auto& parameter : floats)
+			binding.floatLocations.push_back(glGetUniformLocation(program, parameter.name.c_str()));
+
+		GLState::useProgram(program);
+		for (size_t i = 0; i < samplers.size(); i++)
+			GLState::uniform1i(binding.samplerLocations[i], (GLint)samplers[i].unit);
+
+		programs.push_back(std::move(binding));
+		lastProgram = programs.size() - 1;
+		return programs.back();
+	}
+};
+#endif
@@ -5,10 +5,19 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include "shader.h"
+#include "glState.h"
+#include "glHandle.h"
+#include "material.h"
+#include "qtangent.h"
+#include "meshSimplifier.h"
+#include "meshlets.h"
 
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -25,91 +34,217 @@ struct Vertex {
 	glm::vec3 Bitangent;
 };
 
-struct Texture {
-	unsigned int id;
-	string type;
-	string path;
+// compact vertex for normal-mapped meshes, 28 bytes instead of 56
+struct CompactVertex {
+	// position
+	glm::vec3 Position;
+	// whole tangent frame as one quaternion, 4 x snorm16 (see qtangent.h)
+	glm::i16vec4 QTangent;
+	// texCoords, kept as floats: halfs lose texel precision on tiled coords far from 0
+	glm::vec2 TexCoords;
+};
+static_assert(sizeof(CompactVertex) == 28, "CompactVertex must stay tightly packed");
+
+// which vertex format a mesh uploads
+enum class VertexFormat {
+	// Vertex: position 0, normal 1, texCoords 2, tangent 3, bitangent 4
+	Full,
+	// CompactVertex: position 0, QTangent 1 (vec4), texCoords 2 - shaders need USE_QTANGENT
+	// or NormalMappingQTangent.vertexshader
+	QTangent
 };
 
+// converts full vertices to the compact format
+inline vector<CompactVertex> compactVertices(const vector<Vertex>& vertices)
+{
+	vector<CompactVertex> result(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		result[i].Position = vertex.Position;
+		result[i].QTangent = packQTangent(encodeQTangent(vertex.Normal, vertex.Tangent, vertex.Bitangent));
+		result[i].TexCoords = vertex.TexCoords;
+	}
+	return result;
+}
+
+// owns its GL objects, so a mesh can be moved (e.g. into a vector of meshes) but not copied
 class Mesh {
 public:
 	// mesh Data
 	vector<Vertex>       vertices;
 	vector<unsigned int> indices;
 	vector<Texture>      textures;
-	unsigned int VAO;
+	Material             material;
+	GLVertexArray        VAO;
+	VertexFormat         format;
 
-	// constructor
-	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+	// constructor, takes over the loaded data instead of copying it
+	Mesh(vector<Vertex>&& vertices, vector<unsigned int>&& indices, vector<Texture>&& textures,
+		VertexFormat format = VertexFormat::Full)
+		: vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)), material(this->textures),
+		format(format)
 	{
-		this->vertices = vertices;
-		this->indices = indices;
-		this->textures = textures;
+		this->lods.push_back({ 0, (GLsizei)this->indices.size() });
+		this->lodErrors.push_back(0.0f);
 
 		// now that we have all the required data, set the vertex buffers and its attribute pointers.
 		setupMesh();
 	}
 
-	// render the mesh
-	void Draw(Shader &shader)
+	// frees the vertex and index data once they are on the GPU, if nothing needs them on the CPU anymore
+	void releaseCpuData()
+	{
+		vector<Vertex>().swap(vertices);
+		vector<unsigned int>().swap(indices);
+	}
+
+	// vertex data as the simplifier reads it, valid until releaseCpuData
+	SimplifyVertices simplifyVertices() const
+	{
+		SimplifyVertices result;
+		if (!vertices.empty())
+		{
+			result.positions = &vertices[0].Position.x;
+			result.normals = &vertices[0].Normal.x;
+			result.uvs = &vertices[0].TexCoords.x;
+		}
+		result.strideBytes = sizeof(Vertex);
+		result.vertexCount = (unsigned int)vertices.size();
+		return result;
+	}
+
+	// builds levels of detail from the CPU data, see generateLods below to do several meshes at once
+	void generateLods(const LodChainOptions& options = LodChainOptions())
+	{
+		if (vertices.empty() || indices.empty())
+			return; // no CPU data, e.g. after releaseCpuData
+		setLods(generateLodChain(indices, simplifyVertices(), options));
+	}
+
+	// uploads a chain from generateLodChain(s): all levels go to the element buffer one after the other and share
+	// the vertex buffer. Level 0 must be the full mesh, it stays in indices.
+	void setLods(const vector<MeshLod>& chain)
+	{
+		if (chain.empty())
+			return;
+
+		lods.clear();
+		lodErrors.clear();
+		vector<unsigned int> allIndices;
+		for (const MeshLod& lod : chain)
+		{
+			lods.push_back({ (GLsizei)allIndices.size(), (GLsizei)lod.indices.size() });
+			lodErrors.push_back(lod.error);
+			allIndices.insert(allIndices.end(), lod.indices.begin(), lod.indices.end());
+		}
+
+		GLState::bindVertexArray(VAO.get());
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), allIndices.data(), GL_STATIC_DRAW);
+		GLState::bindVertexArray(0);
+	}
+
+	unsigned int lodCount() const { return (unsigned int)lods.size(); }
+
+	// coarsest level that stays under maxPixelError on screen, distance in model units (see selectLod)
+	unsigned int selectLod(float distance, float projectionScale, float maxPixelError = 1.0f) const
+	{
+		return ::selectLod(lodErrors, distance, projectionScale, maxPixelError);
+	}
+
+	// splits the full mesh into meshlets for DrawCulled, reordering indices. Drops levels of detail, build them
+	// after (they keep the full mesh as is, so the meshlets stay valid).
+	void buildMeshlets(unsigned int maxVertices = 64, unsigned int maxTriangles = 124)
+	{
+		if (vertices.empty() || indices.empty())
+			return;
+		meshlets = ::buildMeshlets(indices, &vertices.front().Position.x, sizeof(Vertex), (unsigned int)vertices.size(),
+			maxVertices, maxTriangles);
+
+		vector<MeshLod> fullMesh(1);
+		fullMesh[0].indices = indices;
+		setLods(fullMesh);
+
+		if (supportsIndirectDraw() && !indirectBuffer)
+			indirectBuffer = GLBuffer::create();
+	}
+
+	// render the full mesh without the meshlets outside the view frustum or facing away from the camera,
+	// everything when there are no meshlets
+	MeshletCullStats DrawCulled(Shader &shader, const glm::mat4& model, const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition)
 	{
-		// bind appropriate textures
-		unsigned int diffuseNr = 1;
-		unsigned int specularNr = 1;
-		unsigned int normalNr = 1;
-		unsigned int heightNr = 1;
-		for (unsigned int i = 0; i < textures.size(); i++)
+		if (meshlets.empty())
 		{
-			glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-			// retrieve texture number (the N in diffuse_textureN)
-			string number;
-			string name = textures[i].type;
-			if (name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if (name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
-			else if (name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-			else if (name == "texture_height")
-				number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-			// now set the sampler to the correct texture unit
-			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-			// and finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			Draw(shader);
+			return MeshletCullStats();
 		}
 
-		// draw mesh
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+		// culling works in model space, where the bounds are
+		const glm::vec3 cameraInModel = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+		const MeshletCullStats stats = cullMeshlets(meshlets, viewProjection * model, cameraInModel, drawCommandList);
+		if (drawCommandList.empty())
+			return stats;
 
-		// always good practice to set everything back to defaults once configured.
-		glActiveTexture(GL_TEXTURE0);
+		material.bind(shader);
+		GLState::bindVertexArray(VAO.get());
+		drawCommands(drawCommandList, indirectBuffer.get());
+		return stats;
+	}
+
+	// render the mesh, at the given level of detail
+	void Draw(Shader &shader, unsigned int lod = 0)
+	{
+		// bind textures and material parameters (no string work here, see Material)
+		material.bind(shader);
+
+		// draw mesh; no need to reset bindings afterwards, everyone binds through GLState
+		const LodRange& range = lods[std::min<size_t>(lod, lods.size() - 1)];
+		GLState::bindVertexArray(VAO.get());
+		glDrawElements(GL_TRIANGLES, range.count, GL_UNSIGNED_INT, (void*)(range.first * sizeof(unsigned int)));
 	}
 
 private:
+	// indices of one level of detail in the element buffer
+	struct LodRange {
+		GLsizei first;
+		GLsizei count;
+	};
+
 	// render data 
-	unsigned int VBO, EBO;
+	GLBuffer VBO, EBO;
+	vector<LodRange> lods;
+	vector<float> lodErrors;
+
+	// meshlets of the full mesh and the per frame draw commands of the visible ones
+	vector<Meshlet> meshlets;
+	vector<DrawElementsCommand> drawCommandList;
+	GLBuffer indirectBuffer;
 
 	// initializes all the buffer objects/arrays
 	void setupMesh()
 	{
 		// create buffers/arrays
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
+		VAO = GLVertexArray::create();
+		VBO = GLBuffer::create();
+		EBO = GLBuffer::create();
 
-		glBindVertexArray(VAO);
+		GLState::bindVertexArray(VAO.get());
 		// load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, VBO.get());
+		if (format == VertexFormat::QTangent)
+		{
+			setupCompactVertices();
+			return;
+		}
 		// A great thing about structs is that their memory layout is sequential for all its items.
 		// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
 		// again translates to 3/2 floats which translates to a byte array.
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
 		// set the vertex attribute pointers
 		// vertex Positions
@@ -128,7 +263,45 @@ private:
 		glEnableVertexAttribArray(4);
 		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
-		glBindVertexArray(0);
+		GLState::bindVertexArray(0);
+	}
+
+	// uploads vertices and sets the attribute pointers in the compact format, VAO and VBO must be bound
+	void setupCompactVertices()
+	{
+		const vector<CompactVertex> compact = compactVertices(vertices);
+		glBufferData(GL_ARRAY_BUFFER, compact.size() * sizeof(CompactVertex), compact.data(), GL_STATIC_DRAW);
+
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+		// vertex Positions
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)0);
+		// vertex tangent frames, normalized to [-1, 1]
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, QTangent));
+		// vertex texture coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, TexCoords));
+
+		GLState::bindVertexArray(0);
 	}
 };
+
+// builds the levels of detail of several meshes (e.g. the submeshes of a model), one mesh per thread at a time
+inline void generateLods(vector<Mesh>& meshes, const LodChainOptions& options = LodChainOptions(), unsigned int numThreads = 0)
+{
+	vector<LodChainInput> inputs(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		inputs[i].indices = &meshes[i].indices;
+		inputs[i].vertices = meshes[i].simplifyVertices();
+	}
+
+	// GL uploads stay on this thread
+	const vector<vector<MeshLod>> chains = generateLodChains(inputs, options, numThreads);
+	for (size_t i = 0; i < meshes.size(); i++)
+		meshes[i].setLods(chains[i]);
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,419 @@
+// STL
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "meshOptimizer.h"
+
+namespace {
+
+	const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	/**
+	 * Vertex -> triangles adjacency in compressed form (offsets + one flat array).
+	 */
+	struct TriangleAdjacency
+	{
+		std::vector<unsigned int> counts;
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		TriangleAdjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+			: counts(vertexCount, 0)
+			, offsets(vertexCount, 0)
+			, triangles(indices.size())
+		{
+			for (auto index : indices) {
+				counts[index]++;
+			}
+
+			unsigned int offset = 0;
+			for (unsigned int i = 0; i < vertexCount; i++)
+			{
+				offsets[i] = offset;
+				offset += counts[i];
+			}
+
+			std::vector<unsigned int> fill(offsets);
+			for (size_t i = 0; i < indices.size(); i++) {
+				triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+			}
+		}
+	};
+
+	/**
+	 * FIFO cache simulation, a vertex is in the cache if fewer than cacheSize misses happened since it was loaded.
+	 */
+	struct FifoCache
+	{
+		std::vector<unsigned int> timestamps;
+		unsigned int time;
+		unsigned int size;
+
+		FifoCache(unsigned int vertexCount, unsigned int cacheSize)
+			: timestamps(vertexCount, 0)
+			, time(cacheSize + 1)
+			, size(cacheSize) {}
+
+		// returns number of misses caused by the triangle
+		unsigned int processTriangle(const unsigned int* triangle)
+		{
+			unsigned int misses = 0;
+			for (auto i = 0; i < 3; i++)
+			{
+				if (time - timestamps[triangle[i]] > size)
+				{
+					timestamps[triangle[i]] = time++;
+					misses++;
+				}
+			}
+			return misses;
+		}
+
+		// makes every vertex look stale, cheaper than clearing the timestamps
+		void flush()
+		{
+			time += size + 1;
+		}
+	};
+
+	/**
+	 * Next fanning vertex when the candidates did not give any, first from the dead-end stack, then scanning
+	 * through the input. Returns INVALID_INDEX when all triangles are emitted.
+	 */
+	unsigned int skipDeadEnd(const std::vector<unsigned int>& liveTriangles, std::vector<unsigned int>& deadEnd, unsigned int& cursor)
+	{
+		while (!deadEnd.empty())
+		{
+			const auto vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[vertex] > 0) {
+				return vertex;
+			}
+		}
+
+		while (cursor < liveTriangles.size())
+		{
+			if (liveTriangles[cursor] > 0) {
+				return cursor;
+			}
+			cursor++;
+		}
+
+		return INVALID_INDEX;
+	}
+
+} // namespace
+
+void MeshOptimizationReport::printSelf(const char* meshName) const
+{
+	std::cout << "===== Mesh optimization: " << meshName << " =====\n"
+		<< std::fixed << std::setprecision(3)
+		<< "  ACMR: " << before.acmr << " -> " << after.acmr << "\n"
+		<< "  ATVR: " << before.atvr << " -> " << after.atvr << "\n"
+		<< "  Clusters: " << numClusters << "\n"
+		<< "  Index size: " << indexByteSize << " bytes" << std::endl;
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats result;
+	if (indices.size() < 3) {
+		return result;
+	}
+
+	FifoCache cache(vertexCount, cacheSize);
+	unsigned int misses = 0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		misses += cache.processTriangle(&indices[i]);
+	}
+
+	std::vector<bool> referenced(vertexCount, false);
+	unsigned int uniqueVertices = 0;
+	for (auto index : indices)
+	{
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			uniqueVertices++;
+		}
+	}
+
+	result.acmr = float(misses) / float(indices.size() / 3);
+	result.atvr = uniqueVertices > 0 ? float(misses) / float(uniqueVertices) : 0.0f;
+	return result;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize, std::vector<unsigned int>* clusters)
+{
+	const auto numTriangles = static_cast<unsigned int>(indices.size() / 3);
+	if (numTriangles == 0) {
+		return;
+	}
+
+	TriangleAdjacency adjacency(indices, vertexCount);
+	std::vector<unsigned int> liveTriangles(adjacency.counts);
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> deadEnd;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int cursor = 0;
+	unsigned int fanningVertex = indices[0];
+
+	if (clusters != nullptr)
+	{
+		clusters->clear();
+		clusters->push_back(0);
+	}
+
+	while (fanningVertex != INVALID_INDEX)
+	{
+		candidates.clear();
+
+		// Emit all remaining triangles around the fanning vertex
+		const auto begin = adjacency.offsets[fanningVertex];
+		const auto end = begin + adjacency.counts[fanningVertex];
+		for (auto i = begin; i < end; i++)
+		{
+			const auto triangle = adjacency.triangles[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (auto k = 0; k < 3; k++)
+			{
+				const auto vertex = indices[triangle * 3 + k];
+				result.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (timestamp - cacheTime[vertex] > cacheSize) {
+					cacheTime[vertex] = timestamp++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Pick the candidate that is still going to be in the cache after its fan is emitted and has been there longest
+		auto nextVertex = INVALID_INDEX;
+		auto bestPriority = -1;
+		for (auto vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0) {
+				continue;
+			}
+
+			auto priority = 0;
+			if (timestamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+				priority = int(timestamp - cacheTime[vertex]);
+			}
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		if (nextVertex == INVALID_INDEX)
+		{
+			nextVertex = skipDeadEnd(liveTriangles, deadEnd, cursor);
+			if (clusters != nullptr && nextVertex != INVALID_INDEX && clusters->back() != result.size() / 3) {
+				clusters->push_back(static_cast<unsigned int>(result.size() / 3));
+			}
+		}
+
+		fanningVertex = nextVertex;
+	}
+
+	indices.swap(result);
+}
+
+unsigned int optimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes, unsigned int vertexCount,
+	const std::vector<unsigned int>& clusters, unsigned int cacheSize, float threshold)
+{
+	const auto numTriangles = static_cast<unsigned int>(indices.size() / 3);
+	if (numTriangles == 0 || clusters.empty()) {
+		return 0;
+	}
+
+	// Split hard clusters further (soft boundaries) wherever a cold cache start costs little
+	const auto targetAcmr = analyzeVertexCache(indices, vertexCount, cacheSize).acmr * threshold;
+	std::vector<unsigned int> boundaries;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const auto clusterEnd = c + 1 < clusters.size() ? clusters[c + 1] : numTriangles;
+		auto start = clusters[c];
+		auto misses = 0u;
+		boundaries.push_back(start);
+		cache.flush();
+
+		for (auto t = start; t < clusterEnd; t++)
+		{
+			misses += cache.processTriangle(&indices[t * 3]);
+			if (t + 1 < clusterEnd && float(misses) / float(t + 1 - start) <= targetAcmr)
+			{
+				start = t + 1;
+				misses = 0;
+				boundaries.push_back(start);
+				cache.flush();
+			}
+		}
+	}
+
+	const auto position = [&](unsigned int index) {
+		const auto ptr = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + index * strideBytes);
+		return glm::vec3(ptr[0], ptr[1], ptr[2]);
+	};
+
+	// Area weighted centroid and normal of every cluster and of the whole mesh
+	const auto numClusters = static_cast<unsigned int>(boundaries.size());
+	std::vector<glm::vec3> centroids(numClusters), normals(numClusters);
+	glm::vec3 meshCentroid(0.0f);
+	auto meshArea = 0.0f;
+	for (unsigned int c = 0; c < numClusters; c++)
+	{
+		const auto clusterEnd = c + 1 < numClusters ? boundaries[c + 1] : numTriangles;
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		auto area = 0.0f;
+		for (auto t = boundaries[c]; t < clusterEnd; t++)
+		{
+			const auto p0 = position(indices[t * 3]);
+			const auto p1 = position(indices[t * 3 + 1]);
+			const auto p2 = position(indices[t * 3 + 2]);
+			const auto n = glm::cross(p1 - p0, p2 - p0);
+			const auto triangleArea = glm::length(n);
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += n;
+			area += triangleArea;
+		}
+
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids[c] = area > 0.0f ? centroid / area : centroid;
+		normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+	}
+	if (meshArea > 0.0f) {
+		meshCentroid /= meshArea;
+	}
+
+	// Clusters facing away from the center are drawn first, they are the ones most likely to occlude
+	std::vector<float> sortKeys(numClusters);
+	for (unsigned int c = 0; c < numClusters; c++) {
+		sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+	}
+
+	std::vector<unsigned int> order(numClusters);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	for (auto c : order)
+	{
+		const auto clusterEnd = c + 1 < numClusters ? boundaries[c + 1] : numTriangles;
+		result.insert(result.end(), indices.begin() + boundaries[c] * 3, indices.begin() + clusterEnd * 3);
+	}
+
+	indices.swap(result);
+	return numClusters;
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+	std::vector<unsigned int> remap(vertexCount, INVALID_INDEX);
+	unsigned int nextVertex = 0;
+	for (auto& index : indices)
+	{
+		if (remap[index] == INVALID_INDEX) {
+			remap[index] = nextVertex++;
+		}
+		index = remap[index];
+	}
+
+	// Keep unreferenced vertices, so that vertex counts do not change under the caller
+	for (auto& newIndex : remap)
+	{
+		if (newIndex == INVALID_INDEX) {
+			newIndex = nextVertex++;
+		}
+	}
+
+	return remap;
+}
+
+unsigned int getIndexByteSize(unsigned int vertexCount)
+{
+	if (vertexCount <= 0x100) {
+		return 1;
+	}
+	if (vertexCount <= 0x10000) {
+		return 2;
+	}
+	return 4;
+}
+
+unsigned int getIndexType(unsigned int indexByteSize)
+{
+	switch (indexByteSize)
+	{
+		case 1: return GL_UNSIGNED_BYTE;
+		case 2: return GL_UNSIGNED_SHORT;
+		default: return GL_UNSIGNED_INT;
+	}
+}
+
+std::vector<unsigned char> packIndices(const std::vector<unsigned int>& indices, unsigned int indexByteSize)
+{
+	std::vector<unsigned char> result(indices.size() * indexByteSize);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		switch (indexByteSize)
+		{
+			case 1:
+				result[i] = static_cast<unsigned char>(indices[i]);
+				break;
+			case 2:
+			{
+				const auto value = static_cast<unsigned short>(indices[i]);
+				memcpy(&result[i * 2], &value, 2);
+				break;
+			}
+			default:
+				memcpy(&result[i * 4], &indices[i], 4);
+				break;
+		}
+	}
+	return result;
+}
+
+MeshOptimizationReport optimizeMesh(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes,
+	unsigned int vertexCount, std::vector<unsigned int>& remap)
+{
+	MeshOptimizationReport report;
+	report.before = analyzeVertexCache(indices, vertexCount);
+
+	std::vector<unsigned int> clusters;
+	optimizeVertexCache(indices, vertexCount, 16, &clusters);
+	report.numClusters = optimizeOverdraw(indices, positions, strideBytes, vertexCount, clusters);
+	remap = optimizeVertexFetch(indices, vertexCount);
+
+	report.after = analyzeVertexCache(indices, vertexCount);
+	report.indexByteSize = getIndexByteSize(vertexCount);
+	return report;
+}
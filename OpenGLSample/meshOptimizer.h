@@ -0,0 +1,132 @@
+#pragma once
+
+// STL
+#include <vector>
+#include <cstddef>
+
+/**
+ * Post-transform vertex cache statistics of an index buffer, simulated with a FIFO cache.
+ */
+struct VertexCacheStats
+{
+    float acmr = 0.0f; // Average cache miss ratio - transformed vertices per triangle (0.5 is ideal for large grids, 3.0 is worst)
+    float atvr = 0.0f; // Average transformed vertex ratio - transformed vertices per unique vertex (1.0 is ideal)
+};
+
+/**
+ * Result of optimizeMesh, for printing / profiling.
+ */
+struct MeshOptimizationReport
+{
+    VertexCacheStats before; // Statistics of the original index order
+    VertexCacheStats after; // Statistics after all stages
+    unsigned int numClusters = 0; // Number of clusters the overdraw stage worked with
+    unsigned int indexByteSize = 4; // Smallest index size the mesh can use (1, 2 or 4)
+
+    /**
+     * Prints the report to the standard output.
+     */
+    void printSelf(const char* meshName) const;
+};
+
+/**
+ * Simulates FIFO post-transform cache over the index buffer.
+ *
+ * @param indices      Triangle list indices
+ * @param vertexCount  Number of vertices the indices refer to
+ * @param cacheSize    Simulated cache size (16 is a safe guess for most GPUs)
+ */
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = 16);
+
+/**
+ * Reorders triangles for vertex cache locality (Tipsify, Sander et al. 2007).
+ *
+ * @param indices      Triangle list indices, reordered in place
+ * @param vertexCount  Number of vertices the indices refer to
+ * @param cacheSize    Target cache size
+ * @param clusters     If not null, receives index of the first triangle of every cluster (hard boundaries,
+ *                     where the algorithm had to jump), which optimizeOverdraw can reorder safely
+ */
+void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = 16,
+    std::vector<unsigned int>* clusters = nullptr);
+
+/**
+ * Reorders clusters of triangles, so that the ones facing outwards are drawn first and occlude the rest.
+ * Clusters are split further where that costs at most threshold x the current ACMR.
+ *
+ * @param indices         Triangle list indices, reordered in place
+ * @param positions       Pointer to the first vertex position (3 floats)
+ * @param strideBytes     Byte distance between two vertex positions
+ * @param vertexCount     Number of vertices
+ * @param clusters        Cluster starts from optimizeVertexCache
+ * @param cacheSize       Cache size used for splitting clusters
+ * @param threshold       How much worse ACMR may get to gain more clusters (1.05 = 5%)
+ *
+ * @return Number of clusters that were sorted.
+ */
+unsigned int optimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes, unsigned int vertexCount,
+    const std::vector<unsigned int>& clusters, unsigned int cacheSize = 16, float threshold = 1.05f);
+
+/**
+ * Computes vertex order in which vertices are first referenced and rewrites the indices accordingly.
+ * Unreferenced vertices are moved to the end.
+ *
+ * @param indices      Triangle (or line) indices, rewritten in place
+ * @param vertexCount  Number of vertices
+ *
+ * @return Remap table, remap[oldIndex] = newIndex. Apply it to vertex data with remapVertices.
+ */
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+/**
+ * Moves vertex data according to the remap table from optimizeVertexFetch.
+ *
+ * @param vertices      Vertex data, elementsPerVertex consecutive elements make one vertex
+ * @param remap         Remap table
+ * @param elementsPerVertex  e.g. 3 for float positions, 1 for a struct vertex
+ */
+template<typename T>
+void remapVertices(std::vector<T>& vertices, const std::vector<unsigned int>& remap, size_t elementsPerVertex = 1)
+{
+    if (vertices.empty()) {
+        return;
+    }
+
+    std::vector<T> result(vertices.size());
+    for (size_t i = 0; i < remap.size(); i++)
+    {
+        for (size_t j = 0; j < elementsPerVertex; j++) {
+            result[remap[i] * elementsPerVertex + j] = vertices[i * elementsPerVertex + j];
+        }
+    }
+    vertices.swap(result);
+}
+
+/**
+ * Gets smallest index size (1, 2 or 4 bytes) able to address given number of vertices.
+ * Note that 1 byte indices are not native on every GPU; use them for small meshes only.
+ */
+unsigned int getIndexByteSize(unsigned int vertexCount);
+
+/**
+ * Gets GL index type (GL_UNSIGNED_BYTE / SHORT / INT) for given index byte size.
+ * Returned as plain unsigned int, so that the header does not pull in a GL loader.
+ */
+unsigned int getIndexType(unsigned int indexByteSize);
+
+/**
+ * Packs indices to raw bytes of given index size, ready for glBufferData.
+ */
+std::vector<unsigned char> packIndices(const std::vector<unsigned int>& indices, unsigned int indexByteSize);
+
+/**
+ * Runs the whole pipeline: vertex cache order, overdraw order of clusters and vertex fetch remap.
+ *
+ * @param indices      Triangle list indices, rewritten in place
+ * @param positions    Pointer to the first vertex position (3 floats)
+ * @param strideBytes  Byte distance between two vertex positions
+ * @param vertexCount  Number of vertices
+ * @param remap        Receives the remap table that must be applied to all vertex arrays
+ */
+MeshOptimizationReport optimizeMesh(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes,
+    unsigned int vertexCount, std::vector<unsigned int>& remap);
@@ -0,0 +1,665 @@
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+
+namespace {
+
+	const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	// border edges get a plane perpendicular to their triangle, this much heavier than the triangle planes,
+	// so that borders keep their shape when they are allowed to collapse
+	const double BORDER_WEIGHT = 10.0;
+
+	// a pass collapses at most the cheapest 1 / PASS_FRACTION of the candidates before costs are evaluated again
+	const size_t PASS_FRACTION = 3;
+
+	// a collapse may turn a remaining triangle by at most acos(MIN_NORMAL_DOT)
+	const float MIN_NORMAL_DOT = 0.25f;
+
+	/**
+	 * Symmetric error quadric: weighted sum of squared distances to a set of planes, with the total weight.
+	 */
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0, a10 = 0.0, a20 = 0.0, a21 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0, c = 0.0;
+		double weight = 0.0;
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a00 += w * n.x * n.x;
+			a11 += w * n.y * n.y;
+			a22 += w * n.z * n.z;
+			a10 += w * n.y * n.x;
+			a20 += w * n.z * n.x;
+			a21 += w * n.z * n.y;
+			b0 += w * n.x * d;
+			b1 += w * n.y * d;
+			b2 += w * n.z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a11 += q.a11; a22 += q.a22;
+			a10 += q.a10; a20 += q.a20; a21 += q.a21;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+
+		double evaluate(const glm::vec3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double result = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::max(result, 0.0);
+		}
+	};
+
+	/**
+	 * Candidate collapse of position group `group` into the neighbouring group `target`.
+	 */
+	struct Collapse
+	{
+		double cost;
+		double error; // squared distance part of the cost
+		unsigned int group;
+		unsigned int target;
+	};
+
+	const float* vertexAttribute(const float* first, size_t strideBytes, unsigned int vertex)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(first) + vertex * strideBytes);
+	}
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+		}
+	};
+
+	/**
+	 * Edge collapse state of one simplifyMesh call. Vertices sharing a position form a group, named after its
+	 * first vertex; quadrics, borders and collapses work on groups, attributes on the vertices in them.
+	 */
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<unsigned int>& indices, const SimplifyVertices& vertices, const SimplifyOptions& options)
+			: _indices(indices), _options(options), _vertexCount(vertices.vertexCount)
+		{
+			loadVertices(vertices);
+			buildAdjacency();
+			findBorders();
+			_locked.assign(_vertexCount, 0);
+			if (_options.lockBorder) {
+				_locked = _isBorder;
+			}
+			computeQuadrics();
+		}
+
+		float run(std::vector<unsigned int>& destination)
+		{
+			const size_t targetTriangles = _options.targetIndexCount / 3;
+			const double maxError = double(_options.targetError) * _options.targetError;
+			double error = 0.0;
+
+			std::vector<Collapse> candidates;
+			std::vector<unsigned int> collapsed(_vertexCount, INVALID_INDEX);
+			std::vector<unsigned char> used(_vertexCount);
+
+			while (_indices.size() / 3 > targetTriangles)
+			{
+				buildAdjacency();
+				findBorders();
+
+				candidates.clear();
+				for (unsigned int g = 0; g < _vertexCount; g++)
+				{
+					if (_memberCounts[g] == 0 || _locked[g]) {
+						continue;
+					}
+					Collapse best = { 0.0, 0.0, g, INVALID_INDEX };
+					forEachNeighbourGroup(g, [&](unsigned int h) {
+						Collapse collapse = { 0.0, 0.0, g, h };
+						if (evaluate(collapse) && collapse.error <= maxError &&
+							(best.target == INVALID_INDEX || collapse.cost < best.cost)) {
+							best = collapse;
+						}
+					});
+					if (best.target != INVALID_INDEX) {
+						candidates.push_back(best);
+					}
+				}
+				if (candidates.empty()) {
+					break;
+				}
+
+				std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+					return a.cost < b.cost || (a.cost == b.cost && a.group < b.group);
+				});
+				candidates.resize(std::max<size_t>(1, candidates.size() / PASS_FRACTION));
+
+				size_t triangles = _indices.size() / 3;
+				size_t numCollapses = 0;
+				std::fill(used.begin(), used.end(), 0);
+				for (const Collapse& collapse : candidates)
+				{
+					if (triangles <= targetTriangles) {
+						break;
+					}
+					if (used[collapse.group] || used[collapse.target]) {
+						continue;
+					}
+					size_t removed = 0;
+					if (!apply(collapse, collapsed, removed)) {
+						continue;
+					}
+					// the triangles around the group changed, later collapses of this pass must not rely on them
+					used[collapse.group] = 1;
+					used[collapse.target] = 1;
+					forEachNeighbourGroup(collapse.group, [&](unsigned int h) { used[h] = 1; });
+
+					triangles -= std::min(removed, triangles);
+					error = std::max(error, collapse.error);
+					numCollapses++;
+				}
+				if (numCollapses == 0) {
+					break;
+				}
+				rewriteIndices(collapsed);
+			}
+
+			destination = _indices;
+			return float(std::sqrt(error)) * _extent;
+		}
+
+	private:
+		std::vector<unsigned int> _indices;
+		SimplifyOptions _options;
+		unsigned int _vertexCount;
+
+		// positions scaled to the unit box, so that errors are relative to the extent
+		float _extent = 1.0f;
+		std::vector<glm::vec3> _positions;
+		std::vector<glm::vec3> _normals;
+		std::vector<glm::vec2> _uvs;
+		std::vector<float> _areas;
+
+		std::vector<unsigned int> _group;
+		std::vector<Quadric> _quadrics; // by group
+		std::vector<unsigned char> _isBorder; // by group
+		std::vector<unsigned char> _locked; // by group
+
+		// vertex -> triangles and group -> referenced vertices, rebuilt every pass
+		std::vector<unsigned int> _triangleOffsets, _triangleCounts, _triangles;
+		std::vector<unsigned int> _memberOffsets, _memberCounts, _members;
+
+		void loadVertices(const SimplifyVertices& vertices)
+		{
+			_positions.resize(_vertexCount);
+			glm::vec3 minimum(0.0f);
+			for (unsigned int v = 0; v < _vertexCount; v++)
+			{
+				const float* p = vertexAttribute(vertices.positions, vertices.strideBytes, v);
+				_positions[v] = glm::vec3(p[0], p[1], p[2]);
+				minimum = v == 0 ? _positions[v] : glm::min(minimum, _positions[v]);
+			}
+			_extent = getMeshExtent(vertices);
+			if (_extent <= 0.0f) {
+				_extent = 1.0f;
+			}
+			for (glm::vec3& p : _positions) {
+				p = (p - minimum) / _extent;
+			}
+
+			if (vertices.normals != nullptr)
+			{
+				_normals.resize(_vertexCount);
+				for (unsigned int v = 0; v < _vertexCount; v++)
+				{
+					const float* n = vertexAttribute(vertices.normals, vertices.strideBytes, v);
+					_normals[v] = glm::vec3(n[0], n[1], n[2]);
+				}
+			}
+			if (vertices.uvs != nullptr)
+			{
+				_uvs.resize(_vertexCount);
+				for (unsigned int v = 0; v < _vertexCount; v++)
+				{
+					const float* uv = vertexAttribute(vertices.uvs, vertices.strideBytes, v);
+					_uvs[v] = glm::vec2(uv[0], uv[1]);
+				}
+			}
+
+			// vertices at the same position (UV seams, hard edges) form one group
+			_group.resize(_vertexCount);
+			std::unordered_map<glm::vec3, unsigned int, PositionHash> firstAt;
+			firstAt.reserve(_vertexCount);
+			for (unsigned int v = 0; v < _vertexCount; v++) {
+				_group[v] = firstAt.emplace(_positions[v], v).first->second;
+			}
+		}
+
+		void computeQuadrics()
+		{
+			_quadrics.assign(_vertexCount, Quadric());
+			_areas.assign(_vertexCount, 0.0f);
+
+			for (size_t i = 0; i + 2 < _indices.size(); i += 3)
+			{
+				const unsigned int* corners = &_indices[i];
+				const glm::dvec3 p0(_positions[corners[0]]), p1(_positions[corners[1]]), p2(_positions[corners[2]]);
+				glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const double length = glm::length(normal);
+				if (length == 0.0) {
+					continue;
+				}
+				normal /= length;
+				const double area = 0.5 * length;
+				for (int k = 0; k < 3; k++)
+				{
+					_quadrics[_group[corners[k]]].addPlane(normal, -glm::dot(normal, p0), area);
+					_areas[corners[k]] += float(area);
+				}
+
+				for (int k = 0; k < 3; k++)
+				{
+					const unsigned int a = _group[corners[k]], b = _group[corners[(k + 1) % 3]];
+					if (hasEdge(b, a)) {
+						continue;
+					}
+					const glm::dvec3 pa(_positions[a]), pb(_positions[b]);
+					const glm::dvec3 edge = pb - pa;
+					glm::dvec3 side = glm::cross(edge, normal);
+					const double sideLength = glm::length(side);
+					if (sideLength == 0.0) {
+						continue;
+					}
+					side /= sideLength;
+					const double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+					_quadrics[a].addPlane(side, -glm::dot(side, pa), weight);
+					_quadrics[b].addPlane(side, -glm::dot(side, pa), weight);
+				}
+			}
+		}
+
+		/**
+		 * Checks whether a triangle has the edge from group a to group b, in its winding order.
+		 */
+		bool hasEdge(unsigned int a, unsigned int b) const
+		{
+			for (unsigned int m = 0; m < _memberCounts[a]; m++)
+			{
+				const unsigned int v = _members[_memberOffsets[a] + m];
+				for (unsigned int t = 0; t < _triangleCounts[v]; t++)
+				{
+					const unsigned int* corners = &_indices[_triangles[_triangleOffsets[v] + t] * 3];
+					const int k = corners[0] == v ? 0 : corners[1] == v ? 1 : 2;
+					if (_group[corners[(k + 1) % 3]] == b) {
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * Marks the groups on edges used in one direction only, by position. Needs the adjacency.
+		 */
+		void findBorders()
+		{
+			_isBorder.assign(_vertexCount, 0);
+			for (size_t i = 0; i < _indices.size(); i++)
+			{
+				const size_t next = i % 3 == 2 ? i - 2 : i + 1;
+				const unsigned int a = _group[_indices[i]], b = _group[_indices[next]];
+				if (!hasEdge(b, a))
+				{
+					_isBorder[a] = 1;
+					_isBorder[b] = 1;
+				}
+			}
+		}
+
+		void buildAdjacency()
+		{
+			_triangleCounts.assign(_vertexCount, 0);
+			for (unsigned int index : _indices) {
+				_triangleCounts[index]++;
+			}
+			_triangleOffsets.resize(_vertexCount);
+			unsigned int offset = 0;
+			for (unsigned int v = 0; v < _vertexCount; v++)
+			{
+				_triangleOffsets[v] = offset;
+				offset += _triangleCounts[v];
+			}
+			_triangles.resize(_indices.size());
+			std::vector<unsigned int> fill = _triangleOffsets;
+			for (size_t i = 0; i < _indices.size(); i++) {
+				_triangles[fill[_indices[i]]++] = (unsigned int)(i / 3);
+			}
+
+			_memberCounts.assign(_vertexCount, 0);
+			for (unsigned int v = 0; v < _vertexCount; v++)
+			{
+				if (_triangleCounts[v] > 0) {
+					_memberCounts[_group[v]]++;
+				}
+			}
+			_memberOffsets.resize(_vertexCount);
+			offset = 0;
+			for (unsigned int g = 0; g < _vertexCount; g++)
+			{
+				_memberOffsets[g] = offset;
+				offset += _memberCounts[g];
+			}
+			_members.resize(offset);
+			fill = _memberOffsets;
+			for (unsigned int v = 0; v < _vertexCount; v++)
+			{
+				if (_triangleCounts[v] > 0) {
+					_members[fill[_group[v]]++] = v;
+				}
+			}
+		}
+
+		template <typename Function>
+		void forEachNeighbourGroup(unsigned int g, Function function) const
+		{
+			// every vertex of the group must reach the target, so the neighbours of the first one are enough
+			const unsigned int v = _members[_memberOffsets[g]];
+			unsigned int seen[64];
+			unsigned int numSeen = 0;
+			for (unsigned int t = 0; t < _triangleCounts[v]; t++)
+			{
+				const unsigned int* corners = &_indices[_triangles[_triangleOffsets[v] + t] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					const unsigned int h = _group[corners[k]];
+					if (h == g || std::find(seen, seen + numSeen, h) != seen + numSeen) {
+						continue;
+					}
+					if (numSeen < 64) {
+						seen[numSeen++] = h;
+					}
+					function(h);
+				}
+			}
+		}
+
+		/**
+		 * Gets the vertex of group h that vertex v collapses into: one sharing a triangle with it.
+		 */
+		unsigned int findPartner(unsigned int v, unsigned int h) const
+		{
+			for (unsigned int t = 0; t < _triangleCounts[v]; t++)
+			{
+				const unsigned int* corners = &_indices[_triangles[_triangleOffsets[v] + t] * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					if (_group[corners[k]] == h) {
+						return corners[k];
+					}
+				}
+			}
+			return INVALID_INDEX;
+		}
+
+		/**
+		 * Computes cost and error of a collapse, false if it is not allowed.
+		 */
+		bool evaluate(Collapse& collapse) const
+		{
+			const unsigned int g = collapse.group, h = collapse.target;
+
+			// borders may only slide along themselves
+			if (_isBorder[g] && hasEdge(g, h) == hasEdge(h, g)) {
+				return false;
+			}
+
+			Quadric quadric = _quadrics[g];
+			quadric.add(_quadrics[h]);
+			collapse.error = quadric.weight > 0.0 ? quadric.evaluate(_positions[h]) / quadric.weight : 0.0;
+
+			// every vertex of the group needs a partner in the target, or a seam would open
+			double attributeCost = 0.0;
+			double totalArea = 0.0;
+			for (unsigned int m = 0; m < _memberCounts[g]; m++)
+			{
+				const unsigned int v = _members[_memberOffsets[g] + m];
+				const unsigned int u = findPartner(v, h);
+				if (u == INVALID_INDEX) {
+					return false;
+				}
+				double difference = 0.0;
+				if (!_normals.empty())
+				{
+					const glm::vec3 d = _normals[v] - _normals[u];
+					difference += _options.normalWeight * glm::dot(d, d);
+				}
+				if (!_uvs.empty())
+				{
+					const glm::vec2 d = _uvs[v] - _uvs[u];
+					difference += _options.uvWeight * glm::dot(d, d);
+				}
+				attributeCost += _areas[v] * difference;
+				totalArea += _areas[v];
+			}
+			collapse.cost = collapse.error + (totalArea > 0.0 ? attributeCost / totalArea : 0.0);
+			return true;
+		}
+
+		/**
+		 * Collapses every vertex of the group into its partner, unless a remaining triangle would flip.
+		 */
+		bool apply(const Collapse& collapse, std::vector<unsigned int>& collapsed, size_t& removed)
+		{
+			const unsigned int g = collapse.group, h = collapse.target;
+			const glm::vec3& target = _positions[h];
+
+			for (unsigned int m = 0; m < _memberCounts[g]; m++)
+			{
+				const unsigned int v = _members[_memberOffsets[g] + m];
+				for (unsigned int t = 0; t < _triangleCounts[v]; t++)
+				{
+					const unsigned int* corners = &_indices[_triangles[_triangleOffsets[v] + t] * 3];
+					if (_group[corners[0]] == h || _group[corners[1]] == h || _group[corners[2]] == h) {
+						continue;
+					}
+					glm::vec3 p[3] = { _positions[corners[0]], _positions[corners[1]], _positions[corners[2]] };
+					const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					for (int k = 0; k < 3; k++)
+					{
+						if (corners[k] == v) {
+							p[k] = target;
+						}
+					}
+					const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+					if (glm::dot(before, after) < MIN_NORMAL_DOT * glm::length(before) * glm::length(after)) {
+						return false;
+					}
+				}
+			}
+
+			for (unsigned int m = 0; m < _memberCounts[g]; m++)
+			{
+				const unsigned int v = _members[_memberOffsets[g] + m];
+				collapsed[v] = findPartner(v, h);
+				for (unsigned int t = 0; t < _triangleCounts[v]; t++)
+				{
+					const unsigned int* corners = &_indices[_triangles[_triangleOffsets[v] + t] * 3];
+					if (_group[corners[0]] == h || _group[corners[1]] == h || _group[corners[2]] == h) {
+						removed++;
+					}
+				}
+			}
+			_quadrics[h].add(_quadrics[g]);
+			return true;
+		}
+
+		/**
+		 * Moves the indices of collapsed vertices to their partners and drops triangles left without area.
+		 */
+		void rewriteIndices(std::vector<unsigned int>& collapsed)
+		{
+			size_t size = 0;
+			for (size_t i = 0; i + 2 < _indices.size(); i += 3)
+			{
+				unsigned int corners[3];
+				for (int k = 0; k < 3; k++)
+				{
+					const unsigned int v = _indices[i + k];
+					corners[k] = collapsed[v] != INVALID_INDEX ? collapsed[v] : v;
+				}
+				const unsigned int g0 = _group[corners[0]], g1 = _group[corners[1]], g2 = _group[corners[2]];
+				if (g0 == g1 || g1 == g2 || g2 == g0) {
+					continue;
+				}
+				_indices[size++] = corners[0];
+				_indices[size++] = corners[1];
+				_indices[size++] = corners[2];
+			}
+			_indices.resize(size);
+			std::fill(collapsed.begin(), collapsed.end(), INVALID_INDEX);
+		}
+	};
+}
+
+float simplifyMesh(std::vector<unsigned int>& destination, const std::vector<unsigned int>& indices,
+	const SimplifyVertices& vertices, const SimplifyOptions& options)
+{
+	if (indices.size() / 3 <= options.targetIndexCount / 3 || vertices.vertexCount == 0)
+	{
+		destination = indices;
+		return 0.0f;
+	}
+
+	Simplifier simplifier(indices, vertices, options);
+	return simplifier.run(destination);
+}
+
+float getMeshExtent(const SimplifyVertices& vertices)
+{
+	if (vertices.vertexCount == 0) {
+		return 0.0f;
+	}
+
+	glm::vec3 minimum(vertexAttribute(vertices.positions, vertices.strideBytes, 0)[0],
+		vertexAttribute(vertices.positions, vertices.strideBytes, 0)[1],
+		vertexAttribute(vertices.positions, vertices.strideBytes, 0)[2]);
+	glm::vec3 maximum = minimum;
+	for (unsigned int v = 1; v < vertices.vertexCount; v++)
+	{
+		const float* p = vertexAttribute(vertices.positions, vertices.strideBytes, v);
+		minimum = glm::min(minimum, glm::vec3(p[0], p[1], p[2]));
+		maximum = glm::max(maximum, glm::vec3(p[0], p[1], p[2]));
+	}
+	const glm::vec3 size = maximum - minimum;
+	return std::max(size.x, std::max(size.y, size.z));
+}
+
+std::vector<MeshLod> generateLodChain(const std::vector<unsigned int>& indices, const SimplifyVertices& vertices,
+	const LodChainOptions& options)
+{
+	std::vector<MeshLod> chain(1);
+	chain[0].indices = indices;
+
+	const float extent = getMeshExtent(vertices);
+	if (extent <= 0.0f) {
+		return chain;
+	}
+
+	for (unsigned int level = 1; level < options.maxLevels; level++)
+	{
+		const size_t previousCount = chain.back().indices.size();
+		const float previousError = chain.back().error;
+
+		// errors add up along the chain, every level gets what the previous ones left of the budget
+		SimplifyOptions simplify;
+		simplify.targetIndexCount = (unsigned int)(previousCount / 3 * options.reduction) * 3;
+		simplify.targetError = options.maxError - previousError / extent;
+		simplify.normalWeight = options.normalWeight;
+		simplify.uvWeight = options.uvWeight;
+		simplify.lockBorder = options.lockBorder;
+		if (simplify.targetError <= 0.0f) {
+			break;
+		}
+
+		MeshLod lod;
+		const float error = simplifyMesh(lod.indices, chain.back().indices, vertices, simplify);
+		if (lod.indices.empty() || lod.indices.size() > previousCount * options.minReduction) {
+			break;
+		}
+		lod.error = previousError + error;
+		optimizeVertexCache(lod.indices, vertices.vertexCount);
+		chain.push_back(std::move(lod));
+	}
+	return chain;
+}
+
+std::vector<std::vector<MeshLod>> generateLodChains(const std::vector<LodChainInput>& submeshes,
+	const LodChainOptions& options, unsigned int numThreads)
+{
+	std::vector<std::vector<MeshLod>> chains(submeshes.size());
+
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	numThreads = (unsigned int)std::min<size_t>(numThreads, submeshes.size());
+
+	// submeshes differ a lot in size, so threads take the next one when they are done instead of a fixed share
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < submeshes.size(); i = next++) {
+			chains[i] = generateLodChain(*submeshes[i].indices, submeshes[i].vertices, options);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; t++) {
+		threads.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return chains;
+}
+
+float getProjectionScale(float fovY, float viewportHeight)
+{
+	return viewportHeight / (2.0f * std::tan(0.5f * fovY));
+}
+
+unsigned int selectLod(const std::vector<float>& errors, float distance, float projectionScale, float maxPixelError)
+{
+	const float pixelsPerUnit = projectionScale / std::max(distance, 1e-6f);
+	for (size_t i = errors.size(); i > 1; i--)
+	{
+		if (errors[i - 1] * pixelsPerUnit <= maxPixelError) {
+			return (unsigned int)(i - 1);
+		}
+	}
+	return 0;
+}
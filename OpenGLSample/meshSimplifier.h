@@ -0,0 +1,120 @@
+#pragma once
+
+// STL
+#include <vector>
+#include <cstddef>
+
+/**
+ * Vertex data simplifyMesh reads. Attributes may live in one interleaved array or separate ones,
+ * as long as they share the stride.
+ */
+struct SimplifyVertices
+{
+    const float* positions = nullptr; // Pointer to the first vertex position (3 floats)
+    const float* normals = nullptr; // Pointer to the first vertex normal (3 floats), may be null
+    const float* uvs = nullptr; // Pointer to the first texture coordinate (2 floats), may be null
+    size_t strideBytes = 0; // Byte distance between two vertices
+    unsigned int vertexCount = 0;
+};
+
+/**
+ * Settings of simplifyMesh. Simplification stops at whichever target is reached first.
+ */
+struct SimplifyOptions
+{
+    unsigned int targetIndexCount = 0; // Stop once the mesh has at most this many indices
+    float targetError = 0.01f; // Largest allowed error, relative to the mesh extent (0.01 = 1% of the largest side)
+    float normalWeight = 0.25f; // Cost of a squared normal difference, relative to a squared distance of one extent
+    float uvWeight = 1.0f; // Cost of a squared texture coordinate difference
+    bool lockBorder = false; // Keep every vertex of open borders, so that neighbouring submeshes still fit together
+};
+
+/**
+ * One level of detail: a triangle list into the vertex buffer of the full mesh.
+ */
+struct MeshLod
+{
+    std::vector<unsigned int> indices;
+    float error = 0.0f; // Largest distance to the full mesh surface, in model units
+};
+
+/**
+ * Settings of generateLodChain.
+ */
+struct LodChainOptions
+{
+    unsigned int maxLevels = 5; // Levels including the full mesh
+    float reduction = 0.5f; // Every level aims for this fraction of the triangles of the previous one
+    float maxError = 0.05f; // No level goes further than this, relative to the mesh extent
+    float minReduction = 0.9f; // A level that keeps more than this fraction of the previous one ends the chain
+    float normalWeight = 0.25f;
+    float uvWeight = 1.0f;
+    bool lockBorder = false;
+};
+
+/**
+ * Triangle list of one submesh, input of generateLodChains.
+ */
+struct LodChainInput
+{
+    const std::vector<unsigned int>* indices = nullptr;
+    SimplifyVertices vertices;
+};
+
+/**
+ * Simplifies a triangle list with edge collapses in quadric error order (Garland & Heckbert 1997).
+ * Vertices are never moved nor created, an edge collapses into one of its vertices, so the result indexes the
+ * vertex buffer of the input and every level of detail can share it.
+ *
+ * The cost of a collapse is its quadric error plus the change of normals and texture coordinates it causes.
+ * Vertices that share a position but not their attributes (UV seams, hard edges) collapse together, in the same
+ * direction, so seams stay closed. Border vertices collapse along the border only, or not at all with lockBorder.
+ *
+ * @param destination  Receives the simplified triangle list
+ * @param indices      Triangle list indices
+ * @param vertices     Vertex data the indices refer to
+ * @param options      Targets and weights
+ *
+ * @return Error of the result: largest distance to the input surface, in model units.
+ */
+float simplifyMesh(std::vector<unsigned int>& destination, const std::vector<unsigned int>& indices,
+    const SimplifyVertices& vertices, const SimplifyOptions& options);
+
+/**
+ * Gets the largest side of the bounding box of the vertices, the unit of relative errors.
+ */
+float getMeshExtent(const SimplifyVertices& vertices);
+
+/**
+ * Builds a chain of levels of detail: level 0 is the input, every next level is simplified from the previous one
+ * and reordered for the vertex cache. Errors accumulate along the chain, so each one bounds the distance to level 0.
+ */
+std::vector<MeshLod> generateLodChain(const std::vector<unsigned int>& indices, const SimplifyVertices& vertices,
+    const LodChainOptions& options = LodChainOptions());
+
+/**
+ * Builds the chains of several submeshes, one submesh per thread at a time.
+ *
+ * @param numThreads  Worker threads, 0 for one per hardware thread
+ */
+std::vector<std::vector<MeshLod>> generateLodChains(const std::vector<LodChainInput>& submeshes,
+    const LodChainOptions& options = LodChainOptions(), unsigned int numThreads = 0);
+
+/**
+ * Gets the pixels per model unit at distance 1 of a perspective projection: multiply by size / distance to get
+ * the screen size of an object.
+ *
+ * @param fovY            Vertical field of view, in radians
+ * @param viewportHeight  Viewport height, in pixels
+ */
+float getProjectionScale(float fovY, float viewportHeight);
+
+/**
+ * Selects the coarsest level whose error is still smaller than maxPixelError on screen.
+ *
+ * @param errors           Error of every level, increasing
+ * @param distance         Distance from the camera to the mesh, in model units (scale it by the model scale)
+ * @param projectionScale  See getProjectionScale
+ * @param maxPixelError    Largest acceptable error on screen, in pixels
+ */
+unsigned int selectLod(const std::vector<float>& errors, float distance, float projectionScale, float maxPixelError = 1.0f);
@@ -0,0 +1,342 @@
+// STL
+#include <algorithm>
+#include <cmath>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "meshlets.h"
+#include "glState.h"
+
+namespace {
+
+	const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	// how much a triangle bending the normal cone counts against one new vertex when growing a meshlet
+	const float CONE_WEIGHT = 0.5f;
+
+	// normals spread further than acos(CONE_MIN_DOT) from the axis leave the cone useless for culling
+	const float CONE_MIN_DOT = 0.1f;
+
+	/**
+	 * Vertex -> triangles adjacency in compressed form (offsets + one flat array).
+	 */
+	struct TriangleAdjacency
+	{
+		std::vector<unsigned int> counts;
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		TriangleAdjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+			: counts(vertexCount, 0)
+			, offsets(vertexCount, 0)
+			, triangles(indices.size())
+		{
+			for (auto index : indices) {
+				counts[index]++;
+			}
+
+			unsigned int offset = 0;
+			for (unsigned int i = 0; i < vertexCount; i++)
+			{
+				offsets[i] = offset;
+				offset += counts[i];
+			}
+
+			std::vector<unsigned int> fill(offsets);
+			for (size_t i = 0; i < indices.size(); i++) {
+				triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+			}
+		}
+	};
+
+	glm::vec3 getPosition(const float* positions, size_t strideBytes, unsigned int vertex)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * strideBytes);
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+
+	/**
+	 * Computes the bounding sphere and normal cone of the triangles of one meshlet.
+	 */
+	void computeBounds(Meshlet& meshlet, const unsigned int* indices, const std::vector<unsigned int>& vertices,
+		const float* positions, size_t strideBytes, const std::vector<glm::vec3>& normals, const unsigned int* triangles)
+	{
+		glm::vec3 minimum = getPosition(positions, strideBytes, vertices[0]);
+		glm::vec3 maximum = minimum;
+		for (unsigned int vertex : vertices)
+		{
+			const glm::vec3 p = getPosition(positions, strideBytes, vertex);
+			minimum = glm::min(minimum, p);
+			maximum = glm::max(maximum, p);
+		}
+		meshlet.center = 0.5f * (minimum + maximum);
+		meshlet.radius = 0.0f;
+		for (unsigned int vertex : vertices) {
+			meshlet.radius = std::max(meshlet.radius, glm::length(getPosition(positions, strideBytes, vertex) - meshlet.center));
+		}
+
+		const unsigned int triangleCount = meshlet.indexCount / 3;
+		glm::vec3 axis(0.0f);
+		for (unsigned int i = 0; i < triangleCount; i++) {
+			axis += normals[triangles[i]];
+		}
+		const float axisLength = glm::length(axis);
+		if (axisLength == 0.0f) {
+			return;
+		}
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (unsigned int i = 0; i < triangleCount; i++)
+		{
+			const glm::vec3& normal = normals[triangles[i]];
+			if (normal != glm::vec3(0.0f)) {
+				minDot = std::min(minDot, glm::dot(axis, normal));
+			}
+		}
+		if (minDot <= CONE_MIN_DOT) {
+			return;
+		}
+
+		// apex: the point on the axis behind every triangle plane, so that the test holds for the whole meshlet
+		float maxT = 0.0f;
+		for (unsigned int i = 0; i < triangleCount; i++)
+		{
+			const glm::vec3& normal = normals[triangles[i]];
+			if (normal == glm::vec3(0.0f)) {
+				continue;
+			}
+			const glm::vec3 corner = getPosition(positions, strideBytes, indices[i * 3]);
+			maxT = std::max(maxT, glm::dot(meshlet.center - corner, normal) / glm::dot(axis, normal));
+		}
+		meshlet.coneApex = meshlet.center - axis * maxT;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+
+	/**
+	 * Frustum planes of a clip transform (Gribb & Hartmann), normalized so that they give distances.
+	 */
+	void getFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6])
+	{
+		const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[0] = row3 + row0;
+		planes[1] = row3 - row0;
+		planes[2] = row3 + row1;
+		planes[3] = row3 - row1;
+		planes[4] = row3 + row2;
+		planes[5] = row3 - row2;
+		for (int i = 0; i < 6; i++) {
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+		}
+	}
+
+} // namespace
+
+std::vector<Meshlet> buildMeshlets(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes,
+	unsigned int vertexCount, unsigned int maxVertices, unsigned int maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+	const unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+	if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0) {
+		return meshlets;
+	}
+
+	const TriangleAdjacency adjacency(indices, vertexCount);
+
+	std::vector<glm::vec3> normals(triangleCount);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		const glm::vec3 p0 = getPosition(positions, strideBytes, indices[t * 3]);
+		const glm::vec3 p1 = getPosition(positions, strideBytes, indices[t * 3 + 1]);
+		const glm::vec3 p2 = getPosition(positions, strideBytes, indices[t * 3 + 2]);
+		const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float length = glm::length(normal);
+		normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	std::vector<bool> emitted(triangleCount, false);
+	// meshlet number + 1 of the last meshlet that used the vertex, so nothing needs clearing between meshlets
+	std::vector<unsigned int> usedBy(vertexCount, 0);
+
+	std::vector<unsigned int> meshletVertices;
+	std::vector<unsigned int> meshletTriangles;
+	std::vector<unsigned int> candidates;
+	unsigned int cursor = 0;
+
+	while (true)
+	{
+		while (cursor < triangleCount && emitted[cursor]) {
+			cursor++;
+		}
+		if (cursor == triangleCount) {
+			break;
+		}
+
+		const unsigned int stamp = static_cast<unsigned int>(meshlets.size()) + 1;
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		candidates.clear();
+		glm::vec3 normalSum(0.0f);
+
+		auto addTriangle = [&](unsigned int triangle) {
+			emitted[triangle] = true;
+			meshletTriangles.push_back(triangle);
+			normalSum += normals[triangle];
+			for (int k = 0; k < 3; k++)
+			{
+				const unsigned int vertex = indices[triangle * 3 + k];
+				if (usedBy[vertex] == stamp) {
+					continue;
+				}
+				usedBy[vertex] = stamp;
+				meshletVertices.push_back(vertex);
+				for (unsigned int i = 0; i < adjacency.counts[vertex]; i++)
+				{
+					const unsigned int neighbour = adjacency.triangles[adjacency.offsets[vertex] + i];
+					if (!emitted[neighbour]) {
+						candidates.push_back(neighbour);
+					}
+				}
+			}
+		};
+
+		addTriangle(cursor);
+		while (meshletTriangles.size() < maxTriangles)
+		{
+			const glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+			unsigned int best = INVALID_INDEX;
+			float bestScore = 0.0f;
+
+			size_t live = 0;
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				const unsigned int triangle = candidates[i];
+				if (emitted[triangle]) {
+					continue;
+				}
+				candidates[live++] = triangle;
+
+				unsigned int newVertices = 0;
+				for (int k = 0; k < 3; k++) {
+					newVertices += usedBy[indices[triangle * 3 + k]] == stamp ? 0 : 1;
+				}
+				if (meshletVertices.size() + newVertices > maxVertices) {
+					continue;
+				}
+				const float score = newVertices + CONE_WEIGHT * (1.0f - glm::dot(axis, normals[triangle]));
+				if (best == INVALID_INDEX || score < bestScore || (score == bestScore && triangle < best))
+				{
+					best = triangle;
+					bestScore = score;
+				}
+			}
+			candidates.resize(live);
+
+			if (best == INVALID_INDEX) {
+				break;
+			}
+			addTriangle(best);
+		}
+
+		// triangles keep their input order inside the meshlet, which is the vertex cache order
+		std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+		Meshlet meshlet;
+		meshlet.firstIndex = static_cast<unsigned int>(result.size());
+		meshlet.indexCount = static_cast<unsigned int>(meshletTriangles.size() * 3);
+		meshlet.vertexCount = static_cast<unsigned int>(meshletVertices.size());
+		for (unsigned int triangle : meshletTriangles) {
+			result.insert(result.end(), &indices[triangle * 3], &indices[triangle * 3] + 3);
+		}
+		computeBounds(meshlet, &result[meshlet.firstIndex], meshletVertices, positions, strideBytes, normals,
+			meshletTriangles.data());
+		meshlets.push_back(meshlet);
+	}
+
+	indices.swap(result);
+	return meshlets;
+}
+
+MeshletCullStats cullMeshlets(const std::vector<Meshlet>& meshlets, const glm::mat4& modelViewProjection,
+	const glm::vec3& cameraPositionInModel, std::vector<DrawElementsCommand>& commands)
+{
+	MeshletCullStats stats;
+	commands.clear();
+
+	glm::vec4 planes[6];
+	getFrustumPlanes(modelViewProjection, planes);
+
+	for (const Meshlet& meshlet : meshlets)
+	{
+		bool inside = true;
+		for (int i = 0; i < 6 && inside; i++) {
+			inside = glm::dot(glm::vec3(planes[i]), meshlet.center) + planes[i].w >= -meshlet.radius;
+		}
+		if (!inside)
+		{
+			stats.frustumCulled++;
+			continue;
+		}
+
+		const glm::vec3 view = meshlet.coneApex - cameraPositionInModel;
+		const float viewLength = glm::length(view);
+		if (viewLength > 0.0f && glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * viewLength)
+		{
+			stats.backfaceCulled++;
+			continue;
+		}
+
+		stats.visible++;
+		stats.visibleTriangles += meshlet.indexCount / 3;
+		if (!commands.empty() && commands.back().firstIndex + commands.back().count == meshlet.firstIndex) {
+			commands.back().count += meshlet.indexCount;
+		}
+		else {
+			commands.push_back({ meshlet.indexCount, 1, meshlet.firstIndex, 0, 0 });
+		}
+	}
+
+	stats.commands = static_cast<unsigned int>(commands.size());
+	return stats;
+}
+
+bool supportsIndirectDraw()
+{
+	return GLAD_GL_VERSION_4_3 != 0;
+}
+
+void drawCommands(const std::vector<DrawElementsCommand>& commands, unsigned int indirectBuffer)
+{
+	if (commands.empty()) {
+		return;
+	}
+
+	if (indirectBuffer != 0)
+	{
+		// orphaned every frame, the driver hands out fresh storage instead of waiting for the last draw
+		GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsCommand), commands.data(), GL_STREAM_DRAW);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+		return;
+	}
+
+	// GL 3.3 path, the same ranges from client memory; scratch arrays are kept, draws only happen on the GL thread
+	static std::vector<GLsizei> counts;
+	static std::vector<const void*> offsets;
+	counts.resize(commands.size());
+	offsets.resize(commands.size());
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		counts[i] = static_cast<GLsizei>(commands[i].count);
+		offsets[i] = reinterpret_cast<const void*>(static_cast<size_t>(commands[i].firstIndex) * sizeof(unsigned int));
+	}
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(commands.size()));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// STL
+#include <vector>
+#include <cstddef>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Small cluster of neighbouring triangles, a contiguous range of the index buffer, with the bounds used to cull it.
+ */
+struct Meshlet
+{
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    unsigned int vertexCount = 0; // Unique vertices used
+
+    glm::vec3 center = glm::vec3(0.0f); // Bounding sphere
+    float radius = 0.0f;
+
+    // Normal cone: the meshlet faces away from a camera at c when dot(normalize(coneApex - c), coneAxis) >= coneCutoff.
+    // Meshlets too curved to ever face away have a zero axis and a cutoff of 1.
+    glm::vec3 coneApex = glm::vec3(0.0f);
+    glm::vec3 coneAxis = glm::vec3(0.0f);
+    float coneCutoff = 1.0f;
+};
+
+/**
+ * Layout of glMultiDrawElementsIndirect commands.
+ */
+struct DrawElementsCommand
+{
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+/**
+ * Meshlet numbers of one cullMeshlets call, for printing / profiling.
+ */
+struct MeshletCullStats
+{
+    unsigned int visible = 0;
+    unsigned int frustumCulled = 0;
+    unsigned int backfaceCulled = 0;
+    unsigned int visibleTriangles = 0;
+    unsigned int commands = 0; // Draw commands after merging neighbouring meshlets
+};
+
+/**
+ * Splits a triangle list into meshlets. Triangles are grown from a seed into the neighbours that add the fewest
+ * new vertices and bend the normal cone least, until a limit is hit. Run it after the vertex cache
+ * optimization: seeds are taken in index order, and meshlets keep the order of their triangles.
+ *
+ * @param indices       Triangle list indices, reordered in place so that every meshlet is one range
+ * @param positions     Pointer to the first vertex position (3 floats)
+ * @param strideBytes   Byte distance between two vertex positions
+ * @param vertexCount   Number of vertices
+ * @param maxVertices   Vertex limit of a meshlet
+ * @param maxTriangles  Triangle limit of a meshlet
+ */
+std::vector<Meshlet> buildMeshlets(std::vector<unsigned int>& indices, const float* positions, size_t strideBytes,
+    unsigned int vertexCount, unsigned int maxVertices = 64, unsigned int maxTriangles = 124);
+
+/**
+ * Tests meshlets against the view frustum and their normal cones and writes draw commands for the visible ones.
+ * Visible meshlets that follow each other in the index buffer share one command.
+ *
+ * @param meshlets                 Meshlets from buildMeshlets
+ * @param modelViewProjection      Transform of the mesh to clip space
+ * @param cameraPositionInModel    Camera position in the model space of the mesh
+ * @param commands                 Receives the commands (cleared first)
+ */
+MeshletCullStats cullMeshlets(const std::vector<Meshlet>& meshlets, const glm::mat4& modelViewProjection,
+    const glm::vec3& cameraPositionInModel, std::vector<DrawElementsCommand>& commands);
+
+/**
+ * Checks whether the context can draw from an indirect buffer (GL 4.3). Without it drawCommands falls back to
+ * glMultiDrawElements, which takes the same ranges from client memory.
+ */
+bool supportsIndirectDraw();
+
+/**
+ * Draws unsigned int indexed triangles of the bound vertex array, one range per command.
+ *
+ * @param indirectBuffer  Buffer the commands are streamed to, 0 to use glMultiDrawElements
+ */
+void drawCommands(const std::vector<DrawElementsCommand>& commands, unsigned int indirectBuffer);
@@ -1,11 +1,9 @@
 #pragma once
-#include <glad/glad.h>
-#include <vector>
-
-using namespace std; // Standard namespace
+#include "boxMesh.h"
 
 class Notebook
 {
 public:
-	static vector<GLfloat>* drawNotebook();
+	// notebook box, generated at compile time
+	static constexpr auto MESH = box_mesh::makeBox(1.0, 0.1, 0.5);
 };
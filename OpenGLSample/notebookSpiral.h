@@ -1,12 +0,0 @@
-#pragma once
-
-#include <glad/glad.h>
-#include <vector>
-
-using namespace std; // Standard namespace
-
-class NotebookSpiral
-{
-public:
-	static vector<GLfloat>* drawNotebookSpirals();
-};
\ No newline at end of file
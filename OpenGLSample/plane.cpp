@@ -3,6 +3,7 @@
 
 // Project
 #include "plane.h"
+#include "glState.h"
 
 namespace static_meshes_3D {
 
@@ -47,7 +48,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
@@ -57,7 +58,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
         glDrawArrays(GL_POINTS, 0, 6);
     }
 
@@ -67,7 +68,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
 
         if (facesBitmask & CUBE_FRONT_FACE) {
             glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -96,7 +97,7 @@ namespace static_meshes_3D {
         }
 
         glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
+        GLState::bindVertexArray(_vao);
 
         const auto numVertices = 6;
         const auto vertexByteSize = getVertexByteSize();
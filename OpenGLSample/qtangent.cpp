@@ -0,0 +1,74 @@
+// STL
+#include <cmath>
+
+// GLM
+#include <glm/gtc/packing.hpp>
+
+// Project
+#include "qtangent.h"
+
+namespace {
+
+	// smallest |w| that survives snorm16 quantization with its sign
+	const float W_BIAS = 1.0f / 32767.0f;
+
+	/**
+	 * Any unit vector perpendicular to n, for tangents that are degenerate or parallel to the normal.
+	 */
+	glm::vec3 anyPerpendicular(const glm::vec3& n)
+	{
+		const glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		return glm::normalize(axis - n * glm::dot(n, axis));
+	}
+
+} // namespace
+
+glm::quat encodeQTangent(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent)
+{
+	const glm::vec3 n = glm::normalize(normal);
+
+	// Gram-Schmidt orthogonalize, like computeTangentBasis
+	glm::vec3 t = tangent - n * glm::dot(n, tangent);
+	const float tangentLength = glm::length(t);
+	t = tangentLength > 1e-6f ? t / tangentLength : anyPerpendicular(n);
+
+	// Rotation with columns t, b, n, where b completes a right handed frame
+	const glm::vec3 b = glm::cross(n, t);
+	glm::quat q = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+
+	// Pick the representation with positive w, away from zero, then let the sign tell the handedness
+	if (q.w < 0.0f) {
+		q = -q;
+	}
+	if (q.w < W_BIAS)
+	{
+		const float xyzScale = std::sqrt(1.0f - W_BIAS * W_BIAS) / glm::length(glm::vec3(q.x, q.y, q.z));
+		q = glm::quat(W_BIAS, q.x * xyzScale, q.y * xyzScale, q.z * xyzScale);
+	}
+	if (glm::dot(b, bitangent) < 0.0f) {
+		q = -q;
+	}
+
+	return q;
+}
+
+glm::i16vec4 packQTangent(const glm::quat& qTangent)
+{
+	return glm::packSnorm<glm::int16>(glm::vec4(qTangent.x, qTangent.y, qTangent.z, qTangent.w));
+}
+
+glm::quat unpackQTangent(const glm::i16vec4& packed)
+{
+	const glm::vec4 v = glm::unpackSnorm<float>(packed);
+	return glm::quat(v.w, v.x, v.y, v.z);
+}
+
+void decodeQTangent(const glm::quat& qTangent, glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+{
+	const glm::quat q = glm::normalize(qTangent);
+
+	// first and third column of the rotation matrix
+	tangent = glm::vec3(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y));
+	normal = glm::vec3(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+	bitangent = glm::cross(normal, tangent) * (q.w < 0.0f ? -1.0f : 1.0f);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+/**
+ * QTangent encoding of a tangent frame (Frey & Herzeg, "Spherical Skinning with Dual Quaternions and QTangents").
+ *
+ * The orthonormal frame (tangent, bitangent, normal) is stored as the rotation taking the tangent space axes X / Y / Z
+ * onto it. q and -q are the same rotation, so the sign of w is free to carry the bitangent handedness: w < 0 means
+ * bitangent = -cross(normal, tangent). To keep that sign after quantization, |w| is kept at least one snorm16 step.
+ *
+ * Shaders decode it with the functions in shaderfiles/NormalMappingQTangent.vertexshader; decodeQTangent does the
+ * same on the CPU.
+ */
+
+/**
+ * Encodes a tangent frame. The tangent is orthogonalized against the normal first, the bitangent only gives the
+ * handedness.
+ */
+glm::quat encodeQTangent(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent);
+
+/**
+ * Quantizes an encoded frame to 4 x 16 bit snorm, to be read by the shader as a normalized GL_SHORT vec4.
+ */
+glm::i16vec4 packQTangent(const glm::quat& qTangent);
+
+/**
+ * Reads back a quantized frame, as the shader does.
+ */
+glm::quat unpackQTangent(const glm::i16vec4& packed);
+
+/**
+ * Rebuilds normal, tangent and bitangent from an encoded frame (does not need to be normalized).
+ */
+void decodeQTangent(const glm::quat& qTangent, glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent);
@@ -0,0 +1,196 @@
+// STL
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Project
+#include "revolvedMesh3D.h"
+#include "meshOptimizer.h"
+#include "glState.h"
+
+namespace static_meshes_3D {
+
+	RevolvedMesh3D::RevolvedMesh3D(int numSlices, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+		: StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals, vertexLayout)
+		, _numSlices(numSlices < 3 ? 3 : numSlices)
+	{
+	}
+
+	int RevolvedMesh3D::getSlices() const
+	{
+		return _numSlices;
+	}
+
+	int RevolvedMesh3D::getNumVertices() const
+	{
+		return _numVertices;
+	}
+
+	int RevolvedMesh3D::getNumIndices() const
+	{
+		return _numIndices;
+	}
+
+	void RevolvedMesh3D::buildMesh(const std::vector<ProfilePoint>& profile, float textureRepeatU, const std::vector<CapDisc>& caps)
+	{
+		if (_isInitialized) {
+			return;
+		}
+
+		// Pre-calculate sines / cosines for given number of slices, last slice repeats the first one exactly,
+		// so that the texture seam does not leave a crack
+		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
+		std::vector<float> sines(_numSlices + 1), cosines(_numSlices + 1);
+		for (auto i = 0; i < _numSlices; i++)
+		{
+			sines[i] = std::sin(sliceAngleStep * i);
+			cosines[i] = std::cos(sliceAngleStep * i);
+		}
+		sines[_numSlices] = sines[0];
+		cosines[_numSlices] = cosines[0];
+
+		// Count vertices and indices first, so that both are written straight to the staging memory of the VBOs
+		const auto ringSize = _numSlices + 1;
+		_numVertices = static_cast<int>(profile.size() * ringSize + caps.size() * (_numSlices + 1));
+		auto numTriangles = static_cast<int>(caps.size()) * _numSlices;
+		for (size_t k = 0; k + 1 < profile.size(); k++) {
+			numTriangles += ((profile[k].radius > 0.0f ? 1 : 0) + (profile[k + 1].radius > 0.0f ? 1 : 0)) * _numSlices;
+		}
+		_numIndices = numTriangles * 3;
+
+		// 1 byte indices are not native everywhere, so use at least 2
+		auto indexByteSize = getIndexByteSize(static_cast<unsigned int>(_numVertices));
+		if (indexByteSize < 2) {
+			indexByteSize = 2;
+		}
+		_indexType = getIndexType(indexByteSize);
+
+		_vbo.createVBO(getVertexByteSize() * _numVertices);
+		_indicesVBO.createVBO(indexByteSize * _numIndices);
+		VertexWriter vertices(*this, _numVertices, _vbo);
+		auto indexData = _indicesVBO.appendRawData(indexByteSize * _numIndices);
+		if (!vertices.isValid() || indexData == nullptr)
+		{
+			std::cout << "Could not stage the revolved mesh data! The mesh is not built!" << std::endl;
+			return;
+		}
+		const auto addTriangle = [&indexData, indexByteSize](unsigned int a, unsigned int b, unsigned int c)
+		{
+			const unsigned int triangle[3] = { a, b, c };
+			for (const auto index : triangle)
+			{
+				if (indexByteSize == 2)
+				{
+					const auto shortIndex = static_cast<unsigned short>(index);
+					memcpy(indexData, &shortIndex, sizeof(shortIndex));
+				}
+				else {
+					memcpy(indexData, &index, sizeof(index));
+				}
+				indexData += indexByteSize;
+			}
+		};
+
+		// Side rings, each with a duplicated seam vertex carrying U = textureRepeatU
+		auto vertex = 0;
+		for (const auto& point : profile)
+		{
+			for (auto i = 0; i <= _numSlices; i++, vertex++)
+			{
+				vertices.setPosition(vertex, glm::vec3(cosines[i] * point.radius, point.y, sines[i] * point.radius));
+				vertices.setTextureCoordinate(vertex, glm::vec2(textureRepeatU * float(i) / float(_numSlices), point.v));
+				vertices.setNormal(vertex, glm::vec3(cosines[i] * point.normalRadial, point.normalY, sines[i] * point.normalRadial));
+			}
+		}
+
+		//  a--d   ring k
+		//  | /|
+		//  |/ |
+		//  b--c   ring k + 1
+		for (size_t k = 0; k + 1 < profile.size(); k++)
+		{
+			for (auto i = 0; i < _numSlices; i++)
+			{
+				const auto a = static_cast<unsigned int>(k * ringSize + i);
+				const auto b = a + ringSize;
+				const auto c = b + 1;
+				const auto d = a + 1;
+
+				// Pole rings collapse to a point, so one triangle of the quad has no area
+				if (profile[k].radius > 0.0f) {
+					addTriangle(a, d, b);
+				}
+				if (profile[k + 1].radius > 0.0f) {
+					addTriangle(d, c, b);
+				}
+			}
+		}
+
+		// Caps as fans around their own center vertex
+		for (const auto& cap : caps)
+		{
+			const auto center = static_cast<unsigned int>(vertex);
+			const auto normal = glm::vec3(0.0f, cap.facingUp ? 1.0f : -1.0f, 0.0f);
+			vertices.setPosition(vertex, glm::vec3(0.0f, cap.y, 0.0f));
+			vertices.setTextureCoordinate(vertex, glm::vec2(0.5f, 0.5f));
+			vertices.setNormal(vertex++, normal);
+			for (auto i = 0; i < _numSlices; i++, vertex++)
+			{
+				vertices.setPosition(vertex, glm::vec3(cosines[i] * cap.radius, cap.y, sines[i] * cap.radius));
+				vertices.setTextureCoordinate(vertex, glm::vec2(0.5f + normal.y * sines[i] * 0.5f, 0.5f + normal.y * cosines[i] * 0.5f));
+				vertices.setNormal(vertex, normal);
+			}
+
+			for (auto i = 0; i < _numSlices; i++)
+			{
+				const auto current = center + 1 + i;
+				const auto next = center + 1 + (i + 1) % _numSlices;
+				if (cap.facingUp) {
+					addTriangle(center, next, current);
+				}
+				else {
+					addTriangle(center, current, next);
+				}
+			}
+		}
+
+		// Generate VAO and upload vertex attributes
+		_vao = GLVertexArray::create();
+		GLState::bindVertexArray(_vao.get());
+		_vbo.bindVBO();
+		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
+		setVertexAttributesPointers(_numVertices);
+
+		// Indices go to the element buffer stored in the VAO
+		_indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+		_indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
+
+		_isInitialized = true;
+	}
+
+	void RevolvedMesh3D::render() const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		GLState::bindVertexArray(_vao.get());
+		glDrawElements(GL_TRIANGLES, _numIndices, _indexType, nullptr);
+	}
+
+	void RevolvedMesh3D::renderPoints() const
+	{
+		if (!_isInitialized) {
+			return;
+		}
+
+		// Just render all points as they are stored in the VBO
+		GLState::bindVertexArray(_vao.get());
+		glDrawArrays(GL_POINTS, 0, _numVertices);
+	}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,76 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// Project
+#include "common/staticMeshIndexed3D.h"
+
+namespace static_meshes_3D {
+
+	/**
+	 * Base of static meshes made by revolving a profile around the Y axis (cylinder, cone, capsule, torus).
+	 * Ring vertices are shared by neighbouring bands and all parts, side and caps, go to one triangle list,
+	 * so the whole mesh is rendered with a single glDrawElements call.
+	 */
+	class RevolvedMesh3D : public StaticMeshIndexed3D
+	{
+	public:
+		void render() const override;
+		void renderPoints() const override;
+
+		/**
+		 * Gets number of slices around the Y axis.
+		 */
+		int getSlices() const;
+
+		/**
+		 * Gets number of generated vertices.
+		 */
+		int getNumVertices() const;
+
+		/**
+		 * Gets number of generated indices (3 per triangle).
+		 */
+		int getNumIndices() const;
+
+	protected:
+		/**
+		 * One point of the revolved profile, it generates a ring of vertices.
+		 */
+		struct ProfilePoint
+		{
+			float radius; // Distance from the Y axis
+			float y; // Height of the ring
+			float normalRadial; // Normal component pointing away from the axis
+			float normalY; // Normal component along the Y axis
+			float v; // Texture coordinate V of the whole ring
+		};
+
+		/**
+		 * Flat disc closing the profile (cylinder or cone covers).
+		 */
+		struct CapDisc
+		{
+			float radius; // Disc radius
+			float y; // Height of the disc
+			bool facingUp; // Disc normal is +Y if true, -Y otherwise
+		};
+
+		RevolvedMesh3D(int numSlices, bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout);
+
+		/**
+		 * Generates vertices and indices and uploads them to the GPU.
+		 *
+		 * @param profile          Profile points ordered so that the surface faces outwards (for a vertical side that is from top to bottom),
+		 *                         consecutive points are joined with a band of quads; rings with zero radius are poles and get triangles only
+		 * @param textureRepeatU   How many times the texture wraps around the side
+		 * @param caps             Discs to add, each one gets its own center and ring, as its normal differs from the side
+		 */
+		void buildMesh(const std::vector<ProfilePoint>& profile, float textureRepeatU, const std::vector<CapDisc>& caps);
+
+		int _numSlices; // Number of slices around the Y axis
+		GLenum _indexType = GL_UNSIGNED_SHORT; // Type of indices in the index buffer
+	};
+
+} // namespace static_meshes_3D
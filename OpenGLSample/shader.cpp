@@ -14,6 +14,7 @@ using namespace std;
 
 // had to comment include GLAD in shader.h 
 #include "shader.hpp"
+#include "common/programCache.h"
 
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
 
@@ -45,6 +46,15 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 		FragmentShaderStream.close();
 	}
 
+	// Reuse the program binary from a previous launch if the driver accepts it
+	GLuint ProgramID = glCreateProgram();
+	std::string CacheKey = ProgramCache::makeKey({ VertexShaderCode, FragmentShaderCode });
+	if ( ProgramCache::load(CacheKey, ProgramID) ){
+		glDeleteShader(VertexShaderID);
+		glDeleteShader(FragmentShaderID);
+		return ProgramID;
+	}
+
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
 
@@ -85,9 +95,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 
 	// Link the program
 	printf("Linking program\n");
-	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	ProgramCache::prepareForLink(ProgramID);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -106,6 +116,8 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	ProgramCache::store(CacheKey, ProgramID);
+
 	return ProgramID;
 }
 
@@ -10,6 +10,9 @@
 #include <sstream>
 #include <iostream>
 
+#include "common/programCache.h"
+#include "glState.h"
+
 class Shader
 {
 public:
@@ -58,66 +61,70 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
-		const char* vShaderCode = vertexCode.c_str();
-		const char * fShaderCode = fragmentCode.c_str();
-		// 2. compile shaders
-		unsigned int vertex, fragment;
-		// vertex shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
-		// fragment Shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(fragment, "FRAGMENT");
-		// if geometry shader is given, compile geometry shader
-		unsigned int geometry;
-		if (geometryPath != nullptr)
+		// 2. compile (or restore from the binary cache) and link
+		build(vertexCode, fragmentCode, geometryPath != nullptr ? &geometryCode : nullptr, "");
+	}
+	// creates a shader from source text, with a block of #define lines injected after #version
+	// ------------------------------------------------------------------------
+	static Shader fromSource(const std::string& vertexCode, const std::string& fragmentCode, const std::string& defines = "")
+	{
+		Shader shader;
+		shader.build(injectDefines(vertexCode, defines), injectDefines(fragmentCode, defines), nullptr, defines);
+		return shader;
+	}
+	// reads a whole shader file, returns an empty string on failure
+	// ------------------------------------------------------------------------
+	static std::string loadSource(const char* path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
 		{
-			const char * gShaderCode = geometryCode.c_str();
-			geometry = glCreateShader(GL_GEOMETRY_SHADER);
-			glShaderSource(geometry, 1, &gShaderCode, NULL);
-			glCompileShader(geometry);
-			checkCompileErrors(geometry, "GEOMETRY");
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+			return "";
 		}
-		// shader Program
-		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		if (geometryPath != nullptr)
-			glAttachShader(ID, geometry);
-		glLinkProgram(ID);
-		checkCompileErrors(ID, "PROGRAM");
-		// delete the shaders as they're linked into our program now and no longer necessery
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
-		if (geometryPath != nullptr)
-			glDeleteShader(geometry);
-
+		std::stringstream stream;
+		stream << file.rdbuf();
+		return stream.str();
+	}
+	// inserts the defines right after the #version line (GLSL requires #version to come first)
+	// ------------------------------------------------------------------------
+	static std::string injectDefines(const std::string& code, const std::string& defines)
+	{
+		if (defines.empty())
+			return code;
+		size_t insertAt = 0;
+		size_t version = code.find("#version");
+		if (version != std::string::npos)
+		{
+			size_t lineEnd = code.find('\n', version);
+			insertAt = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+		}
+		std::string result = code.substr(0, insertAt);
+		if (!result.empty() && result.back() != '\n')
+			result += '\n';
+		return result + defines + code.substr(insertAt);
 	}
 	// activate the shader
 	// ------------------------------------------------------------------------
 	void use()
 	{
-		glUseProgram(ID);
+		GLState::useProgram(ID);
 	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		GLState::uniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		GLState::uniform1i(glGetUniformLocation(ID, name.c_str()), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		GLState::uniform1f(glGetUniformLocation(ID, name.c_str()), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string &name, const glm::vec2 &value) const
@@ -163,6 +170,66 @@ public:
 	}
 
 private:
+	Shader() : ID(0) {}
+
+	// restores the linked program from the binary cache if possible, otherwise
+	// compiles it from source and remembers the result for the next launch
+	// ------------------------------------------------------------------------
+	void build(const std::string& vertexCode, const std::string& fragmentCode, const std::string* geometryCode, const std::string& defines)
+	{
+		ID = glCreateProgram();
+		std::string cacheKey = ProgramCache::makeKey({ vertexCode, fragmentCode, geometryCode ? *geometryCode : "" }, defines);
+		if (ProgramCache::load(cacheKey, ID))
+			return;
+		compileAndLink(vertexCode, fragmentCode, geometryCode);
+		ProgramCache::store(cacheKey, ID);
+	}
+	// compiles the given sources and links them into ID
+	// ------------------------------------------------------------------------
+	void compileAndLink(const std::string& vertexCode, const std::string& fragmentCode, const std::string* geometryCode)
+	{
+		const char* vShaderCode = vertexCode.c_str();
+		const char * fShaderCode = fragmentCode.c_str();
+		unsigned int vertex, fragment;
+		// vertex shader
+		vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vertex, 1, &vShaderCode, NULL);
+		glCompileShader(vertex);
+		checkCompileErrors(vertex, "VERTEX");
+		// fragment Shader
+		fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(fragment, 1, &fShaderCode, NULL);
+		glCompileShader(fragment);
+		checkCompileErrors(fragment, "FRAGMENT");
+		// if geometry shader is given, compile geometry shader
+		unsigned int geometry;
+		if (geometryCode != nullptr)
+		{
+			const char * gShaderCode = geometryCode->c_str();
+			geometry = glCreateShader(GL_GEOMETRY_SHADER);
+			glShaderSource(geometry, 1, &gShaderCode, NULL);
+			glCompileShader(geometry);
+			checkCompileErrors(geometry, "GEOMETRY");
+		}
+		// shader Program
+		glAttachShader(ID, vertex);
+		glAttachShader(ID, fragment);
+		if (geometryCode != nullptr)
+			glAttachShader(ID, geometry);
+		ProgramCache::prepareForLink(ID);
+		glLinkProgram(ID);
+		checkCompileErrors(ID, "PROGRAM");
+		// delete the shaders as they're linked into our program now and no longer necessery
+		glDetachShader(ID, vertex);
+		glDetachShader(ID, fragment);
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
+		if (geometryCode != nullptr)
+		{
+			glDetachShader(ID, geometry);
+			glDeleteShader(geometry);
+		}
+	}
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,109 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "shader.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <iostream>
+
+// One compile-time switch of a shader. Flags use maxValue 1 (#define NAME 0/1),
+// counts like NR_POINT_LIGHTS use a larger maxValue (#define NAME 0..maxValue).
+struct ShaderOption
+{
+	std::string name;
+	unsigned int maxValue = 1;
+};
+
+// A family of shader programs built from the same source files, each one compiled with
+// a different set of #defines. Variants are compiled the first time they are requested
+// and kept afterwards, so the renderer only pays for the combinations it actually uses.
+class ShaderVariants
+{
+public:
+	// constructor only reads the sources, nothing is compiled yet
+	// ------------------------------------------------------------------------
+	ShaderVariants(const char* vertexPath, const char* fragmentPath, const std::vector<ShaderOption>& options)
+		: options(options)
+	{
+		vertexCode = Shader::loadSource(vertexPath);
+		fragmentCode = Shader::loadSource(fragmentPath);
+	}
+	// packs option values into a variant key, options not listed are 0
+	// (resolve keys once per material and keep them, this does string compares)
+	// ------------------------------------------------------------------------
+	unsigned int makeKey(const std::vector<std::pair<std::string, unsigned int>>& values) const
+	{
+		unsigned int key = 0;
+		for (const auto& value : values)
+		{
+			unsigned int shift = 0;
+			bool found = false;
+			for (const auto& option : options)
+			{
+				if (option.name == value.first)
+				{
+					unsigned int clamped = value.second > option.maxValue ? option.maxValue : value.second;
+					key |= clamped << shift;
+					found = true;
+					break;
+				}
+				shift += bitsFor(option.maxValue);
+			}
+			if (!found)
+				std::cout << "ERROR::SHADER_VARIANTS::UNKNOWN_OPTION " << value.first << std::endl;
+		}
+		return key;
+	}
+	// returns the variant for the key, compiling it on first use
+	// ------------------------------------------------------------------------
+	Shader& get(unsigned int key)
+	{
+		auto it = variants.find(key);
+		if (it != variants.end())
+			return *it->second;
+
+		auto shader = std::make_unique<Shader>(Shader::fromSource(vertexCode, fragmentCode, definesFor(key)));
+		Shader& result = *shader;
+		variants.emplace(key, std::move(shader));
+		return result;
+	}
+	// number of variants compiled so far
+	// ------------------------------------------------------------------------
+	size_t getVariantCount() const
+	{
+		return variants.size();
+	}
+
+private:
+	std::string vertexCode;
+	std::string fragmentCode;
+	std::vector<ShaderOption> options;
+	std::unordered_map<unsigned int, std::unique_ptr<Shader>> variants;
+
+	static unsigned int bitsFor(unsigned int maxValue)
+	{
+		unsigned int bits = 0;
+		while ((1u << bits) <= maxValue)
+			bits++;
+		return bits;
+	}
+
+	// unpacks the key back into "#define NAME value" lines
+	std::string definesFor(unsigned int key) const
+	{
+		std::string defines;
+		unsigned int shift = 0;
+		for (const auto& option : options)
+		{
+			unsigned int bits = bitsFor(option.maxValue);
+			unsigned int value = (key >> shift) & ((1u << bits) - 1);
+			defines += "#define " + option.name + " " + std::to_string(value) + "\n";
+			shift += bits;
+		}
+		return defines;
+	}
+};
+#endif
@@ -1,9 +1,33 @@
 #version 330 core
 out vec4 FragColor;
 
+// compile-time switches, ShaderVariants injects its own values after #version
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 4
+#endif
+#ifndef USE_DIR_LIGHT
+#define USE_DIR_LIGHT 1
+#endif
+#ifndef USE_SPOT_LIGHT
+#define USE_SPOT_LIGHT 1
+#endif
+#ifndef USE_SPECULAR_MAP
+#define USE_SPECULAR_MAP 1
+#endif
+
+#if USE_SPECULAR_MAP
+#define SPECULAR_SAMPLE vec3(texture(material.specular, TexCoords))
+#else
+#define SPECULAR_SAMPLE vec3(material.specularStrength)
+#endif
+
 struct Material {
     sampler2D diffuse;
+#if USE_SPECULAR_MAP
     sampler2D specular;
+#else
+    float specularStrength; // specular of the whole surface, without a map
+#endif
     float shininess;
 }; 
 
@@ -42,16 +66,20 @@ struct SpotLight {
     vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 4
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
 uniform vec3 viewPos;
+#if USE_DIR_LIGHT
 uniform DirLight dirLight;
+#endif
+#if NR_POINT_LIGHTS > 0
 uniform PointLight pointLights[NR_POINT_LIGHTS];
+#endif
+#if USE_SPOT_LIGHT
 uniform SpotLight spotLight;
+#endif
 uniform Material material;
 
 // function prototypes
@@ -71,13 +99,20 @@ void main()
     // per lamp. In the main() function we take all the calculated colors and sum them up for
     // this fragment's final color.
     // == =====================================================
+    vec3 result = vec3(0.0);
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+#if USE_DIR_LIGHT
+    result += CalcDirLight(dirLight, norm, viewDir);
+#endif
     // phase 2: point lights
+#if NR_POINT_LIGHTS > 0
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
         result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+#endif
     // phase 3: spot light
+#if USE_SPOT_LIGHT
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+#endif
     
     FragColor = vec4(result, 1.0);
 }
@@ -94,7 +129,7 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 specular = light.specular * spec * SPECULAR_SAMPLE;
     return (ambient + diffuse + specular);
 }
 
@@ -113,7 +148,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 specular = light.specular * spec * SPECULAR_SAMPLE;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -139,7 +174,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
     vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 specular = light.specular * spec * SPECULAR_SAMPLE;
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
@@ -1,8 +1,24 @@
 #version 330 core
+#ifndef USE_QTANGENT
+#define USE_QTANGENT 0
+#endif
+
 layout (location = 0) in vec3 aPos;
+#if USE_QTANGENT
+layout (location = 1) in vec4 aQTangent; // compact vertices, tangent frame as a quaternion (see qtangent.h)
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in vec2 aTexCoords;
 
+#ifndef USE_INSTANCING
+#define USE_INSTANCING 0
+#endif
+
+#if USE_INSTANCING
+layout (location = 3) in mat4 aInstanceModel;
+#endif
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
@@ -13,6 +29,14 @@ uniform mat4 projection;
 
 void main()
 {
+#if USE_INSTANCING
+    mat4 model = aInstanceModel;
+#endif
+#if USE_QTANGENT
+    // third column of the rotation matrix
+    vec4 q = normalize(aQTangent);
+    vec3 aNormal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;  
     TexCoords = aTexCoords;
@@ -1,12 +0,0 @@
-#pragma once
-
-#include <glad/glad.h>
-#include <vector>
-
-using namespace std; // Standard namespace
-
-class Speaker
-{
-public:
-	static vector<GLfloat>* drawSpeaker();
-};
@@ -3,15 +3,12 @@
 #include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
 #endif
 
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#else
-#include <GL/gl.h>
-#endif
+#include <glad/glad.h>
 
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <thread>
 #include "sphere.h"
 
 
@@ -19,18 +16,66 @@
 // constants //////////////////////////////////////////////////////////////////
 const int MIN_SECTOR_COUNT = 3;
 const int MIN_STACK_COUNT = 2;
+const std::size_t PARALLEL_VERTEX_COUNT = 65536;   // spheres with fewer vertices are built on the calling thread
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// call func(i) for i in [0, count), split in contiguous blocks over all
+// hardware threads if parallel is true
+///////////////////////////////////////////////////////////////////////////////
+template<typename Func>
+static void parallelFor(int count, bool parallel, Func func)
+{
+    int threadCount = parallel ? (int)std::thread::hardware_concurrency() : 1;
+    if (threadCount > count)
+        threadCount = count;
+    if (threadCount <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (int t = 0; t < threadCount; ++t)
+    {
+        int begin = count * t / threadCount;
+        int end = count * (t + 1) / threadCount;
+        threads.emplace_back([begin, end, &func]()
+        {
+            for (int i = begin; i < end; ++i)
+                func(i);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-Sphere::Sphere(float radius, int sectors, int stacks, bool smooth) : interleavedStride(32)
+Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, bool gpuResident)
+    : vertexCount(0), indexCount(0), lineIndexCount(0), interleavedStride(32),
+      gpuResident(gpuResident), interleavedOut(nullptr), indexOut(nullptr)
 {
     set(radius, sectors, stacks, smooth);
 }
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+///////////////////////////////////////////////////////////////////////////////
+Sphere::~Sphere()
+{
+    releaseBuffers();
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // setters
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,14 +86,11 @@ void Sphere::set(float radius, int sectors, int stacks, bool smooth)
     if (sectors < MIN_SECTOR_COUNT)
         this->sectorCount = MIN_SECTOR_COUNT;
     this->stackCount = stacks;
-    if (sectors < MIN_STACK_COUNT)
-        this->sectorCount = MIN_STACK_COUNT;
+    if (stacks < MIN_STACK_COUNT)
+        this->stackCount = MIN_STACK_COUNT;
     this->smooth = smooth;
 
-    if (smooth)
-        buildVerticesSmooth();
-    else
-        buildVerticesFlat();
+    buildVertices();
 }
 
 void Sphere::setRadius(float radius)
@@ -75,10 +117,63 @@ void Sphere::setSmooth(bool smooth)
         return;
 
     this->smooth = smooth;
-    if (smooth)
-        buildVerticesSmooth();
-    else
-        buildVerticesFlat();
+    buildVertices();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// axis aligned bounds, same for both shading modes
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::getBounds(float min[3], float max[3]) const
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        min[i] = -radius;
+        max[i] = radius;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the largest triangles are at the equator, half of a square cell with sides
+// 2pi/sectorCount, their circumradius is sqrt(2) * pi / sectorCount (radians)
+// and a flat triangle stays r * (1 - cos(circumradius)) below the sphere
+///////////////////////////////////////////////////////////////////////////////
+int Sphere::getSectorCountForError(float radius, float maxError)
+{
+    const float PI = acos(-1);
+    if (radius <= 0 || maxError >= radius)
+        return 2 * MIN_STACK_COUNT;
+    if (maxError <= 0)
+        return 1 << 16;                         // zero error needs infinite tessellation, cap it
+
+    float angle = acosf(1.0f - maxError / radius);
+    int sectors = (int)ceilf(sqrtf(2.0f) * PI / angle);
+    sectors += sectors % 2;                     // even, so stacks = sectors / 2 exactly
+    return sectors < 2 * MIN_STACK_COUNT ? 2 * MIN_STACK_COUNT : sectors;
+}
+
+unsigned int Sphere::getTriangleCountForError(float radius, float maxError)
+{
+    unsigned int sectors = getSectorCountForError(radius, maxError);
+    return 2 * sectors * (sectors / 2 - 1);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// line indices are only needed for wireframe, so they are built on first use
+///////////////////////////////////////////////////////////////////////////////
+const unsigned int* Sphere::getLineIndices() const
+{
+    if (lineIndices.empty() && lineIndexCount > 0)
+    {
+        lineIndices.resize(lineIndexCount);
+        buildLineIndices(lineIndices.data());
+    }
+    return lineIndices.data();
 }
 
 
@@ -97,55 +192,35 @@ void Sphere::printSelf() const
         << "   Index Count: " << getIndexCount() << "\n"
         << "  Vertex Count: " << getVertexCount() << "\n"
         << "  Normal Count: " << getNormalCount() << "\n"
-        << "TexCoord Count: " << getTexCoordCount() << std::endl;
+        << "TexCoord Count: " << getTexCoordCount() << "\n"
+        << "  GPU Resident: " << (gpuResident ? "true" : "false") << std::endl;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// draw a sphere in VertexArray mode
-// OpenGL RC must be set before calling it
+// draw a sphere from its VAO
+// attributes: 0 = position, 1 = normal, 2 = tex coord
+// OpenGL RC and the shader program must be set before calling it
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::draw() const
 {
-    // interleaved array
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_NORMAL_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glVertexPointer(3, GL_FLOAT, interleavedStride, &interleavedVertices[0]);
-    glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
-    glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
-
-    glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, indices.data());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_NORMAL_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    upload();
+    buffers.draw(indexCount);
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // draw lines only
+// the line colour is passed as constant vertex attribute 3 for the caller's shader
 // the caller must set the line width before call this
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::drawLines(const float lineColor[4]) const
 {
-    // set line colour
-    glColor4fv(lineColor);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, lineColor);
-
-    // draw lines with VA
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-
-    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_TEXTURE_2D);
+    upload();
+    uploadLines();
+    buffers.drawLines(lineColor, lineIndexCount);
 }
 
 
@@ -156,13 +231,75 @@ void Sphere::drawLines(const float lineColor[4]) const
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::drawWithLines(const float lineColor[4]) const
 {
-    glEnable(GL_POLYGON_OFFSET_FILL);
-    glPolygonOffset(1.0, 1.0f); // move polygon backward
-    this->draw();
-    glDisable(GL_POLYGON_OFFSET_FILL);
+    upload();
+    uploadLines();
+    buffers.drawWithLines(lineColor, indexCount, lineIndexCount);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy vertices and indices of CPU-mode sphere to its GPU buffers
+// draw calls do it on demand, calling it at load time keeps it out of the
+// first frame; does nothing if the buffers are up to date
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::upload() const
+{
+    if (gpuResident || buffers.isUploaded())
+        return;
+
+    buffers.upload(interleavedVertices.data(), vertexCount, indices.data(), indexCount);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// line indices are uploaded on first use; GPU-resident sphere does not keep
+// a CPU copy, so they are built into a temporary array
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::uploadLines() const
+{
+    if (buffers.isLinesUploaded())
+        return;
 
-    // draw lines with VA
-    drawLines(lineColor);
+    if (gpuResident)
+    {
+        std::vector<unsigned int> lines(lineIndexCount);
+        buildLineIndices(lines.data());
+        buffers.uploadLines(lines.data(), lineIndexCount);
+    }
+    else
+    {
+        buffers.uploadLines(getLineIndices(), lineIndexCount);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// reorder indices for vertex cache and overdraw, then vertices in order of
+// first use; line indices are remapped to the new vertex order as well
+///////////////////////////////////////////////////////////////////////////////
+MeshOptimizationReport Sphere::optimize()
+{
+    if (gpuResident)
+        return MeshOptimizationReport();    // no CPU copy to reorder
+
+    // line indices refer to the scan-line vertex order, so build them before remapping
+    getLineIndices();
+    buffers.invalidate();
+
+    std::vector<unsigned int> remap;
+    MeshOptimizationReport report = optimizeMesh(indices, vertices.data(), 3 * sizeof(float), getVertexCount(), remap);
+
+    remapVertices(vertices, remap, 3);
+    remapVertices(normals, remap, 3);
+    remapVertices(texCoords, remap, 2);
+    for (std::size_t i = 0; i < lineIndices.size(); ++i)
+        lineIndices[i] = remap[lineIndices[i]];
+
+    interleaveVertices(vertices, normals, texCoords, interleavedVertices);
+    return report;
 }
 
 
@@ -203,6 +340,78 @@ void Sphere::clearArrays()
     std::vector<float>().swap(texCoords);
     std::vector<unsigned int>().swap(indices);
     std::vector<unsigned int>().swap(lineIndices);
+    std::vector<float>().swap(interleavedVertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete VAO and GL buffers
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::releaseBuffers()
+{
+    buffers.release();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// count vertices/indices, point the output at CPU arrays or at mapped GPU
+// buffers and generate; line indices are left to buildLineIndices()
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::buildVertices()
+{
+    // clear memory of prev arrays
+    clearArrays();
+
+    // smooth: (sectorCount+1) vertices per stack
+    // flat: 1 triangle per sector in the first and last stack, quad in the others
+    vertexCount = smooth ? (stackCount + 1) * (sectorCount + 1) : sectorCount * (4 * stackCount - 2);
+    indexCount = 6 * sectorCount * (stackCount - 1);
+    lineIndexCount = sectorCount * (4 * stackCount - 2);
+
+    // GPU-resident sphere is written to its buffers right here, CPU one is uploaded by next draw
+    // generator writes 32 bit indices to mapped memory, CPU copies are packed to
+    // 16 bit on upload when possible (8 bit indices are not native on all GPUs)
+    buffers.setIndexByteSize((gpuResident || vertexCount > 0x10000) ? sizeof(unsigned int) : sizeof(unsigned short));
+
+    bool mapped = gpuResident && buffers.beginMap(vertexCount, indexCount, interleavedOut, indexOut);
+
+    if (!mapped)
+    {
+        // separate arrays are only kept in CPU mode
+        if (!gpuResident)
+        {
+            vertices.resize((std::size_t)vertexCount * 3);
+            normals.resize((std::size_t)vertexCount * 3);
+            texCoords.resize((std::size_t)vertexCount * 2);
+        }
+        interleavedVertices.resize((std::size_t)vertexCount * 8);
+        indices.resize(indexCount);
+        interleavedOut = interleavedVertices.data();
+        indexOut = indices.data();
+    }
+
+    if (smooth)
+        buildVerticesSmooth();
+    else
+        buildVerticesFlat();
+
+    if (gpuResident)
+    {
+        if (mapped)
+        {
+            buffers.endMap();
+        }
+        else
+        {
+            buffers.upload(interleavedVertices.data(), vertexCount, indices.data(), indexCount);
+            clearArrays();
+        }
+    }
+
+    interleavedOut = nullptr;
+    indexOut = nullptr;
 }
 
 
@@ -214,89 +423,61 @@ void Sphere::clearArrays()
 // z = r * sin(u)
 // where u: stack(latitude) angle (-90 <= u <= 90)
 //       v: sector(longitude) angle (0 <= v <= 360)
+// all arrays are sized up front and every stack is written independently,
+// so big spheres are generated on several threads
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::buildVerticesSmooth()
 {
     const float PI = acos(-1);
 
-    // clear memory of prev arrays
-    clearArrays();
-
-    float x, y, z, xy;                              // vertex position
-    float nx, ny, nz, lengthInv = 1.0f / radius;    // normal
-    float s, t;                                     // texCoord
+    const int ringSize = sectorCount + 1;           // (sectorCount+1) vertices per stack
 
-    float sectorStep = 2 * PI / sectorCount;
-    float stackStep = PI / stackCount;
-    float sectorAngle, stackAngle;
+    // cos/sin of all sector and stack angles, stack angle is measured from the north pole
+    std::vector<float> sectorCos, sectorSin, stackCos, stackSin;
+    computeAngles(sectorCount, 2 * PI / sectorCount, sectorCos, sectorSin);
+    computeAngles(stackCount, PI / stackCount, stackCos, stackSin);
 
-    for (int i = 0; i <= stackCount; ++i)
+    parallelFor(stackCount + 1, vertexCount >= PARALLEL_VERTEX_COUNT, [&](int i)
     {
-        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-        xy = radius * cosf(stackAngle);             // r * cos(u)
-        z = radius * sinf(stackAngle);              // r * sin(u)
+        float cosU = stackSin[i];                   // cos(pi/2 - a) = sin(a)
+        float sinU = stackCos[i];
+        float t = (float)i / stackCount;
 
-        // add (sectorCount+1) vertices per stack
         // the first and last vertices have same position and normal, but different tex coords
-        for (int j = 0; j <= sectorCount; ++j)
+        std::size_t k = (std::size_t)i * ringSize;
+        for (int j = 0; j <= sectorCount; ++j, ++k)
         {
-            sectorAngle = j * sectorStep;           // starting from 0 to 2pi
-
-            // vertex position
-            x = xy * cosf(sectorAngle);             // r * cos(u) * cos(v)
-            y = xy * sinf(sectorAngle);             // r * cos(u) * sin(v)
-            addVertex(x, y, z);
-
-            // normalized vertex normal
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-            addNormal(nx, ny, nz);
-
-            // vertex tex coord between [0, 1]
-            s = (float)j / sectorCount;
-            t = (float)i / stackCount;
-            addTexCoord(s, t);
+            float nx = cosU * sectorCos[j];
+            float ny = cosU * sectorSin[j];
+            float nz = sinU;
+            writeVertex(k, radius * nx, radius * ny, radius * nz, nx, ny, nz, (float)j / sectorCount, t);
         }
-    }
-
-    // indices
-    //  k1--k1+1
-    //  |  / |
-    //  | /  |
-    //  k2--k2+1
-    unsigned int k1, k2;
-    for (int i = 0; i < stackCount; ++i)
-    {
-        k1 = i * (sectorCount + 1);     // beginning of current stack
-        k2 = k1 + sectorCount + 1;      // beginning of next stack
 
+        if (i == stackCount)
+            return;
+
+        // indices
+        //  k1--k1+1
+        //  |  / |
+        //  | /  |
+        //  k2--k2+1
+        unsigned int* tri = indexOut + getStackIndexOffset(i);
+        unsigned int k1 = i * ringSize;             // beginning of current stack
+        unsigned int k2 = k1 + ringSize;            // beginning of next stack
         for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
         {
             // 2 triangles per sector excluding 1st and last stacks
             if (i != 0)
             {
-                addIndices(k1, k2, k1 + 1);   // k1---k2---k1+1
+                *tri++ = k1; *tri++ = k2; *tri++ = k1 + 1;          // k1---k2---k1+1
             }
 
             if (i != (stackCount - 1))
             {
-                addIndices(k1 + 1, k2, k2 + 1); // k1+1---k2---k2+1
-            }
-
-            // vertical lines for all stacks
-            lineIndices.push_back(k1);
-            lineIndices.push_back(k2);
-            if (i != 0)  // horizontal lines except 1st stack
-            {
-                lineIndices.push_back(k1);
-                lineIndices.push_back(k1 + 1);
+                *tri++ = k1 + 1; *tri++ = k2; *tri++ = k2 + 1;      // k1+1---k2---k2+1
             }
         }
-    }
-
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
+    });
 }
 
 
@@ -309,276 +490,202 @@ void Sphere::buildVerticesFlat()
 {
     const float PI = acos(-1);
 
-    // tmp vertex definition (x,y,z,s,t)
-    struct Vertex
-    {
-        float x, y, z, s, t;
-    };
-    std::vector<Vertex> tmpVertices;
-
-    float sectorStep = 2 * PI / sectorCount;
-    float stackStep = PI / stackCount;
-    float sectorAngle, stackAngle;
+    std::vector<float> sectorCos, sectorSin, stackCos, stackSin;
+    computeAngles(sectorCount, 2 * PI / sectorCount, sectorCos, sectorSin);
+    computeAngles(stackCount, PI / stackCount, stackCos, stackSin);
 
-    // compute all vertices first, each vertex contains (x,y,z,s,t) except normal
-    for (int i = 0; i <= stackCount; ++i)
+    parallelFor(stackCount, vertexCount >= PARALLEL_VERTEX_COUNT, [&](int i)
     {
-        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-        float xy = radius * cosf(stackAngle);       // r * cos(u)
-        float z = radius * sinf(stackAngle);        // r * sin(u)
-
-        // add (sectorCount+1) vertices per stack
-        // the first and last vertices have same position and normal, but different tex coords
-        for (int j = 0; j <= sectorCount; ++j)
+        // position (x,y,z) and tex coord (s,t) of sector corners
+        struct Corner
         {
-            sectorAngle = j * sectorStep;           // starting from 0 to 2pi
-
-            Vertex vertex;
-            vertex.x = xy * cosf(sectorAngle);      // x = r * cos(u) * cos(v)
-            vertex.y = xy * sinf(sectorAngle);      // y = r * cos(u) * sin(v)
-            vertex.z = z;                           // z = r * sin(u)
-            vertex.s = (float)j / sectorCount;        // s
-            vertex.t = (float)i / stackCount;         // t
-            tmpVertices.push_back(vertex);
-        }
-    }
-
-    // clear memory of prev arrays
-    clearArrays();
+            float p[3];
+            float s, t;
+        };
+        auto corner = [&](int stack, int sector)
+        {
+            float xy = radius * stackSin[stack];    // r * cos(u)
+            Corner c = { { xy * sectorCos[sector], xy * sectorSin[sector], radius * stackCos[stack] },
+                         (float)sector / sectorCount, (float)stack / stackCount };
+            return c;
+        };
 
-    Vertex v1, v2, v3, v4;                          // 4 vertex positions and tex coords
-    std::vector<float> n;                           // 1 face normal
+        unsigned int index = (unsigned int)(i == 0 ? 0 : 3 * sectorCount + (i - 1) * 4 * sectorCount);
+        unsigned int* tri = indexOut + getStackIndexOffset(i);
+        float n[3];                                 // 1 face normal
 
-    int i, j, k, vi1, vi2;
-    int index = 0;                                  // index for vertex
-    for (i = 0; i < stackCount; ++i)
-    {
-        vi1 = i * (sectorCount + 1);                // index of tmpVertices
-        vi2 = (i + 1) * (sectorCount + 1);
-
-        for (j = 0; j < sectorCount; ++j, ++vi1, ++vi2)
+        for (int j = 0; j < sectorCount; ++j)
         {
             // get 4 vertices per sector
             //  v1--v3
             //  |    |
             //  v2--v4
-            v1 = tmpVertices[vi1];
-            v2 = tmpVertices[vi2];
-            v3 = tmpVertices[vi1 + 1];
-            v4 = tmpVertices[vi2 + 1];
+            Corner v1 = corner(i, j);
+            Corner v2 = corner(i + 1, j);
+            Corner v3 = corner(i, j + 1);
+            Corner v4 = corner(i + 1, j + 1);
 
             // if 1st stack and last stack, store only 1 triangle per sector
             // otherwise, store 2 triangles (quad) per sector
             if (i == 0) // a triangle for first stack ==========================
             {
-                // put a triangle
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v4.x, v4.y, v4.z);
-
-                // put tex coords of triangle
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v4.s, v4.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x, v1.y, v1.z, v2.x, v2.y, v2.z, v4.x, v4.y, v4.z);
-                for (k = 0; k < 3; ++k)  // same normals for 3 vertices
-                {
-                    addNormal(n[0], n[1], n[2]);
-                }
+                computeFaceNormal(v1.p, v2.p, v4.p, n);
+                writeVertex(index,     v1.p[0], v1.p[1], v1.p[2], n[0], n[1], n[2], v1.s, v1.t);
+                writeVertex(index + 1, v2.p[0], v2.p[1], v2.p[2], n[0], n[1], n[2], v2.s, v2.t);
+                writeVertex(index + 2, v4.p[0], v4.p[1], v4.p[2], n[0], n[1], n[2], v4.s, v4.t);
 
                 // put indices of 1 triangle
-                addIndices(index, index + 1, index + 2);
-
-                // indices for line (first stack requires only vertical line)
-                lineIndices.push_back(index);
-                lineIndices.push_back(index + 1);
+                *tri++ = index; *tri++ = index + 1; *tri++ = index + 2;
 
                 index += 3;     // for next
             }
             else if (i == (stackCount - 1)) // a triangle for last stack =========
             {
-                // put a triangle
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v3.x, v3.y, v3.z);
-
-                // put tex coords of triangle
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v3.s, v3.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x, v1.y, v1.z, v2.x, v2.y, v2.z, v3.x, v3.y, v3.z);
-                for (k = 0; k < 3; ++k)  // same normals for 3 vertices
-                {
-                    addNormal(n[0], n[1], n[2]);
-                }
+                computeFaceNormal(v1.p, v2.p, v3.p, n);
+                writeVertex(index,     v1.p[0], v1.p[1], v1.p[2], n[0], n[1], n[2], v1.s, v1.t);
+                writeVertex(index + 1, v2.p[0], v2.p[1], v2.p[2], n[0], n[1], n[2], v2.s, v2.t);
+                writeVertex(index + 2, v3.p[0], v3.p[1], v3.p[2], n[0], n[1], n[2], v3.s, v3.t);
 
                 // put indices of 1 triangle
-                addIndices(index, index + 1, index + 2);
-
-                // indices for lines (last stack requires both vert/hori lines)
-                lineIndices.push_back(index);
-                lineIndices.push_back(index + 1);
-                lineIndices.push_back(index);
-                lineIndices.push_back(index + 2);
+                *tri++ = index; *tri++ = index + 1; *tri++ = index + 2;
 
                 index += 3;     // for next
             }
             else // 2 triangles for others ====================================
             {
                 // put quad vertices: v1-v2-v3-v4
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v3.x, v3.y, v3.z);
-                addVertex(v4.x, v4.y, v4.z);
-
-                // put tex coords of quad
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v3.s, v3.t);
-                addTexCoord(v4.s, v4.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x, v1.y, v1.z, v2.x, v2.y, v2.z, v3.x, v3.y, v3.z);
-                for (k = 0; k < 4; ++k)  // same normals for 4 vertices
-                {
-                    addNormal(n[0], n[1], n[2]);
-                }
+                computeFaceNormal(v1.p, v2.p, v3.p, n);
+                writeVertex(index,     v1.p[0], v1.p[1], v1.p[2], n[0], n[1], n[2], v1.s, v1.t);
+                writeVertex(index + 1, v2.p[0], v2.p[1], v2.p[2], n[0], n[1], n[2], v2.s, v2.t);
+                writeVertex(index + 2, v3.p[0], v3.p[1], v3.p[2], n[0], n[1], n[2], v3.s, v3.t);
+                writeVertex(index + 3, v4.p[0], v4.p[1], v4.p[2], n[0], n[1], n[2], v4.s, v4.t);
 
                 // put indices of quad (2 triangles)
-                addIndices(index, index + 1, index + 2);
-                addIndices(index + 2, index + 1, index + 3);
-
-                // indices for lines
-                lineIndices.push_back(index);
-                lineIndices.push_back(index + 1);
-                lineIndices.push_back(index);
-                lineIndices.push_back(index + 2);
+                *tri++ = index;     *tri++ = index + 1; *tri++ = index + 2;
+                *tri++ = index + 2; *tri++ = index + 1; *tri++ = index + 3;
 
                 index += 4;     // for next
             }
         }
-    }
-
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
+    });
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate interleaved vertices: V/N/T
-// stride must be 32 bytes
+// line indices for wireframe, vertical lines for all stacks and horizontal
+// lines except 1st stack; only depends on the tessellation, not on vertices
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::buildInterleavedVertices()
+void Sphere::buildLineIndices(unsigned int* lines) const
 {
-    std::vector<float>().swap(interleavedVertices);
-
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for (i = 0, j = 0; i < count; i += 3, j += 2)
+    unsigned int index = 0;
+    for (int i = 0; i < stackCount; ++i)
     {
-        interleavedVertices.push_back(vertices[i]);
-        interleavedVertices.push_back(vertices[i + 1]);
-        interleavedVertices.push_back(vertices[i + 2]);
-
-        interleavedVertices.push_back(normals[i]);
-        interleavedVertices.push_back(normals[i + 1]);
-        interleavedVertices.push_back(normals[i + 2]);
-
-        interleavedVertices.push_back(texCoords[j]);
-        interleavedVertices.push_back(texCoords[j + 1]);
+        for (int j = 0; j < sectorCount; ++j)
+        {
+            if (smooth)
+            {
+                unsigned int k1 = i * (sectorCount + 1) + j;    // current stack
+                unsigned int k2 = k1 + sectorCount + 1;         // next stack
+                *lines++ = k1;
+                *lines++ = k2;
+                if (i != 0)
+                {
+                    *lines++ = k1;
+                    *lines++ = k1 + 1;
+                }
+            }
+            else
+            {
+                // v1 is the first vertex of the sector, v2 below it, v3 next to it
+                *lines++ = index;
+                *lines++ = index + 1;
+                if (i != 0)
+                {
+                    *lines++ = index;
+                    *lines++ = index + 2;
+                }
+                index += (i == 0 || i == stackCount - 1) ? 3 : 4;
+            }
+        }
     }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single vertex to array
+// write single vertex to the interleaved output and, in CPU mode, to the
+// separate arrays; the output may be mapped GPU memory, so it is write-only
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addVertex(float x, float y, float z)
+void Sphere::writeVertex(std::size_t index, float x, float y, float z,
+    float nx, float ny, float nz, float s, float t)
 {
-    vertices.push_back(x);
-    vertices.push_back(y);
-    vertices.push_back(z);
-}
+    if (!vertices.empty())
+    {
+        float* v = &vertices[index * 3];
+        v[0] = x; v[1] = y; v[2] = z;
 
+        float* n = &normals[index * 3];
+        n[0] = nx; n[1] = ny; n[2] = nz;
 
+        float* tc = &texCoords[index * 2];
+        tc[0] = s; tc[1] = t;
+    }
 
-///////////////////////////////////////////////////////////////////////////////
-// add single normal to array
-///////////////////////////////////////////////////////////////////////////////
-void Sphere::addNormal(float nx, float ny, float nz)
-{
-    normals.push_back(nx);
-    normals.push_back(ny);
-    normals.push_back(nz);
+    float* out = interleavedOut + index * 8;
+    out[0] = x;  out[1] = y;  out[2] = z;
+    out[3] = nx; out[4] = ny; out[5] = nz;
+    out[6] = s;  out[7] = t;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single texture coord to array
+// offset of the first triangle index of a stack
+// 1st and last stacks have 1 triangle per sector, the others 2
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addTexCoord(float s, float t)
+std::size_t Sphere::getStackIndexOffset(int stack) const
 {
-    texCoords.push_back(s);
-    texCoords.push_back(t);
+    return stack == 0 ? 0 : (std::size_t)3 * sectorCount + (std::size_t)(stack - 1) * 6 * sectorCount;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add 3 indices to array
+// cos/sin of angles 0, step, 2*step ... count*step using the angle addition
+// recurrence instead of calling cosf/sinf for every vertex
+// the recurrence runs in double, so the error stays far below float precision
+// even for very fine tessellations
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addIndices(unsigned int i1, unsigned int i2, unsigned int i3)
+void Sphere::computeAngles(int count, float step, std::vector<float>& cosines, std::vector<float>& sines)
 {
-    indices.push_back(i1);
-    indices.push_back(i2);
-    indices.push_back(i3);
-}
-
+    cosines.resize(count + 1);
+    sines.resize(count + 1);
+
+    const double PI = acos(-1.0);
+    const double stepCos = cos((double)step);
+    const double stepSin = sin((double)step);
+    double c = 1.0, s = 0.0;
+    for (int i = 0; i <= count; ++i)
+    {
+        cosines[i] = (float)c;
+        sines[i] = (float)s;
 
+        double next = c * stepCos - s * stepSin;
+        s = s * stepCos + c * stepSin;
+        c = next;
+    }
 
-///////////////////////////////////////////////////////////////////////////////
-// return face normal of a triangle v1-v2-v3
-// if a triangle has no surface (normal length = 0), then return a zero vector
-///////////////////////////////////////////////////////////////////////////////
-std::vector<float> Sphere::computeFaceNormal(float x1, float y1, float z1,  // v1
-    float x2, float y2, float z2,  // v2
-    float x3, float y3, float z3)  // v3
-{
-    const float EPSILON = 0.000001f;
-
-    std::vector<float> normal(3, 0.0f);     // default return value (0,0,0)
-    float nx, ny, nz;
-
-    // find 2 edge vectors: v1-v2, v1-v3
-    float ex1 = x2 - x1;
-    float ey1 = y2 - y1;
-    float ez1 = z2 - z1;
-    float ex2 = x3 - x1;
-    float ey2 = y3 - y1;
-    float ez2 = z3 - z1;
-
-    // cross product: e1 x e2
-    nx = ey1 * ez2 - ez1 * ey2;
-    ny = ez1 * ex2 - ex1 * ez2;
-    nz = ex1 * ey2 - ey1 * ex2;
-
-    // normalize only if the length is > 0
-    float length = sqrtf(nx * nx + ny * ny + nz * nz);
-    if (length > EPSILON)
+    // snap the last angle exactly (2pi for sectors, pi for stacks), so seams and poles are closed
+    double last = count * (double)step;
+    if (fabs(last - 2 * PI) < 1e-4)
     {
-        // normalize
-        float lengthInv = 1.0f / length;
-        normal[0] = nx * lengthInv;
-        normal[1] = ny * lengthInv;
-        normal[2] = nz * lengthInv;
+        cosines[count] = 1.0f;
+        sines[count] = 0.0f;
     }
-
-    return normal;
-}
\ No newline at end of file
+    else if (fabs(last - PI) < 1e-4)
+    {
+        cosines[count] = -1.0f;
+        sines[count] = 0.0f;
+    }
+}
@@ -3,13 +3,18 @@
 #define GEOMETRY_SPHERE_H
 
 #include <vector>
+#include "meshOptimizer.h"
+#include "sphereBuffers.h"
 
 class Sphere
 {
 public:
     // ctor/dtor
-    Sphere(float radius = 1.0f, int sectorCount = 36, int stackCount = 18, bool smooth = true);
-    ~Sphere() {}
+    // gpuResident: generate straight into GPU buffers and keep no CPU copies (needs a GL context)
+    Sphere(float radius = 1.0f, int sectorCount = 36, int stackCount = 18, bool smooth = true, bool gpuResident = false);
+    ~Sphere();
+    Sphere(const Sphere&) = delete;             // owns GL buffers
+    Sphere& operator=(const Sphere&) = delete;
 
     // getters/setters
     float getRadius() const { return radius; }
@@ -20,35 +25,52 @@ public:
     void setSectorCount(int sectorCount);
     void setStackCount(int stackCount);
     void setSmooth(bool smooth);
+    bool isGpuResident() const { return gpuResident; }
+
+    // tessellation estimate for a silhouette error (max distance between the mesh and the true sphere),
+    // assumes stackCount = sectorCount / 2, which keeps the cells near the equator square
+    static int getSectorCountForError(float radius, float maxError);
+    static unsigned int getTriangleCountForError(float radius, float maxError);
+    void getBounds(float min[3], float max[3]) const;
+
 
     // for vertex data
-    unsigned int getVertexCount() const { return (unsigned int)vertices.size() / 3; }
-    unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }
-    unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }
-    unsigned int getIndexCount() const { return (unsigned int)indices.size(); }
-    unsigned int getLineIndexCount() const { return (unsigned int)lineIndices.size(); }
+    // counts and sizes are valid in both modes, pointers are null for GPU-resident sphere
+    // (except line indices, which are built on first request)
+    unsigned int getVertexCount() const { return vertexCount; }
+    unsigned int getNormalCount() const { return vertexCount; }
+    unsigned int getTexCoordCount() const { return vertexCount; }
+    unsigned int getIndexCount() const { return indexCount; }
+    unsigned int getLineIndexCount() const { return lineIndexCount; }
     unsigned int getTriangleCount() const { return getIndexCount() / 3; }
-    unsigned int getVertexSize() const { return (unsigned int)vertices.size() * sizeof(float); }
-    unsigned int getNormalSize() const { return (unsigned int)normals.size() * sizeof(float); }
-    unsigned int getTexCoordSize() const { return (unsigned int)texCoords.size() * sizeof(float); }
-    unsigned int getIndexSize() const { return (unsigned int)indices.size() * sizeof(unsigned int); }
-    unsigned int getLineIndexSize() const { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
+    unsigned int getVertexSize() const { return vertexCount * 3 * sizeof(float); }
+    unsigned int getNormalSize() const { return vertexCount * 3 * sizeof(float); }
+    unsigned int getTexCoordSize() const { return vertexCount * 2 * sizeof(float); }
+    unsigned int getIndexSize() const { return indexCount * sizeof(unsigned int); }
+    unsigned int getLineIndexSize() const { return lineIndexCount * sizeof(unsigned int); }
     const float* getVertices() const { return vertices.data(); }
     const float* getNormals() const { return normals.data(); }
     const float* getTexCoords() const { return texCoords.data(); }
     const unsigned int* getIndices() const { return indices.data(); }
-    const unsigned int* getLineIndices() const { return lineIndices.data(); }
+    const unsigned int* getLineIndices() const;
 
     // for interleaved vertices: V/N/T
     unsigned int getInterleavedVertexCount() const { return getVertexCount(); }    // # of vertices
-    unsigned int getInterleavedVertexSize() const { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
+    unsigned int getInterleavedVertexSize() const { return vertexCount * interleavedStride; }    // # of bytes
     int getInterleavedStride() const { return interleavedStride; }   // should be 32 bytes
     const float* getInterleavedVertices() const { return interleavedVertices.data(); }
 
-    // draw in VertexArray mode
+    // draw from GPU buffers (VAO attributes: 0 = position, 1 = normal, 2 = tex coord)
     void draw() const;                                  // draw surface
     void drawLines(const float lineColor[4]) const;     // draw lines only
     void drawWithLines(const float lineColor[4]) const; // draw surface and lines
+    void upload() const;                                // copy CPU arrays to GPU now instead of on first draw
+    void releaseBuffers();                              // delete GL objects, must run while the context is alive
+
+    // reorder triangles/vertices for post-transform cache, overdraw and fetch locality
+    // must be called again after set*(), as those rebuild the arrays in scan-line order
+    // does nothing for GPU-resident sphere
+    MeshOptimizationReport optimize();
 
     // debug
     void printSelf() const;
@@ -57,17 +79,16 @@ protected:
 
 private:
     // member functions
+    void buildVertices();
     void buildVerticesSmooth();
     void buildVerticesFlat();
-    void buildInterleavedVertices();
+    void buildLineIndices(unsigned int* lines) const;
     void clearArrays();
-    void addVertex(float x, float y, float z);
-    void addNormal(float x, float y, float z);
-    void addTexCoord(float s, float t);
-    void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
-    std::vector<float> computeFaceNormal(float x1, float y1, float z1,
-        float x2, float y2, float z2,
-        float x3, float y3, float z3);
+    void uploadLines() const;
+    void writeVertex(std::size_t index, float x, float y, float z,
+        float nx, float ny, float nz, float s, float t);
+    std::size_t getStackIndexOffset(int stack) const;
+    static void computeAngles(int count, float step, std::vector<float>& cosines, std::vector<float>& sines);
 
     // memeber vars
     float radius;
@@ -78,11 +99,23 @@ private:
     std::vector<float> normals;
     std::vector<float> texCoords;
     std::vector<unsigned int> indices;
-    std::vector<unsigned int> lineIndices;
+    mutable std::vector<unsigned int> lineIndices;   // built on demand
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;
 
     // interleaved
     std::vector<float> interleavedVertices;
     int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+
+    // GL objects, filled by the first draw in CPU mode, on build in GPU-resident mode
+    // (line indices by the first drawLines())
+    bool gpuResident;
+    mutable SphereBuffers buffers;
+
+    // where the build functions write to, CPU arrays or mapped GPU buffers
+    float* interleavedOut;
+    unsigned int* indexOut;
 };
 
 #endif
@@ -0,0 +1,291 @@
+#include <glad/glad.h>
+
+#include <iostream>
+#include <cmath>
+#include "sphereBuffers.h"
+#include "meshOptimizer.h"
+#include "glState.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const int INTERLEAVED_STRIDE = 8 * sizeof(float);  // V/N/T
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor/dtor
+///////////////////////////////////////////////////////////////////////////////
+SphereBuffers::SphereBuffers()
+    : vao(0), vbo(0), ibo(0), lineIbo(0), uploaded(false), linesUploaded(false), indexByteSize(4)
+{
+}
+
+SphereBuffers::~SphereBuffers()
+{
+    release();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// index size of the next uploads, the buffers have to be filled again
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::setIndexByteSize(unsigned int size)
+{
+    indexByteSize = size;
+    invalidate();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy interleaved vertices and triangle indices to the GPU buffers
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::upload(const float* interleavedVertices, unsigned int vertexCount,
+    const unsigned int* indices, unsigned int indexCount)
+{
+    uploadBuffer(vbo, (std::size_t)vertexCount * INTERLEAVED_STRIDE, interleavedVertices);
+    uploadIndices(ibo, indices, indexCount);
+    uploaded = true;
+}
+
+void SphereBuffers::uploadLines(const unsigned int* lineIndices, unsigned int lineIndexCount)
+{
+    uploadIndices(lineIbo, lineIndices, lineIndexCount);
+    linesUploaded = true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// map vertex and index buffers for writing, the generator writes to GPU
+// memory directly; on failure nothing stays mapped and the caller uploads
+// from a CPU copy instead
+///////////////////////////////////////////////////////////////////////////////
+bool SphereBuffers::beginMap(unsigned int vertexCount, unsigned int indexCount,
+    float*& interleavedVertices, unsigned int*& indices)
+{
+    if (indexByteSize != sizeof(unsigned int))
+        return false;   // generators write 32 bit indices
+
+    interleavedVertices = (float*)mapBuffer(vbo, (std::size_t)vertexCount * INTERLEAVED_STRIDE);
+    indices = (unsigned int*)mapBuffer(ibo, (std::size_t)indexCount * sizeof(unsigned int));
+    if (interleavedVertices != nullptr && indices != nullptr)
+        return true;
+
+    std::cout << "ERROR::SPHERE::MAP_BUFFER_FAILED, uploading from a temporary copy" << std::endl;
+    if (interleavedVertices != nullptr)
+        unmapBuffer(vbo);
+    if (indices != nullptr)
+        unmapBuffer(ibo);
+    interleavedVertices = nullptr;
+    indices = nullptr;
+    return false;
+}
+
+bool SphereBuffers::endMap()
+{
+    bool vertices = unmapBuffer(vbo);
+    bool indices = unmapBuffer(ibo);
+    uploaded = vertices && indices;
+    return uploaded;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw triangles / lines from the VAO
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::draw(unsigned int indexCount) const
+{
+    bindVertexArray();
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glDrawElements(GL_TRIANGLES, indexCount, getIndexType(indexByteSize), (void*)0);
+}
+
+void SphereBuffers::drawLines(const float lineColor[4], unsigned int lineIndexCount) const
+{
+    bindVertexArray();
+    glVertexAttrib4fv(3, lineColor);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, lineIbo);
+    glDrawElements(GL_LINES, lineIndexCount, getIndexType(indexByteSize), (void*)0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw surfaces and lines on top of it
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::drawWithLines(const float lineColor[4], unsigned int indexCount, unsigned int lineIndexCount) const
+{
+    GLState::setEnabled(GL_POLYGON_OFFSET_FILL, true);
+    glPolygonOffset(1.0, 1.0f); // move polygon backward
+    draw(indexCount);
+    GLState::setEnabled(GL_POLYGON_OFFSET_FILL, false);
+
+    drawLines(lineColor, lineIndexCount);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete VAO and GL buffers
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::release()
+{
+    if (vao != 0)
+        GLState::deleteVertexArrays(1, &vao);
+
+    unsigned int buffers[] = { vbo, ibo, lineIbo };
+    for (unsigned int buffer : buffers)
+    {
+        if (buffer != 0)
+            GLState::deleteBuffers(1, &buffer);
+    }
+    vao = vbo = ibo = lineIbo = 0;
+    uploaded = linesUploaded = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// bind VAO, set up on first use (vbo must exist by then)
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::bindVertexArray() const
+{
+    if (vao != 0)
+    {
+        GLState::bindVertexArray(vao);
+        return;
+    }
+
+    glGenVertexArrays(1, &vao);
+    GLState::bindVertexArray(vao);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, INTERLEAVED_STRIDE, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, INTERLEAVED_STRIDE, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, INTERLEAVED_STRIDE, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// upload indices with the buffers' index size
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::uploadIndices(unsigned int& buffer, const unsigned int* data, unsigned int count)
+{
+    if (indexByteSize == sizeof(unsigned int))
+    {
+        uploadBuffer(buffer, (std::size_t)count * sizeof(unsigned int), data);
+        return;
+    }
+
+    std::vector<unsigned char> packed = packIndices(std::vector<unsigned int>(data, data + count), indexByteSize);
+    uploadBuffer(buffer, packed.size(), packed.data());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GL buffer helpers, they go through GL_COPY_WRITE_BUFFER, so no VAO state
+// is touched when the mesh is (re)built
+///////////////////////////////////////////////////////////////////////////////
+void SphereBuffers::uploadBuffer(unsigned int& buffer, std::size_t size, const void* data)
+{
+    if (buffer == 0)
+        glGenBuffers(1, &buffer);
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STATIC_DRAW);
+}
+
+void* SphereBuffers::mapBuffer(unsigned int& buffer, std::size_t size)
+{
+    if (buffer == 0)
+        glGenBuffers(1, &buffer);
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
+    return glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+bool SphereBuffers::unmapBuffer(unsigned int buffer)
+{
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_FALSE)
+    {
+        std::cout << "ERROR::SPHERE::BUFFER_CONTENTS_LOST_WHILE_MAPPED" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// return face normal of a triangle v1-v2-v3
+// if a triangle has no surface (normal length = 0), then return a zero vector
+///////////////////////////////////////////////////////////////////////////////
+void computeFaceNormal(const float v1[3], const float v2[3], const float v3[3], float normal[3])
+{
+    const float EPSILON = 0.000001f;
+
+    // default return value (0,0,0)
+    normal[0] = normal[1] = normal[2] = 0.0f;
+
+    // find 2 edge vectors: v1-v2, v1-v3
+    float ex1 = v2[0] - v1[0];
+    float ey1 = v2[1] - v1[1];
+    float ez1 = v2[2] - v1[2];
+    float ex2 = v3[0] - v1[0];
+    float ey2 = v3[1] - v1[1];
+    float ez2 = v3[2] - v1[2];
+
+    // cross product: e1 x e2
+    float nx = ey1 * ez2 - ez1 * ey2;
+    float ny = ez1 * ex2 - ex1 * ez2;
+    float nz = ex1 * ey2 - ey1 * ex2;
+
+    // normalize only if the length is > 0
+    float length = sqrtf(nx * nx + ny * ny + nz * nz);
+    if (length > EPSILON)
+    {
+        // normalize
+        float lengthInv = 1.0f / length;
+        normal[0] = nx * lengthInv;
+        normal[1] = ny * lengthInv;
+        normal[2] = nz * lengthInv;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// generate interleaved vertices: V/N/T
+// stride must be 32 bytes
+///////////////////////////////////////////////////////////////////////////////
+void interleaveVertices(const std::vector<float>& vertices, const std::vector<float>& normals,
+    const std::vector<float>& texCoords, std::vector<float>& interleavedVertices)
+{
+    std::size_t count = vertices.size() / 3;
+    interleavedVertices.resize(count * 8);
+
+    float* out = interleavedVertices.data();
+    for (std::size_t i = 0; i < count; ++i, out += 8)
+    {
+        out[0] = vertices[i * 3];
+        out[1] = vertices[i * 3 + 1];
+        out[2] = vertices[i * 3 + 2];
+
+        out[3] = normals[i * 3];
+        out[4] = normals[i * 3 + 1];
+        out[5] = normals[i * 3 + 2];
+
+        out[6] = texCoords[i * 2];
+        out[7] = texCoords[i * 2 + 1];
+    }
+}
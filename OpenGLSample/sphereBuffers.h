@@ -0,0 +1,69 @@
+#ifndef GEOMETRY_SPHERE_BUFFERS_H
+#define GEOMETRY_SPHERE_BUFFERS_H
+
+#include <cstddef>
+#include <vector>
+
+// GL side of the sphere meshes (Sphere, Icosphere): interleaved V/N/T vertex
+// buffer (32 bytes stride), triangle and line index buffers and the VAO over
+// them (attributes: 0 = position, 1 = normal, 2 = tex coord).
+// Indices are given as 32 bit and stored with the index size set by the owner.
+class SphereBuffers
+{
+public:
+    SphereBuffers();
+    ~SphereBuffers();
+    SphereBuffers(const SphereBuffers&) = delete;   // owns GL objects
+    SphereBuffers& operator=(const SphereBuffers&) = delete;
+
+    // 2 or 4 bytes per index, for the next uploads; drops the uploaded data
+    void setIndexByteSize(unsigned int size);
+    unsigned int getIndexByteSize() const { return indexByteSize; }
+
+    // copy vertices and triangle indices, or write them straight into mapped buffers
+    // (32 bit indices only); endMap() returns false if the contents were lost
+    void upload(const float* interleavedVertices, unsigned int vertexCount,
+        const unsigned int* indices, unsigned int indexCount);
+    bool beginMap(unsigned int vertexCount, unsigned int indexCount, float*& interleavedVertices, unsigned int*& indices);
+    bool endMap();
+    void uploadLines(const unsigned int* lineIndices, unsigned int lineIndexCount);
+
+    // the data changed, next draw must upload it again (keeps the GL objects)
+    void invalidate() { uploaded = linesUploaded = false; }
+    bool isUploaded() const { return uploaded; }
+    bool isLinesUploaded() const { return linesUploaded; }
+
+    // OpenGL RC and the shader program must be set, the caller must set the line width for lines
+    // the line colour is passed as constant vertex attribute 3 for the caller's shader
+    void draw(unsigned int indexCount) const;
+    void drawLines(const float lineColor[4], unsigned int lineIndexCount) const;
+    void drawWithLines(const float lineColor[4], unsigned int indexCount, unsigned int lineIndexCount) const;
+
+    // delete GL objects, must run while the context is alive
+    void release();
+
+private:
+    void bindVertexArray() const;
+    void uploadIndices(unsigned int& buffer, const unsigned int* data, unsigned int count);
+    static void uploadBuffer(unsigned int& buffer, std::size_t size, const void* data);
+    static void* mapBuffer(unsigned int& buffer, std::size_t size);
+    static bool unmapBuffer(unsigned int buffer);
+
+    mutable unsigned int vao;               // created by the first draw
+    unsigned int vbo;
+    unsigned int ibo;
+    unsigned int lineIbo;
+    bool uploaded;                          // vbo/ibo hold the current vertices
+    bool linesUploaded;                     // lineIbo holds the current line indices
+    unsigned int indexByteSize;             // 2 or 4 bytes per index in ibo/lineIbo
+};
+
+// face normal of a triangle v1-v2-v3
+// if a triangle has no surface (normal length = 0), then return a zero vector
+void computeFaceNormal(const float v1[3], const float v2[3], const float v3[3], float normal[3]);
+
+// interleave separate V/N/T arrays (3/3/2 floats per vertex) to 8 floats per vertex
+void interleaveVertices(const std::vector<float>& vertices, const std::vector<float>& normals,
+    const std::vector<float>& texCoords, std::vector<float>& interleavedVertices);
+
+#endif
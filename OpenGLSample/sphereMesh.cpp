@@ -0,0 +1,305 @@
+#ifdef _WIN32
+#define _USE_MATH_DEFINES // for C++
+#include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
+#endif
+
+#include <iostream>
+#include <cmath>
+#include "sphereMesh.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor/dtor
+///////////////////////////////////////////////////////////////////////////////
+SphereMesh::SphereMesh(const char* name)
+    : name(name), radius(1.0f), subdivision(0), smooth(true), interleavedStride(32)
+{
+}
+
+SphereMesh::~SphereMesh()
+{
+    releaseBuffers();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::set(float radius, int subdivision, bool smooth)
+{
+    this->radius = radius;
+    this->subdivision = subdivision;
+    if (subdivision < 0)
+        this->subdivision = 0;
+    if (subdivision > MAX_SUBDIVISION)
+        this->subdivision = MAX_SUBDIVISION;
+    this->smooth = smooth;
+
+    buildVertices();
+}
+
+void SphereMesh::setRadius(float radius)
+{
+    if (radius != this->radius)
+        set(radius, subdivision, smooth);
+}
+
+void SphereMesh::setSubdivision(int subdivision)
+{
+    if (subdivision != this->subdivision)
+        set(radius, subdivision, smooth);
+}
+
+void SphereMesh::setSmooth(bool smooth)
+{
+    if (smooth != this->smooth)
+        set(radius, subdivision, smooth);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// axis aligned bounds
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::getBounds(float min[3], float max[3]) const
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        min[i] = -radius;
+        max[i] = radius;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// silhouette error of the tessellation: the deepest point of a flat triangle
+// below the sphere surface is the foot of the perpendicular from the center
+///////////////////////////////////////////////////////////////////////////////
+float SphereMesh::getMaxError() const
+{
+    float maxError = 0;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const float* v1 = &vertices[indices[i] * 3];
+        const float* v2 = &vertices[indices[i + 1] * 3];
+        const float* v3 = &vertices[indices[i + 2] * 3];
+
+        float n[3];
+        computeFaceNormal(v1, v2, v3, n);
+        float distance = fabsf(n[0] * v1[0] + n[1] * v1[1] + n[2] * v1[2]);
+        if (radius - distance > maxError)
+            maxError = radius - distance;
+    }
+    return maxError;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// print itself
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::printSelf() const
+{
+    std::cout << "===== " << name << " =====\n"
+        << "        Radius: " << radius << "\n"
+        << "   Subdivision: " << subdivision << "\n"
+        << "Smooth Shading: " << (smooth ? "true" : "false") << "\n"
+        << "Triangle Count: " << getTriangleCount() << "\n"
+        << "   Index Count: " << getIndexCount() << "\n"
+        << "  Vertex Count: " << getVertexCount() << "\n"
+        << "  Normal Count: " << getNormalCount() << "\n"
+        << "TexCoord Count: " << getTexCoordCount() << "\n"
+        << "     Max Error: " << getMaxError() << std::endl;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw from the VAO
+// OpenGL RC and the shader program must be set before calling it
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::draw() const
+{
+    upload();
+    buffers.draw(getIndexCount());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw lines only
+// the line colour is passed as constant vertex attribute 3 for the caller's shader
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::drawLines(const float lineColor[4]) const
+{
+    upload();
+    uploadLines();
+    buffers.drawLines(lineColor, getLineIndexCount());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw surfaces and lines on top of it
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::drawWithLines(const float lineColor[4]) const
+{
+    upload();
+    uploadLines();
+    buffers.drawWithLines(lineColor, getIndexCount(), getLineIndexCount());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy vertices and indices to the GPU buffers, does nothing if they are
+// up to date
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::upload() const
+{
+    if (!buffers.isUploaded())
+        buffers.upload(interleavedVertices.data(), getVertexCount(), indices.data(), getIndexCount());
+}
+
+void SphereMesh::uploadLines() const
+{
+    if (!buffers.isLinesUploaded())
+        buffers.uploadLines(lineIndices.data(), getLineIndexCount());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete VAO and GL buffers
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::releaseBuffers()
+{
+    buffers.release();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// reorder indices for vertex cache and overdraw, then vertices in order of
+// first use; line indices are remapped to the new vertex order as well
+///////////////////////////////////////////////////////////////////////////////
+MeshOptimizationReport SphereMesh::optimize()
+{
+    std::vector<unsigned int> remap;
+    MeshOptimizationReport report = optimizeMesh(indices, vertices.data(), 3 * sizeof(float), getVertexCount(), remap);
+
+    remapVertices(vertices, remap, 3);
+    remapVertices(normals, remap, 3);
+    remapVertices(texCoords, remap, 2);
+    for (std::size_t i = 0; i < lineIndices.size(); ++i)
+        lineIndices[i] = remap[lineIndices[i]];
+
+    interleaveVertices(vertices, normals, texCoords, interleavedVertices);
+    buffers.invalidate();
+    return report;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// rebuild all arrays for current radius/subdivision/shading
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::buildVertices()
+{
+    clearArrays();
+
+    if (smooth)
+        buildVerticesSmooth();
+    else
+        buildVerticesFlat();
+
+    interleaveVertices(vertices, normals, texCoords, interleavedVertices);
+
+    // 16 bit indices when they can address all vertices (8 bit indices are not native on all GPUs)
+    buffers.setIndexByteSize(getVertexCount() > 0x10000 ? sizeof(unsigned int) : sizeof(unsigned short));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dealloc vectors
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::clearArrays()
+{
+    std::vector<float>().swap(vertices);
+    std::vector<float>().swap(normals);
+    std::vector<float>().swap(texCoords);
+    std::vector<unsigned int>().swap(indices);
+    std::vector<unsigned int>().swap(lineIndices);
+    std::vector<float>().swap(interleavedVertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// reserve exact sizes, so generation never reallocates
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::reserveArrays(std::size_t vertexCount, std::size_t indexCount, std::size_t lineIndexCount)
+{
+    vertices.reserve(vertexCount * 3);
+    normals.reserve(vertexCount * 3);
+    texCoords.reserve(vertexCount * 2);
+    indices.reserve(indexCount);
+    lineIndices.reserve(lineIndexCount);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// add single vertex with normal and tex coord
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::addVertex(float x, float y, float z, float nx, float ny, float nz, float s, float t)
+{
+    vertices.push_back(x);
+    vertices.push_back(y);
+    vertices.push_back(z);
+    normals.push_back(nx);
+    normals.push_back(ny);
+    normals.push_back(nz);
+    texCoords.push_back(s);
+    texCoords.push_back(t);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// add 3 indices of a triangle / 2 indices of a line
+///////////////////////////////////////////////////////////////////////////////
+void SphereMesh::addIndices(unsigned int i1, unsigned int i2, unsigned int i3)
+{
+    indices.push_back(i1);
+    indices.push_back(i2);
+    indices.push_back(i3);
+}
+
+void SphereMesh::addLineIndices(unsigned int i1, unsigned int i2)
+{
+    lineIndices.push_back(i1);
+    lineIndices.push_back(i2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// a flat triangle whose circumcircle spans angle a (seen from the center)
+// stays r * (1 - cos(a)) below the sphere in its middle; returns a for the
+// given error
+///////////////////////////////////////////////////////////////////////////////
+float SphereMesh::getAngleForError(float radius, float maxError)
+{
+    if (radius <= 0 || maxError >= radius)
+        return acosf(0.0f);
+    if (maxError <= 0)
+        return 0.0f;
+    return acosf(1.0f - maxError / radius);
+}
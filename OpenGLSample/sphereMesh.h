@@ -0,0 +1,107 @@
+#ifndef GEOMETRY_SPHERE_MESH_H
+#define GEOMETRY_SPHERE_MESH_H
+
+#include <vector>
+#include "meshOptimizer.h"
+#include "sphereBuffers.h"
+
+// Common part of the subdivision spheres (Icosphere): vertex arrays, wireframe
+// indices and drawing from GPU buffers (SphereBuffers, as Sphere), with the
+// same API as Sphere. Derived classes only generate vertices for smooth and
+// flat shading.
+class SphereMesh
+{
+public:
+    virtual ~SphereMesh();
+    SphereMesh(const SphereMesh&) = delete;     // owns GL buffers
+    SphereMesh& operator=(const SphereMesh&) = delete;
+
+    // getters/setters
+    float getRadius() const { return radius; }
+    int getSubdivision() const { return subdivision; }
+    bool isSmooth() const { return smooth; }
+    void set(float radius, int subdivision, bool smooth = true);
+    void setRadius(float radius);
+    void setSubdivision(int subdivision);
+    void setSmooth(bool smooth);
+    void getBounds(float min[3], float max[3]) const;
+    float getMaxError() const;                  // largest distance between a triangle and the ideal sphere
+
+    // for vertex data
+    unsigned int getVertexCount() const { return (unsigned int)vertices.size() / 3; }
+    unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }
+    unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }
+    unsigned int getIndexCount() const { return (unsigned int)indices.size(); }
+    unsigned int getLineIndexCount() const { return (unsigned int)lineIndices.size(); }
+    unsigned int getTriangleCount() const { return getIndexCount() / 3; }
+    unsigned int getVertexSize() const { return (unsigned int)vertices.size() * sizeof(float); }
+    unsigned int getNormalSize() const { return (unsigned int)normals.size() * sizeof(float); }
+    unsigned int getTexCoordSize() const { return (unsigned int)texCoords.size() * sizeof(float); }
+    unsigned int getIndexSize() const { return (unsigned int)indices.size() * sizeof(unsigned int); }
+    unsigned int getLineIndexSize() const { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
+    const float* getVertices() const { return vertices.data(); }
+    const float* getNormals() const { return normals.data(); }
+    const float* getTexCoords() const { return texCoords.data(); }
+    const unsigned int* getIndices() const { return indices.data(); }
+    const unsigned int* getLineIndices() const { return lineIndices.data(); }
+
+    // for interleaved vertices: V/N/T
+    unsigned int getInterleavedVertexCount() const { return getVertexCount(); }    // # of vertices
+    unsigned int getInterleavedVertexSize() const { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
+    int getInterleavedStride() const { return interleavedStride; }   // should be 32 bytes
+    const float* getInterleavedVertices() const { return interleavedVertices.data(); }
+
+    // draw from GPU buffers (VAO attributes: 0 = position, 1 = normal, 2 = tex coord)
+    void draw() const;                                  // draw surface
+    void drawLines(const float lineColor[4]) const;     // draw lines only
+    void drawWithLines(const float lineColor[4]) const; // draw surface and lines
+    void upload() const;                                // copy arrays to GPU now instead of on first draw
+    void releaseBuffers();                              // delete GL objects, must run while the context is alive
+
+    // reorder triangles/vertices for post-transform cache, overdraw and fetch locality
+    // must be called again after set*(), as those rebuild the arrays
+    MeshOptimizationReport optimize();
+
+    // debug
+    void printSelf() const;
+
+protected:
+    static const int MAX_SUBDIVISION = 10;
+
+    SphereMesh(const char* name);
+
+    // fill vertices/normals/texCoords/indices/lineIndices, arrays are cleared before
+    virtual void buildVerticesSmooth() = 0;
+    virtual void buildVerticesFlat() = 0;
+
+    void reserveArrays(std::size_t vertexCount, std::size_t indexCount, std::size_t lineIndexCount);
+    void addVertex(float x, float y, float z, float nx, float ny, float nz, float s, float t);
+    void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
+    void addLineIndices(unsigned int i1, unsigned int i2);
+    static float getAngleForError(float radius, float maxError);    // triangle circumradius (radians) giving the error
+
+    // memeber vars
+    const char* name;
+    float radius;
+    int subdivision;
+    bool smooth;
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lineIndices;
+
+private:
+    void buildVertices();
+    void clearArrays();
+    void uploadLines() const;
+
+    // interleaved
+    std::vector<float> interleavedVertices;
+    int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+
+    // GL objects, filled by the first draw
+    mutable SphereBuffers buffers;
+};
+
+#endif
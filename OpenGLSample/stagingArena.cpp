@@ -0,0 +1,153 @@
+#include <cstring>
+#include <utility>
+
+#include "common/stagingArena.h"
+
+const size_t StagingArena::DEFAULT_PAGE_SIZE = 256 * 1024;
+const size_t StagingArena::ALIGNMENT = 16;
+
+namespace {
+
+size_t alignSize(size_t sizeBytes)
+{
+	return (sizeBytes + StagingArena::ALIGNMENT - 1) & ~(StagingArena::ALIGNMENT - 1);
+}
+
+} // namespace
+
+StagingArena::StagingArena(size_t pageSize)
+	: _pageSize(alignSize(pageSize > 0 ? pageSize : DEFAULT_PAGE_SIZE)) {}
+
+StagingArena& StagingArena::getShared()
+{
+	static StagingArena arena;
+	return arena;
+}
+
+StagingArena::Allocation StagingArena::allocate(size_t sizeBytes)
+{
+	Allocation result;
+	if (sizeBytes == 0) {
+		return result;
+	}
+
+	const auto alignedSize = alignSize(sizeBytes);
+	if (_pages.empty() || _pages[_currentPage].used + alignedSize > _pages[_currentPage].size)
+	{
+		// Move to the next page; pages after the current one are empty, take the first one big enough
+		const auto nextPage = _pages.empty() ? 0 : _currentPage + 1;
+		auto found = nextPage;
+		while (found < _pages.size() && _pages[found].size < alignedSize) {
+			found++;
+		}
+
+		if (found < _pages.size()) {
+			std::swap(_pages[nextPage], _pages[found]);
+		}
+		else
+		{
+			Page page;
+			page.size = alignedSize > _pageSize ? alignedSize : _pageSize;
+			page.memory.reset(new unsigned char[page.size]);
+			_pages.insert(_pages.begin() + nextPage, std::move(page));
+		}
+		_currentPage = nextPage;
+	}
+
+	auto& page = _pages[_currentPage];
+	page.lastOffset = page.used;
+	page.used += alignedSize;
+
+	result.data = page.memory.get() + page.lastOffset;
+	result.capacity = alignedSize;
+	result.generation = _generation;
+	return result;
+}
+
+void StagingArena::grow(Allocation& allocation, size_t usedBytes, size_t newCapacity)
+{
+	if (newCapacity <= allocation.capacity && isValid(allocation)) {
+		return;
+	}
+
+	const auto alignedCapacity = alignSize(newCapacity);
+	if (isLastAllocation(allocation))
+	{
+		auto& page = _pages[_currentPage];
+		if (page.lastOffset + alignedCapacity <= page.size)
+		{
+			page.used = page.lastOffset + alignedCapacity;
+			allocation.capacity = alignedCapacity;
+			return;
+		}
+	}
+
+	auto moved = allocate(alignedCapacity);
+	if (usedBytes > 0 && isValid(allocation)) {
+		memcpy(moved.data, allocation.data, usedBytes);
+	}
+	allocation = moved;
+}
+
+void StagingArena::release(Allocation& allocation)
+{
+	if (isLastAllocation(allocation)) {
+		_pages[_currentPage].used = _pages[_currentPage].lastOffset;
+	}
+
+	allocation = Allocation();
+}
+
+bool StagingArena::isValid(const Allocation& allocation) const
+{
+	return allocation.data != nullptr && allocation.generation == _generation;
+}
+
+void StagingArena::reset()
+{
+	// Oversized pages were made for one big mesh, don't keep them around
+	std::vector<Page> keptPages;
+	for (auto& page : _pages)
+	{
+		if (page.size <= _pageSize)
+		{
+			page.used = 0;
+			page.lastOffset = 0;
+			keptPages.push_back(std::move(page));
+		}
+	}
+
+	_pages = std::move(keptPages);
+	_currentPage = 0;
+	_generation++;
+}
+
+size_t StagingArena::getBytesUsed() const
+{
+	size_t result = 0;
+	for (const auto& page : _pages) {
+		result += page.used;
+	}
+
+	return result;
+}
+
+size_t StagingArena::getBytesReserved() const
+{
+	size_t result = 0;
+	for (const auto& page : _pages) {
+		result += page.size;
+	}
+
+	return result;
+}
+
+bool StagingArena::isLastAllocation(const Allocation& allocation) const
+{
+	if (!isValid(allocation) || _pages.empty()) {
+		return false;
+	}
+
+	const auto& page = _pages[_currentPage];
+	return page.used > 0 && allocation.data == page.memory.get() + page.lastOffset;
+}
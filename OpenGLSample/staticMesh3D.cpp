@@ -1,4 +1,9 @@
 #include "common/staticMesh3D.h"
+#include "glState.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
 
 #include <glm/glm.hpp>
 
@@ -8,23 +13,55 @@ const int StaticMesh3D::POSITION_ATTRIBUTE_INDEX           = 0;
 const int StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
 const int StaticMesh3D::NORMAL_ATTRIBUTE_INDEX             = 2;
 
-StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
+StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
 	: _hasPositions(withPositions)
 	, _hasTextureCoordinates(withTextureCoordinates)
-	, _hasNormals(withNormals) {}
+	, _hasNormals(withNormals)
+	, _vertexLayout(vertexLayout) {}
 
 StaticMesh3D::~StaticMesh3D()
 {
 	deleteMesh();
 }
 
+StaticMesh3D::StaticMesh3D(StaticMesh3D&& other) noexcept
+	: _hasPositions(other._hasPositions)
+	, _hasTextureCoordinates(other._hasTextureCoordinates)
+	, _hasNormals(other._hasNormals)
+	, _vertexLayout(other._vertexLayout)
+	, _isInitialized(other._isInitialized)
+	, _vao(std::move(other._vao))
+	, _vbo(std::move(other._vbo))
+{
+	// Moved-from mesh must not delete anything anymore
+	other._isInitialized = false;
+}
+
+StaticMesh3D& StaticMesh3D::operator=(StaticMesh3D&& other) noexcept
+{
+	if (this != &other)
+	{
+		deleteMesh();
+		_hasPositions = other._hasPositions;
+		_hasTextureCoordinates = other._hasTextureCoordinates;
+		_hasNormals = other._hasNormals;
+		_vertexLayout = other._vertexLayout;
+		_isInitialized = other._isInitialized;
+		_vao = std::move(other._vao);
+		_vbo = std::move(other._vbo);
+		other._isInitialized = false;
+	}
+
+	return *this;
+}
+
 void StaticMesh3D::deleteMesh()
 {
 	if (!_isInitialized) {
 		return;
 	}
 
-	glDeleteVertexArrays(1, &_vao);
+	_vao.reset();
 	_vbo.deleteVBO();
 
 	_isInitialized = false;
@@ -61,32 +98,117 @@ int StaticMesh3D::getVertexByteSize() const
 	return result;
 }
 
-void StaticMesh3D::setVertexAttributesPointers(int numVertices)
+VertexLayout StaticMesh3D::getVertexLayout() const
 {
-	uint64_t offset = 0;
-	if (hasPositions())
-	{
-		glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+	return _vertexLayout;
+}
 
-		offset += sizeof(glm::vec3)*numVertices;
+VertexAttributeLocation StaticMesh3D::getAttributeLocation(int attributeIndex, int numVertices) const
+{
+	// Attributes in the order they are stored, with their sizes (zero if the mesh does not have them)
+	const size_t sizes[3] = {
+		hasPositions() ? sizeof(glm::vec3) : 0,
+		hasTextureCoordinates() ? sizeof(glm::vec2) : 0,
+		hasNormals() ? sizeof(glm::vec3) : 0
+	};
+	const int attributes[3] = { POSITION_ATTRIBUTE_INDEX, TEXTURE_COORDINATE_ATTRIBUTE_INDEX, NORMAL_ATTRIBUTE_INDEX };
+
+	VertexAttributeLocation result;
+	for (int i = 0; i < 3; i++)
+	{
+		if (attributes[i] != attributeIndex) {
+			continue;
+		}
+		if (sizes[i] == 0) {
+			return result;
+		}
+
+		switch (_vertexLayout)
+		{
+		case VertexLayout::Planar:
+			// Preceding attributes take whole blocks
+			for (int j = 0; j < i; j++) {
+				result.offset += sizes[j] * numVertices;
+			}
+			result.stride = static_cast<GLsizei>(sizes[i]);
+			break;
+
+		case VertexLayout::Interleaved:
+			for (int j = 0; j < i; j++) {
+				result.offset += sizes[j];
+			}
+			result.stride = getVertexByteSize();
+			break;
+
+		case VertexLayout::PositionSplit:
+			if (i == 0)
+			{
+				result.stride = static_cast<GLsizei>(sizes[0]);
+				break;
+			}
+
+			// Second stream starts after all positions and interleaves the rest
+			result.offset = sizes[0] * numVertices;
+			for (int j = 1; j < i; j++) {
+				result.offset += sizes[j];
+			}
+			result.stride = static_cast<GLsizei>(sizes[1] + sizes[2]);
+			break;
+		}
 	}
 
-	if (hasTextureCoordinates())
+	return result;
+}
+
+void StaticMesh3D::setVertexAttributesPointers(int numVertices)
+{
+	const int attributes[3] = { POSITION_ATTRIBUTE_INDEX, TEXTURE_COORDINATE_ATTRIBUTE_INDEX, NORMAL_ATTRIBUTE_INDEX };
+	const GLint components[3] = { 3, 2, 3 };
+	for (int i = 0; i < 3; i++)
 	{
-		glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(offset));
+		const auto location = getAttributeLocation(attributes[i], numVertices);
+		if (location.stride == 0) {
+			continue;
+		}
 
-		offset += sizeof(glm::vec2)*numVertices;
+		glEnableVertexAttribArray(attributes[i]);
+		glVertexAttribPointer(attributes[i], components[i], GL_FLOAT, GL_FALSE, location.stride, reinterpret_cast<void*>(location.offset));
 	}
+}
 
-	if (hasNormals())
-	{
-		glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+VertexWriter::VertexWriter(const StaticMesh3D& mesh, int numVertices, VertexBufferObject& vbo)
+	: _data(vbo.appendRawData(static_cast<uint32_t>(mesh.getVertexByteSize() * numVertices)))
+	, _position(mesh.getAttributeLocation(StaticMesh3D::POSITION_ATTRIBUTE_INDEX, numVertices))
+	, _textureCoordinate(mesh.getAttributeLocation(StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX, numVertices))
+	, _normal(mesh.getAttributeLocation(StaticMesh3D::NORMAL_ATTRIBUTE_INDEX, numVertices))
+{
+	if (_data == nullptr) {
+		std::cout << "Could not stage " << numVertices << " vertices! Vertex data written to this writer are lost!" << std::endl;
+	}
+}
+
+void VertexWriter::setPosition(int vertex, const glm::vec3& position)
+{
+	write(_position, vertex, &position, sizeof(glm::vec3));
+}
 
-		offset += sizeof(glm::vec3)*numVertices;
+void VertexWriter::setTextureCoordinate(int vertex, const glm::vec2& textureCoordinate)
+{
+	write(_textureCoordinate, vertex, &textureCoordinate, sizeof(glm::vec2));
+}
+
+void VertexWriter::setNormal(int vertex, const glm::vec3& normal)
+{
+	write(_normal, vertex, &normal, sizeof(glm::vec3));
+}
+
+void VertexWriter::write(const VertexAttributeLocation& location, int vertex, const void* value, size_t size)
+{
+	if (location.stride == 0 || _data == nullptr) {
+		return;
 	}
+
+	memcpy(_data + location.offset + static_cast<size_t>(location.stride) * vertex, value, size);
 }
 
 } // namespace static_meshes_3D
\ No newline at end of file
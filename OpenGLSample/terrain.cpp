@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+#include <glm/gtc/noise.hpp>
+
+#include "terrain.h"
+#include "ShapeGenerator.h"
+#include "glState.h"
+#include "stb_image.h"
+
+namespace {
+
+// Stitch variants per LOD level, one per combination of the 4 chunk edges
+const int NUM_STITCH_MASKS = 16;
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// height field
+///////////////////////////////////////////////////////////////////////////////
+TerrainHeightField TerrainHeightField::fromNoise(Source source, float amplitude, float wavelength, int octaves)
+{
+	TerrainHeightField result;
+	result._source = source == SIMPLEX ? SIMPLEX : PERLIN;
+	result._amplitude = amplitude;
+	result._frequency = wavelength > 0.0f ? 1.0f / wavelength : 1.0f;
+	result._octaves = std::max(octaves, 1);
+	return result;
+}
+
+TerrainHeightField TerrainHeightField::fromImage(const char* path, float worldSize, float heightScale)
+{
+	TerrainHeightField result;
+	result._source = IMAGE;
+	result._worldSize = worldSize > 0.0f ? worldSize : 1.0f;
+
+	int width, height, components;
+	unsigned char* data = stbi_load(path, &width, &height, &components, 1);
+	if (!data)
+	{
+		std::cout << "ERROR::TERRAIN::HEIGHTMAP_FAILED_TO_LOAD " << path << std::endl;
+		return result;
+	}
+
+	result._imageWidth = width;
+	result._imageHeight = height;
+	result._image.resize(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < result._image.size(); i++) {
+		result._image[i] = data[i] / 255.0f * heightScale;
+	}
+	stbi_image_free(data);
+	return result;
+}
+
+float TerrainHeightField::getHeight(float x, float z) const
+{
+	if (_source == IMAGE)
+	{
+		if (_image.empty()) {
+			return 0.0f;
+		}
+
+		// bilinear filter, clamped to the border texels
+		const float u = glm::clamp((x / _worldSize + 0.5f) * (_imageWidth - 1), 0.0f, float(_imageWidth - 1));
+		const float v = glm::clamp((z / _worldSize + 0.5f) * (_imageHeight - 1), 0.0f, float(_imageHeight - 1));
+		const int x0 = static_cast<int>(u), z0 = static_cast<int>(v);
+		const int x1 = std::min(x0 + 1, _imageWidth - 1), z1 = std::min(z0 + 1, _imageHeight - 1);
+		const float fx = u - x0, fz = v - z0;
+		const float top = glm::mix(_image[z0 * _imageWidth + x0], _image[z0 * _imageWidth + x1], fx);
+		const float bottom = glm::mix(_image[z1 * _imageWidth + x0], _image[z1 * _imageWidth + x1], fx);
+		return glm::mix(top, bottom, fz);
+	}
+
+	float result = 0.0f;
+	float amplitude = _amplitude;
+	glm::vec2 position = glm::vec2(x, z) * _frequency;
+	for (int octave = 0; octave < _octaves; octave++)
+	{
+		result += amplitude * (_source == SIMPLEX ? glm::simplex(position) : glm::perlin(position));
+		amplitude *= 0.5f;
+		position *= 2.0f;
+	}
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// terrain
+///////////////////////////////////////////////////////////////////////////////
+Terrain::Terrain(const TerrainHeightField& heightField, const TerrainSettings& settings)
+	: _heightField(heightField)
+	, _settings(settings)
+{
+	// power of two cells, with at most 65536 vertices per chunk for 16 bit indices
+	int cells = 4;
+	while (cells < _settings.chunkCells && cells < 128) {
+		cells *= 2;
+	}
+	_settings.chunkCells = cells;
+
+	// the coarsest LOD still needs 2x2 cell blocks
+	int maxLods = 0;
+	while ((2 << maxLods) <= cells) {
+		maxLods++;
+	}
+	_settings.numLods = glm::clamp(_settings.numLods, 1, maxLods);
+	_settings.flatBlend = std::max(_settings.flatBlend, 0.001f);
+	_settings.maxUploadsPerFrame = std::max(_settings.maxUploadsPerFrame, 1);
+	_chunkSize = cells * _settings.cellSize;
+
+	int numWorkers = _settings.numWorkers;
+	if (numWorkers <= 0) {
+		numWorkers = glm::clamp(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1, 4);
+	}
+	for (int i = 0; i < numWorkers; i++) {
+		_workers.emplace_back(&Terrain::workerLoop, this);
+	}
+}
+
+Terrain::~Terrain()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+}
+
+std::int64_t Terrain::key(int x, int z)
+{
+	return (static_cast<std::int64_t>(x) << 32) | static_cast<std::uint32_t>(z);
+}
+
+float Terrain::getHeight(float x, float z) const
+{
+	const float distance = glm::length(glm::vec2(x, z) - _settings.flatCenter);
+	const float weight = glm::smoothstep(_settings.flatRadius, _settings.flatRadius + _settings.flatBlend, distance);
+	return _settings.baseHeight + weight * _heightField.getHeight(x, z);
+}
+
+float Terrain::getChunkDistance(int x, int z, const glm::vec3& position) const
+{
+	const float minX = x * _chunkSize, minZ = z * _chunkSize;
+	const float dx = std::max(std::max(minX - position.x, position.x - (minX + _chunkSize)), 0.0f);
+	const float dz = std::max(std::max(minZ - position.z, position.z - (minZ + _chunkSize)), 0.0f);
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+const Terrain::Chunk* Terrain::findChunk(int x, int z) const
+{
+	auto it = _chunks.find(key(x, z));
+	return it != _chunks.end() ? &it->second : nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// streaming
+///////////////////////////////////////////////////////////////////////////////
+void Terrain::update(const glm::vec3& cameraPosition)
+{
+	if (!_indexBuffer) {
+		createIndexBuffer();
+	}
+
+	// drop chunks that got far away, with some hysteresis so chunks on the border do not flip every frame
+	const float dropDistance = _settings.viewDistance + _chunkSize;
+	for (auto it = _chunks.begin(); it != _chunks.end();)
+	{
+		const int x = static_cast<int>(it->first >> 32);
+		const int z = static_cast<int>(static_cast<std::int32_t>(it->first & 0xFFFFFFFF));
+		if (getChunkDistance(x, z, cameraPosition) > dropDistance)
+		{
+			_freeChunks.push_back(std::move(it->second));
+			it = _chunks.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	// missing chunks in view distance
+	const int cameraX = static_cast<int>(std::floor(cameraPosition.x / _chunkSize));
+	const int cameraZ = static_cast<int>(std::floor(cameraPosition.z / _chunkSize));
+	const int radius = static_cast<int>(std::ceil(_settings.viewDistance / _chunkSize));
+	std::vector<glm::ivec2> missing;
+	for (int z = cameraZ - radius; z <= cameraZ + radius; z++)
+	{
+		for (int x = cameraX - radius; x <= cameraX + radius; x++)
+		{
+			const auto chunkKey = key(x, z);
+			if (getChunkDistance(x, z, cameraPosition) <= _settings.viewDistance && !_chunks.count(chunkKey) && !_pending.count(chunkKey))
+			{
+				missing.push_back(glm::ivec2(x, z));
+				_pending.insert(chunkKey);
+			}
+		}
+	}
+
+	std::vector<ChunkData> finished;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// forget requests that are not needed anymore, build the nearest ones first
+		for (auto it = _requests.begin(); it != _requests.end();)
+		{
+			if (getChunkDistance(it->x, it->y, cameraPosition) > dropDistance)
+			{
+				_pending.erase(key(it->x, it->y));
+				it = _requests.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		_requests.insert(_requests.end(), missing.begin(), missing.end());
+		std::sort(_requests.begin(), _requests.end(), [this, &cameraPosition](const glm::ivec2& a, const glm::ivec2& b) {
+			return getChunkDistance(a.x, a.y, cameraPosition) < getChunkDistance(b.x, b.y, cameraPosition);
+		});
+
+		// uploads are limited per frame, the rest waits for the next update
+		if (!_synchronousStreaming)
+		{
+			const size_t count = std::min(_built.size(), static_cast<size_t>(_settings.maxUploadsPerFrame));
+			std::move(_built.begin(), _built.begin() + count, std::back_inserter(finished));
+			_built.erase(_built.begin(), _built.begin() + count);
+		}
+	}
+	if (!missing.empty()) {
+		_condition.notify_all();
+	}
+
+	if (_synchronousStreaming)
+	{
+		// every pending chunk is queued, being built or built; wait for all of them and upload them in a fixed order,
+		// so that the chunk table (and with it the draw order) does not depend on which worker finished first
+		std::unique_lock<std::mutex> lock(_mutex);
+		_builtCondition.wait(lock, [this]() { return _requests.empty() && _built.size() == _pending.size(); });
+		finished.swap(_built);
+		lock.unlock();
+
+		std::sort(finished.begin(), finished.end(), [](const ChunkData& a, const ChunkData& b) {
+			return a.coord.y < b.coord.y || (a.coord.y == b.coord.y && a.coord.x < b.coord.x);
+		});
+	}
+
+	for (auto& data : finished)
+	{
+		_pending.erase(key(data.coord.x, data.coord.y));
+		if (getChunkDistance(data.coord.x, data.coord.y, cameraPosition) <= dropDistance) {
+			uploadChunk(data);
+		}
+	}
+}
+
+void Terrain::workerLoop()
+{
+	for (;;)
+	{
+		ChunkData data;
+		unsigned int generation;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_requests.empty(); });
+			if (_stopping) {
+				return;
+			}
+			data.coord = _requests.front();
+			_requests.pop_front();
+			generation = _generation;
+		}
+
+		buildChunk(data);
+
+		// a chunk requested before releaseBuffers is not pending anymore
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (generation == _generation) {
+			_built.push_back(std::move(data));
+			_builtCondition.notify_all();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// generate the vertices of one chunk (worker thread)
+// heights are sampled with a one vertex border, so normals on chunk edges
+// match the neighbour chunk
+///////////////////////////////////////////////////////////////////////////////
+void Terrain::buildChunk(ChunkData& chunk) const
+{
+	const int cells = _settings.chunkCells;
+	const int rowSize = cells + 1;
+	const int borderRowSize = cells + 3;
+	const float originX = chunk.coord.x * _chunkSize;
+	const float originZ = chunk.coord.y * _chunkSize;
+	const float cellSize = _settings.cellSize;
+
+	std::vector<float> heights(static_cast<size_t>(borderRowSize) * borderRowSize);
+	for (int z = 0; z < borderRowSize; z++)
+	{
+		for (int x = 0; x < borderRowSize; x++) {
+			heights[z * borderRowSize + x] = getHeight(originX + (x - 1) * cellSize, originZ + (z - 1) * cellSize);
+		}
+	}
+
+	chunk.vertices.resize(static_cast<size_t>(rowSize) * rowSize);
+	chunk.minHeight = heights[borderRowSize + 1];
+	chunk.maxHeight = chunk.minHeight;
+	for (int z = 0; z < rowSize; z++)
+	{
+		for (int x = 0; x < rowSize; x++)
+		{
+			const int center = (z + 1) * borderRowSize + x + 1;
+			const float height = heights[center];
+			TerrainVertex& vertex = chunk.vertices[z * rowSize + x];
+			vertex.position = glm::vec3(originX + x * cellSize, height, originZ + z * cellSize);
+			vertex.normal = glm::normalize(glm::vec3(heights[center - 1] - heights[center + 1], 2.0f * cellSize,
+			                                         heights[center - borderRowSize] - heights[center + borderRowSize]));
+			vertex.texCoords = glm::vec2(vertex.position.x, vertex.position.z) / _settings.textureTileSize;
+			chunk.minHeight = std::min(chunk.minHeight, height);
+			chunk.maxHeight = std::max(chunk.maxHeight, height);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU
+///////////////////////////////////////////////////////////////////////////////
+void Terrain::createIndexBuffer()
+{
+	std::vector<GLushort> indices;
+	_indexRanges.clear();
+	for (int lod = 0; lod < _settings.numLods; lod++)
+	{
+		for (int mask = 0; mask < NUM_STITCH_MASKS; mask++)
+		{
+			const std::vector<GLushort> variant = ShapeGenerator::makeGridIndices(_settings.chunkCells, 1 << lod, mask);
+			_indexRanges.push_back({ indices.size() * sizeof(GLushort), static_cast<GLsizei>(variant.size()) });
+			indices.insert(indices.end(), variant.begin(), variant.end());
+		}
+	}
+
+	// upload through the copy target, so the bound VAO does not pick the buffer up
+	_indexBuffer = GLBuffer::create();
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, _indexBuffer.get());
+	glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+}
+
+void Terrain::uploadChunk(ChunkData& data)
+{
+	const GLsizeiptr size = data.vertices.size() * sizeof(TerrainVertex);
+
+	Chunk chunk;
+	if (!_freeChunks.empty())
+	{
+		// every chunk has the same vertex count, so the buffer of a dropped chunk is overwritten in place
+		chunk = std::move(_freeChunks.back());
+		_freeChunks.pop_back();
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, chunk.vbo.get());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, data.vertices.data());
+	}
+	else
+	{
+		chunk.vao = GLVertexArray::create();
+		chunk.vbo = GLBuffer::create();
+		GLState::bindVertexArray(chunk.vao.get());
+		GLState::bindBuffer(GL_ARRAY_BUFFER, chunk.vbo.get());
+		glBufferData(GL_ARRAY_BUFFER, size, data.vertices.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, texCoords));
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer.get());
+	}
+
+	chunk.minHeight = data.minHeight;
+	chunk.maxHeight = data.maxHeight;
+	_chunks[key(data.coord.x, data.coord.y)] = std::move(chunk);
+}
+
+void Terrain::render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+	_drawnChunks = 0;
+	_drawnTriangles = 0;
+	if (_chunks.empty()) {
+		return;
+	}
+
+	// LOD from the distance to the chunk box, each level covers twice the distance of the previous one
+	for (auto& entry : _chunks)
+	{
+		Chunk& chunk = entry.second;
+		const int x = static_cast<int>(entry.first >> 32);
+		const int z = static_cast<int>(static_cast<std::int32_t>(entry.first & 0xFFFFFFFF));
+		const float dxz = getChunkDistance(x, z, cameraPosition);
+		const float dy = std::max(std::max(chunk.minHeight - cameraPosition.y, cameraPosition.y - chunk.maxHeight), 0.0f);
+		const float distance = std::sqrt(dxz * dxz + dy * dy);
+		chunk.lod = distance < _settings.lodDistance ? 0 :
+			std::min(_settings.numLods - 1, 1 + static_cast<int>(std::log2(distance / _settings.lodDistance)));
+	}
+
+	// neighbours may differ by one level at most, that is what the stitch variants handle
+	const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (auto& entry : _chunks)
+		{
+			const int x = static_cast<int>(entry.first >> 32);
+			const int z = static_cast<int>(static_cast<std::int32_t>(entry.first & 0xFFFFFFFF));
+			for (const auto& offset : offsets)
+			{
+				const Chunk* neighbour = findChunk(x + offset[0], z + offset[1]);
+				if (neighbour && entry.second.lod > neighbour->lod + 1)
+				{
+					entry.second.lod = neighbour->lod + 1;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// frustum planes (Gribb / Hartmann), a box is outside if it is behind any of them
+	glm::vec4 planes[6];
+	const glm::mat4 m = glm::transpose(viewProjection);
+	planes[0] = m[3] + m[0];
+	planes[1] = m[3] - m[0];
+	planes[2] = m[3] + m[1];
+	planes[3] = m[3] - m[1];
+	planes[4] = m[3] + m[2];
+	planes[5] = m[3] - m[2];
+
+	const GLuint stitchEdges[4] = { GRID_EDGE_MIN_X, GRID_EDGE_MAX_X, GRID_EDGE_MIN_Z, GRID_EDGE_MAX_Z };
+	for (const auto& entry : _chunks)
+	{
+		const Chunk& chunk = entry.second;
+		const int x = static_cast<int>(entry.first >> 32);
+		const int z = static_cast<int>(static_cast<std::int32_t>(entry.first & 0xFFFFFFFF));
+
+		const glm::vec3 boxMin(x * _chunkSize, chunk.minHeight, z * _chunkSize);
+		const glm::vec3 boxMax(boxMin.x + _chunkSize, chunk.maxHeight, boxMin.z + _chunkSize);
+		bool visible = true;
+		for (int i = 0; i < 6 && visible; i++)
+		{
+			const glm::vec3 farthest(planes[i].x > 0.0f ? boxMax.x : boxMin.x,
+			                         planes[i].y > 0.0f ? boxMax.y : boxMin.y,
+			                         planes[i].z > 0.0f ? boxMax.z : boxMin.z);
+			visible = glm::dot(glm::vec3(planes[i]), farthest) + planes[i].w >= 0.0f;
+		}
+		if (!visible) {
+			continue;
+		}
+
+		GLuint stitchMask = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			const Chunk* neighbour = findChunk(x + offsets[i][0], z + offsets[i][1]);
+			if (neighbour && neighbour->lod > chunk.lod) {
+				stitchMask |= stitchEdges[i];
+			}
+		}
+
+		const IndexRange& range = _indexRanges[chunk.lod * NUM_STITCH_MASKS + stitchMask];
+		GLState::bindVertexArray(chunk.vao.get());
+		glDrawElements(GL_TRIANGLES, range.count, GL_UNSIGNED_SHORT, (void*)range.offset);
+		_drawnChunks++;
+		_drawnTriangles += range.count / 3;
+	}
+}
+
+void Terrain::releaseBuffers()
+{
+	_chunks.clear();
+	_freeChunks.clear();
+	_indexBuffer.reset();
+
+	// chunks still queued, being built or built would be uploaded against the deleted index buffer;
+	// they are forgotten together, synchronous streaming waits for _built to catch up with _pending
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pending.clear();
+	_requests.clear();
+	_built.clear();
+	_generation++;
+}
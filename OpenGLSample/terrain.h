@@ -0,0 +1,201 @@
+#pragma once
+
+// STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "glHandle.h"
+
+/**
+ * Height of the ground at a world XZ position, from fBm noise or a heightmap image.
+ * Read-only after construction, so terrain workers sample it concurrently.
+ */
+class TerrainHeightField
+{
+public:
+    enum Source
+    {
+        PERLIN = 0,
+        SIMPLEX,
+        IMAGE
+    };
+
+    /**
+     * Sum of noise octaves (fBm), each one with half the amplitude and twice the frequency of the previous.
+     *
+     * @param source      PERLIN (glm::perlin) or SIMPLEX (glm::simplex)
+     * @param amplitude   Height of the first octave
+     * @param wavelength  Horizontal size of the first octave features
+     * @param octaves     Number of octaves
+     */
+    static TerrainHeightField fromNoise(Source source, float amplitude, float wavelength, int octaves = 5);
+
+    /**
+     * Grayscale image stretched over a square centered at the origin, black is height 0 and white heightScale.
+     * Positions outside the square repeat the border texels. An image that fails to load gives a flat field.
+     */
+    static TerrainHeightField fromImage(const char* path, float worldSize, float heightScale);
+
+    /**
+     * Gets height at world position.
+     */
+    float getHeight(float x, float z) const;
+
+private:
+    Source _source = PERLIN;
+    float _amplitude = 0.0f;
+    float _frequency = 1.0f;
+    int _octaves = 1;
+
+    std::vector<float> _image; // heights of the image texels, already scaled
+    int _imageWidth = 0;
+    int _imageHeight = 0;
+    float _worldSize = 1.0f;
+};
+
+/**
+ * Terrain settings, sizes are in world units.
+ */
+struct TerrainSettings
+{
+    int chunkCells = 64;                // grid cells along a chunk side, power of two (vertices must fit 16 bit indices)
+    float cellSize = 2.0f;              // distance between two grid vertices
+    int numLods = 5;                    // LOD levels, level L uses every 2^L-th vertex
+    float lodDistance = 160.0f;         // LOD 0 is used up to this distance, each next level covers twice the range
+    float viewDistance = 1000.0f;       // chunks closer than this are streamed in
+    float textureTileSize = 20.0f;      // world size of one texture repeat
+    float baseHeight = 0.0f;            // height added to the height field
+    glm::vec2 flatCenter = glm::vec2(0.0f); // ground is kept at baseHeight around this point...
+    float flatRadius = 0.0f;            // ...up to this distance...
+    float flatBlend = 1.0f;             // ...and blends to the full height field over this distance
+    int numWorkers = 0;                 // chunk building threads, 0 picks from hardware concurrency
+    int maxUploadsPerFrame = 4;         // built chunks uploaded to the GPU per update()
+};
+
+/**
+ * Streamed heightfield terrain made of square chunks. Chunks around the camera are built on worker threads and
+ * uploaded on the GL thread; all chunks share one index buffer holding every LOD level, with variants that stitch
+ * edges to a coarser neighbour. Vertices are position / normal / tex coords at attributes 0 / 1 / 2, in world space.
+ */
+class Terrain
+{
+public:
+    Terrain(const TerrainHeightField& heightField, const TerrainSettings& settings = TerrainSettings());
+    ~Terrain();                         // stops the workers, GL objects must be released before with releaseBuffers()
+
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    /**
+     * Requests chunks in view distance, uploads finished ones and drops chunks that got far away. Call once per frame.
+     */
+    void update(const glm::vec3& cameraPosition);
+
+    /**
+     * In synchronous mode update() waits for every chunk it requested and uploads them all, ignoring
+     * maxUploadsPerFrame, so that what is drawn does not depend on how fast the workers were. For replays.
+     */
+    void setSynchronousStreaming(bool synchronous) { _synchronousStreaming = synchronous; }
+
+    /**
+     * Draws visible chunks with the bound program, which must use an identity model matrix.
+     *
+     * @param viewProjection  Projection * view, used for frustum culling
+     * @param cameraPosition  Camera position, used to select LODs
+     */
+    void render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+    /**
+     * Deletes all GL objects. Needs the GL context, so call it before the context is destroyed.
+     */
+    void releaseBuffers();
+
+    /**
+     * Gets terrain height at world position (ground height of the settings, not of the rendered LOD).
+     */
+    float getHeight(float x, float z) const;
+
+    int getLoadedChunkCount() const     { return static_cast<int>(_chunks.size()); }
+    int getDrawnChunkCount() const      { return _drawnChunks; }
+    unsigned int getDrawnTriangleCount() const { return _drawnTriangles; }
+
+private:
+    struct TerrainVertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoords;
+    };
+
+    // chunk built by a worker, waiting for upload
+    struct ChunkData
+    {
+        glm::ivec2 coord;
+        std::vector<TerrainVertex> vertices;
+        float minHeight;
+        float maxHeight;
+    };
+
+    // chunk on the GPU
+    struct Chunk
+    {
+        GLVertexArray vao;
+        GLBuffer vbo;
+        float minHeight = 0.0f;
+        float maxHeight = 0.0f;
+        int lod = 0;
+    };
+
+    // where an index buffer variant starts and how many indices it has
+    struct IndexRange
+    {
+        size_t offset;
+        GLsizei count;
+    };
+
+    static std::int64_t key(int x, int z);
+
+    void workerLoop();
+    void buildChunk(ChunkData& chunk) const;
+    void uploadChunk(ChunkData& data);
+    void createIndexBuffer();
+    float getChunkDistance(int x, int z, const glm::vec3& position) const;
+    const Chunk* findChunk(int x, int z) const;
+
+    TerrainHeightField _heightField;
+    TerrainSettings _settings;
+    float _chunkSize;
+
+    std::unordered_map<std::int64_t, Chunk> _chunks;  // chunks on the GPU
+    std::vector<Chunk> _freeChunks;                   // GL objects of dropped chunks, reused for new ones
+    std::unordered_set<std::int64_t> _pending;        // requested chunks that are not uploaded yet
+    GLBuffer _indexBuffer;
+    std::vector<IndexRange> _indexRanges;             // [lod * 16 + stitch mask]
+
+    // worker queue
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::condition_variable _builtCondition;          // signalled when a worker finished a chunk
+    std::deque<glm::ivec2> _requests;
+    std::vector<ChunkData> _built;
+    unsigned int _generation = 0;                     // bumped by releaseBuffers, older builds are dropped
+    bool _stopping = false;
+    bool _synchronousStreaming = false;
+
+    int _drawnChunks = 0;
+    unsigned int _drawnTriangles = 0;
+};
@@ -2,76 +2,25 @@
 #include <map>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 #include "vboindexer.hpp"
 
 #include <string.h> // for memcmp
+#include <stdio.h>
+#include <stdint.h>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <climits>
 
 
+// Tolerance of the TBN indexer
+const float WELD_EPSILON = 0.01f;
+
 // Returns true iif v1 can be considered equal to v2
 bool is_near(float v1, float v2){
-	return fabs( v1-v2 ) < 0.01f;
-}
-
-// Searches through all already-exported vertices
-// for a similar one.
-// Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
-	glm::vec3 & in_vertex, 
-	glm::vec2 & in_uv, 
-	glm::vec3 & in_normal, 
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	unsigned short & result
-){
-	// Lame linear search
-	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
-		if (
-			is_near( in_vertex.x , out_vertices[i].x ) &&
-			is_near( in_vertex.y , out_vertices[i].y ) &&
-			is_near( in_vertex.z , out_vertices[i].z ) &&
-			is_near( in_uv.x     , out_uvs     [i].x ) &&
-			is_near( in_uv.y     , out_uvs     [i].y ) &&
-			is_near( in_normal.x , out_normals [i].x ) &&
-			is_near( in_normal.y , out_normals [i].y ) &&
-			is_near( in_normal.z , out_normals [i].z )
-		){
-			result = i;
-			return true;
-		}
-	}
-	// No other vertex could be used instead.
-	// Looks like we'll have to add it to the VBO.
-	return false;
-}
-
-void indexVBO_slow(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
-
-	std::vector<unsigned short> & out_indices,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
-		}
-	}
+	return fabs( v1-v2 ) < WELD_EPSILON;
 }
 
 struct PackedVertex{
@@ -97,7 +46,7 @@ bool getSimilarVertexIndex_fast(
 	}
 }
 
-void indexVBO(
+void indexVBO_map(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -132,11 +81,472 @@ void indexVBO(
 	}
 }
 
+// Hash welding : open addressing over the packed vertices, with the same (bitwise) equality as the map above.
+// The parallel mode splits the vertices by hash into one partition per thread, so partitions never share a vertex
+// and are welded without locks. Output vertices keep the order of their first corner whatever the thread count.
+
+namespace {
+
+	const unsigned int NO_CORNER = 0xFFFFFFFFu;
+
+	uint64_t hashPackedVertex(const PackedVertex & packed){
+		uint64_t words[4];
+		static_assert(sizeof(PackedVertex) == sizeof(words), "PackedVertex must not have padding");
+		memcpy(words, &packed, sizeof(words));
+
+		uint64_t hash = 0x9E3779B97F4A7C15ull;
+		for (int i = 0; i < 4; i++){
+			hash ^= words[i] * 0xBF58476D1CE4E5B9ull;
+			hash = ((hash << 27) | (hash >> 37)) * 0x94D049BB133111EBull;
+		}
+		// final avalanche (MurmurHash3 fmix64), so that low and high bits are both usable
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// Runs function(range) for range = 0..numRanges-1 on as many threads, range 0 on the calling one
+	template <typename Function>
+	void forEachRange(unsigned int numRanges, Function function){
+		std::vector<std::thread> threads;
+		threads.reserve(numRanges - 1);
+		for (unsigned int i = 1; i < numRanges; i++)
+			threads.emplace_back(function, i);
+		function(0u);
+		for (std::thread & thread : threads)
+			thread.join();
+	}
+
+	size_t rangeBegin(size_t count, unsigned int range, unsigned int numRanges){
+		return count * range / numRanges;
+	}
+
+	// Fills firstCorner[i] with the first corner equal to corner i, for the corners of one hash partition
+	void weldPartition(
+		const std::vector<PackedVertex> & packed,
+		const std::vector<uint64_t> & hashes,
+		unsigned int partition,
+		unsigned int numPartitions,
+		std::vector<unsigned int> & firstCorner
+	){
+		// partition = high hash bits, table slot = low hash bits
+		auto partitionOf = [numPartitions](uint64_t hash){
+			return (unsigned int)(((hash >> 32) * numPartitions) >> 32);
+		};
+
+		size_t count = 0;
+		for (size_t i = 0; i < hashes.size(); i++){
+			if (partitionOf(hashes[i]) == partition)
+				count++;
+		}
+		// at most 2/3 full, even when no corner welds
+		size_t tableSize = 2;
+		while (tableSize < count + count / 2)
+			tableSize *= 2;
+		const size_t mask = tableSize - 1;
+		std::vector<unsigned int> table(tableSize, NO_CORNER);
+
+		for (size_t i = 0; i < hashes.size(); i++){
+			const uint64_t hash = hashes[i];
+			if (partitionOf(hash) != partition)
+				continue;
+			for (size_t slot = hash & mask; ; slot = (slot + 1) & mask){
+				const unsigned int other = table[slot];
+				if (other == NO_CORNER){
+					table[slot] = (unsigned int)i;
+					firstCorner[i] = (unsigned int)i;
+					break;
+				}
+				if (hashes[other] == hash && memcmp(&packed[other], &packed[i], sizeof(PackedVertex)) == 0){
+					firstCorner[i] = other;
+					break;
+				}
+			}
+		}
+	}
+
+} // namespace
+
+void indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+
+	unsigned int numThreads
+){
+	const size_t numCorners = in_vertices.size();
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	// a thread per few thousand corners at most, below that threads cost more than they save
+	numThreads = (unsigned int)std::max<size_t>(1, std::min<size_t>(numThreads, numCorners / 4096));
+
+	std::vector<PackedVertex> packed(numCorners);
+	std::vector<uint64_t> hashes(numCorners);
+	forEachRange(numThreads, [&](unsigned int range){
+		const size_t end = rangeBegin(numCorners, range + 1, numThreads);
+		for (size_t i = rangeBegin(numCorners, range, numThreads); i < end; i++){
+			packed[i] = {in_vertices[i], in_uvs[i], in_normals[i]};
+			hashes[i] = hashPackedVertex(packed[i]);
+		}
+	});
+
+	std::vector<unsigned int> firstCorner(numCorners);
+	forEachRange(numThreads, [&](unsigned int partition){
+		weldPartition(packed, hashes, partition, numThreads, firstCorner);
+	});
 
+	// Number the first corners in input order : count per range, then each range numbers its own
+	std::vector<size_t> rangeFirst(numThreads + 1, 0);
+	forEachRange(numThreads, [&](unsigned int range){
+		const size_t end = rangeBegin(numCorners, range + 1, numThreads);
+		size_t count = 0;
+		for (size_t i = rangeBegin(numCorners, range, numThreads); i < end; i++){
+			if (firstCorner[i] == i)
+				count++;
+		}
+		rangeFirst[range + 1] = count;
+	});
+	for (unsigned int range = 0; range < numThreads; range++)
+		rangeFirst[range + 1] += rangeFirst[range];
+
+	const size_t firstOut = out_vertices.size(); // appends, like the map version
+	const size_t numVertices = rangeFirst[numThreads];
+	out_vertices.resize(firstOut + numVertices);
+	out_uvs.resize(firstOut + numVertices);
+	out_normals.resize(firstOut + numVertices);
+	std::vector<unsigned int> vertexOf(numCorners); // set for first corners only
+	forEachRange(numThreads, [&](unsigned int range){
+		const size_t end = rangeBegin(numCorners, range + 1, numThreads);
+		size_t vertex = firstOut + rangeFirst[range];
+		for (size_t i = rangeBegin(numCorners, range, numThreads); i < end; i++){
+			if (firstCorner[i] != i)
+				continue;
+			out_vertices[vertex] = in_vertices[i];
+			out_uvs[vertex] = in_uvs[i];
+			out_normals[vertex] = in_normals[i];
+			vertexOf[i] = (unsigned int)vertex++;
+		}
+	});
 
+	const size_t firstIndex = out_indices.size();
+	out_indices.resize(firstIndex + numCorners);
+	forEachRange(numThreads, [&](unsigned int range){
+		const size_t end = rangeBegin(numCorners, range + 1, numThreads);
+		for (size_t i = rangeBegin(numCorners, range, numThreads); i < end; i++){
+			out_indices[firstIndex + i] = vertexOf[firstCorner[i]];
+		}
+	});
+}
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	const size_t firstOut = out_vertices.size();
+	std::vector<unsigned int> indices;
+	indexVBO(in_vertices, in_uvs, in_normals, indices, out_vertices, out_uvs, out_normals);
+	if (out_vertices.size() > 0x10000){
+		printf("indexVBO : %u vertices do not fit 16 bit indices, use the 32 bit version\n", (unsigned int)out_vertices.size());
+		out_vertices.resize(firstOut);
+		out_uvs.resize(firstOut);
+		out_normals.resize(firstOut);
+		return false;
+	}
+	out_indices.insert(out_indices.end(), indices.begin(), indices.end());
+	return true;
+}
 
+unsigned int packIndexVBO(
+	const std::vector<unsigned int> & indices,
+	size_t vertexCount,
+	std::vector<unsigned char> & out_bytes
+){
+	// 1 byte indices are not native everywhere, so use at least 2
+	const unsigned int indexByteSize = vertexCount <= 0x10000 ? 2 : 4;
+	out_bytes = packIndices(indices, indexByteSize);
+	return getIndexType(indexByteSize);
+}
 
+MeshOptimizationReport optimizeIndexedVBO(
+	std::vector<unsigned int> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals
+){
+	std::vector<unsigned int> remap;
+	MeshOptimizationReport report = optimizeMesh(indices, (const float*)vertices.data(), sizeof(glm::vec3), (unsigned int)vertices.size(), remap);
 
+	remapVertices(vertices, remap);
+	remapVertices(uvs, remap);
+	remapVertices(normals, remap);
+	return report;
+}
+
+MeshOptimizationReport optimizeIndexedVBO(
+	std::vector<unsigned short> & indices,
+	std::vector<glm::vec3> & vertices,
+	std::vector<glm::vec2> & uvs,
+	std::vector<glm::vec3> & normals
+){
+	std::vector<unsigned int> indices32(indices.begin(), indices.end());
+	MeshOptimizationReport report = optimizeIndexedVBO(indices32, vertices, uvs, normals);
+	for ( unsigned int i=0; i<indices.size(); i++ ){
+		indices[i] = (unsigned short)indices32[i];
+	}
+	return report;
+}
+
+// Epsilon welding : a corner takes the first vertex emitted before it that is near in position, uv and normal
+// (is_near on every component), like the former linear search did, but candidates only come from a uniform grid.
+// Grid cells are a few epsilons wide, so only points close to a cell face need to look into the next cell.
+
+namespace {
+
+	const double WELD_CELL_SIZE = 4.0 * WELD_EPSILON;
+
+	struct WeldCell {
+		int x, y, z;
+		unsigned int id;            // NO_CORNER for an empty slot
+	};
+
+	// Grid of all corners, built on numThreads threads : cells are spread over hash partitions like in indexVBO and
+	// every partition lists the corners of each of its cells in increasing order. Read-only once built.
+	class WeldGrid
+	{
+	public:
+		WeldGrid(const std::vector<glm::vec3> & positions, unsigned int numThreads)
+			: _partitions(numThreads)
+		{
+			const size_t numCorners = positions.size();
+			std::vector<glm::ivec3> cells(numCorners);
+			std::vector<uint64_t> hashes(numCorners);
+			forEachRange(numThreads, [&](unsigned int range){
+				const size_t end = rangeBegin(numCorners, range + 1, numThreads);
+				for (size_t i = rangeBegin(numCorners, range, numThreads); i < end; i++){
+					cells[i] = cellOf(positions[i]);
+					hashes[i] = hashCell(cells[i]);
+				}
+			});
+			forEachRange(numThreads, [&](unsigned int partition){
+				buildPartition(cells, hashes, partition);
+			});
+		}
+
+		// far away positions share the border cells, which stays correct
+		static glm::ivec3 cellOf(const glm::vec3 & position){
+			const glm::dvec3 cell = glm::floor(glm::dvec3(position) / WELD_CELL_SIZE);
+			return glm::ivec3(glm::clamp(cell, glm::dvec3(INT_MIN), glm::dvec3(INT_MAX)));
+		}
+
+		// Corners in a cell, in increasing order
+		void getCorners(const glm::ivec3 & cell, const unsigned int *& begin, const unsigned int *& end) const {
+			const uint64_t hash = hashCell(cell);
+			const Partition & partition = _partitions[partitionOf(hash)];
+			const unsigned int id = partition.find(cell, hash);
+			if (id == NO_CORNER){
+				begin = end = NULL;
+				return;
+			}
+			begin = partition.corners.data() + partition.cellBegin[id];
+			end = partition.corners.data() + partition.cellBegin[id + 1];
+		}
+
+	private:
+		// Cells of one partition : an open addressing table gives the cell id, cellBegin[id] .. cellBegin[id + 1]
+		// the range of its corners
+		struct Partition {
+			std::vector<WeldCell> table;
+			size_t mask = 0;
+			unsigned int numCells = 0;
+			std::vector<unsigned int> cellBegin;
+			std::vector<unsigned int> corners;
+
+			unsigned int find(const glm::ivec3 & cell, uint64_t hash) const {
+				for (size_t slot = hash & mask; ; slot = (slot + 1) & mask){
+					const WeldCell & entry = table[slot];
+					if (entry.id == NO_CORNER || (entry.x == cell.x && entry.y == cell.y && entry.z == cell.z))
+						return entry.id;
+				}
+			}
+
+			unsigned int findOrAdd(const glm::ivec3 & cell, uint64_t hash){
+				// at most half full
+				if (2 * (numCells + 1) > table.size())
+					grow();
+				for (size_t slot = hash & mask; ; slot = (slot + 1) & mask){
+					WeldCell & entry = table[slot];
+					if (entry.id == NO_CORNER){
+						entry = WeldCell{ cell.x, cell.y, cell.z, numCells++ };
+						return entry.id;
+					}
+					if (entry.x == cell.x && entry.y == cell.y && entry.z == cell.z)
+						return entry.id;
+				}
+			}
+
+			void grow(){
+				std::vector<WeldCell> old(std::max<size_t>(16, table.size() * 2), WeldCell{ 0, 0, 0, NO_CORNER });
+				old.swap(table);
+				mask = table.size() - 1;
+				for (const WeldCell & entry : old){
+					if (entry.id == NO_CORNER)
+						continue;
+					size_t slot = hashCell(glm::ivec3(entry.x, entry.y, entry.z)) & mask;
+					while (table[slot].id != NO_CORNER)
+						slot = (slot + 1) & mask;
+					table[slot] = entry;
+				}
+			}
+		};
+
+		static uint64_t hashCell(const glm::ivec3 & cell){
+			uint64_t hash = (uint64_t)(uint32_t)cell.x * 0x9E3779B97F4A7C15ull;
+			hash = (hash ^ (uint32_t)cell.y) * 0xBF58476D1CE4E5B9ull;
+			hash = (hash ^ (uint32_t)cell.z) * 0x94D049BB133111EBull;
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		unsigned int partitionOf(uint64_t hash) const {
+			return (unsigned int)(((hash >> 32) * _partitions.size()) >> 32);
+		}
+
+		void buildPartition(const std::vector<glm::ivec3> & cells, const std::vector<uint64_t> & hashes, unsigned int index){
+			Partition & partition = _partitions[index];
+
+			// cell of each corner of the partition, then a counting sort of the corners by cell
+			std::vector<unsigned int> cornerCells;
+			std::vector<unsigned int> counts;
+			for (size_t i = 0; i < hashes.size(); i++){
+				if (partitionOf(hashes[i]) != index)
+					continue;
+				const unsigned int id = partition.findOrAdd(cells[i], hashes[i]);
+				if (id == counts.size())
+					counts.push_back(0);
+				counts[id]++;
+				cornerCells.push_back(id);
+			}
+			if (partition.table.empty())
+				partition.grow(); // so that find() always has a slot to look at
+
+			partition.cellBegin.resize(partition.numCells + 1);
+			partition.cellBegin[0] = 0;
+			for (unsigned int id = 0; id < partition.numCells; id++)
+				partition.cellBegin[id + 1] = partition.cellBegin[id] + counts[id];
+
+			partition.corners.resize(cornerCells.size());
+			std::vector<unsigned int> & next = counts;
+			std::copy(partition.cellBegin.begin(), partition.cellBegin.end() - 1, next.begin());
+			size_t k = 0;
+			for (size_t i = 0; i < hashes.size(); i++){
+				if (partitionOf(hashes[i]) == index)
+					partition.corners[next[cornerCells[k++]]++] = (unsigned int)i;
+			}
+		}
+
+		std::vector<Partition> _partitions;
+	};
+
+	bool isNearVertex(size_t a, size_t b, const std::vector<glm::vec3> & positions, const std::vector<glm::vec2> & uvs,
+		const std::vector<glm::vec3> & normals){
+		return is_near(positions[a].x, positions[b].x) && is_near(positions[a].y, positions[b].y) && is_near(positions[a].z, positions[b].z)
+			&& is_near(uvs[a].x, uvs[b].x) && is_near(uvs[a].y, uvs[b].y)
+			&& is_near(normals[a].x, normals[b].x) && is_near(normals[a].y, normals[b].y) && is_near(normals[a].z, normals[b].z);
+	}
+
+	// Gives each corner its vertex (vertexOf) and each vertex the corner it was emitted from (emitters).
+	// The grid is built in parallel; the matching pass is sequential, as whether a corner is emitted depends on
+	// the corners before it.
+	void weldNear(
+		const std::vector<glm::vec3> & positions,
+		const std::vector<glm::vec2> & uvs,
+		const std::vector<glm::vec3> & normals,
+		unsigned int numThreads,
+		std::vector<unsigned int> & vertexOf,
+		std::vector<unsigned int> & emitters
+	){
+		const size_t numCorners = positions.size();
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		numThreads = (unsigned int)std::max<size_t>(1, std::min<size_t>(numThreads, numCorners / 4096));
+
+		const WeldGrid grid(positions, numThreads);
+		vertexOf.assign(numCorners, NO_CORNER);
+		emitters.clear();
+		// slightly more than the epsilon, is_near compares rounded float differences
+		const double reach = WELD_EPSILON * 1.001;
+		for (size_t i = 0; i < numCorners; i++){
+			// own cell, plus the next one along each axis where the point is near a face
+			const glm::ivec3 cell = WeldGrid::cellOf(positions[i]);
+			const glm::dvec3 offset = glm::dvec3(positions[i]) - glm::dvec3(cell) * WELD_CELL_SIZE;
+			glm::ivec3 low, high;
+			for (int axis = 0; axis < 3; axis++){
+				low[axis] = offset[axis] < reach ? -1 : 0;
+				high[axis] = offset[axis] > WELD_CELL_SIZE - reach ? 1 : 0;
+			}
+
+			unsigned int vertex = NO_CORNER;
+			for (int z = low.z; z <= high.z; z++)
+			for (int y = low.y; y <= high.y; y++)
+			for (int x = low.x; x <= high.x; x++){
+				const unsigned int * corner;
+				const unsigned int * end;
+				grid.getCorners(cell + glm::ivec3(x, y, z), corner, end);
+				// vertices are emitted in corner order, so the first match of a cell is its best one
+				for (; corner != end && *corner < i; corner++){
+					const unsigned int candidate = vertexOf[*corner];
+					if (candidate < vertex && emitters[candidate] == *corner && isNearVertex(*corner, i, positions, uvs, normals)){
+						vertex = candidate;
+						break;
+					}
+				}
+			}
+			if (vertex == NO_CORNER){
+				vertex = (unsigned int)emitters.size();
+				emitters.push_back((unsigned int)i);
+			}
+			vertexOf[i] = vertex;
+		}
+	}
+
+} // namespace
+
+void indexVBO_slow(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+){
+	std::vector<unsigned int> vertexOf;
+	std::vector<unsigned int> emitters;
+	weldNear(in_vertices, in_uvs, in_normals, 1, vertexOf, emitters);
+
+	const size_t firstOut = out_vertices.size();
+	for (unsigned int corner : emitters){
+		out_vertices.push_back( in_vertices[corner]);
+		out_uvs     .push_back( in_uvs[corner]);
+		out_normals .push_back( in_normals[corner]);
+	}
+	for (unsigned int vertex : vertexOf)
+		out_indices.push_back( (unsigned short)(firstOut + vertex) );
+}
 
 void indexVBO_TBN(
 	std::vector<glm::vec3> & in_vertices,
@@ -145,6 +555,43 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & in_tangents,
 	std::vector<glm::vec3> & in_bitangents,
 
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+
+	unsigned int numThreads
+){
+	std::vector<unsigned int> vertexOf;
+	std::vector<unsigned int> emitters;
+	weldNear(in_vertices, in_uvs, in_normals, numThreads, vertexOf, emitters);
+
+	const size_t firstOut = out_vertices.size();
+	for (unsigned int corner : emitters){
+		out_vertices  .push_back( in_vertices[corner]);
+		out_uvs       .push_back( in_uvs[corner]);
+		out_normals   .push_back( in_normals[corner]);
+		out_tangents  .push_back( glm::vec3(0.0f));
+		out_bitangents.push_back( glm::vec3(0.0f));
+	}
+	// Average the tangents and the bitangents (summed in corner order, as before)
+	for (size_t i = 0; i < vertexOf.size(); i++){
+		const size_t vertex = firstOut + vertexOf[i];
+		out_tangents[vertex] += in_tangents[i];
+		out_bitangents[vertex] += in_bitangents[i];
+		out_indices.push_back( (unsigned int)vertex );
+	}
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
@@ -152,26 +599,65 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & out_tangents,
 	std::vector<glm::vec3> & out_bitangents
 ){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+	const size_t firstOut = out_vertices.size();
+	std::vector<unsigned int> indices;
+	indexVBO_TBN(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents,
+		indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+	if (out_vertices.size() > 0x10000){
+		printf("indexVBO_TBN : %u vertices do not fit 16 bit indices, use the 32 bit version\n", (unsigned int)out_vertices.size());
+		out_vertices.resize(firstOut);
+		out_uvs.resize(firstOut);
+		out_normals.resize(firstOut);
+		out_tangents.resize(firstOut);
+		out_bitangents.resize(firstOut);
+		return false;
+	}
+	out_indices.insert(out_indices.end(), indices.begin(), indices.end());
+	return true;
+}
 
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+void benchmarkIndexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	int numRuns
+){
+	typedef std::chrono::steady_clock Clock;
+	const unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+	printf("indexVBO benchmark : %u corners, best of %d runs\n", (unsigned int)in_vertices.size(), numRuns);
 
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
+	std::vector<unsigned short> mapIndices;
+	std::vector<glm::vec3> mapVertices;
+	std::vector<glm::vec2> mapUvs;
+	std::vector<glm::vec3> mapNormals;
+	double best = 1e30;
+	for (int run = 0; run < numRuns; run++){
+		mapIndices.clear(); mapVertices.clear(); mapUvs.clear(); mapNormals.clear();
+		const Clock::time_point start = Clock::now();
+		indexVBO_map(in_vertices, in_uvs, in_normals, mapIndices, mapVertices, mapUvs, mapNormals);
+		best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	printf("  std::map        %9.2f ms, %u vertices\n", best, (unsigned int)mapVertices.size());
 
-			// Average the tangents and the bitangents
-			out_tangents[index] += in_tangents[i];
-			out_bitangents[index] += in_bitangents[i];
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_tangents .push_back( in_tangents[i]);
-			out_bitangents .push_back( in_bitangents[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
+	for (unsigned int threads : { 1u, numThreads }){
+		std::vector<unsigned int> indices;
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		best = 1e30;
+		for (int run = 0; run < numRuns; run++){
+			indices.clear(); vertices.clear(); uvs.clear(); normals.clear();
+			const Clock::time_point start = Clock::now();
+			indexVBO(in_vertices, in_uvs, in_normals, indices, vertices, uvs, normals, threads);
+			best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
 		}
+
+		// same vertices in the same order; the map indices are only comparable while they did not overflow
+		bool same = vertices == mapVertices && uvs == mapUvs && normals == mapNormals;
+		if (vertices.size() <= 0x10000)
+			same = same && std::equal(indices.begin(), indices.end(), mapIndices.begin(), mapIndices.end());
+		printf("  hash, %2u thread %9.2f ms, %u vertices%s\n", threads, best, (unsigned int)vertices.size(), same ? "" : " MISMATCH");
+		if (numThreads == 1)
+			break;
 	}
 }
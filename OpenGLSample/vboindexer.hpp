@@ -2,18 +2,60 @@
 #ifndef VBOINDEXER_HPP
 #define VBOINDEXER_HPP
 
+#include "meshOptimizer.h"
+
+// Welds identical triangle corners into indexed vertices (hash table, bitwise equality).
+// numThreads > 1 welds hash partitions in parallel, 0 uses every hardware thread; the result does not depend on it.
+// Outputs are appended to.
 void indexVBO(
 	std::vector<glm::vec3>& in_vertices,
 	std::vector<glm::vec2>& in_uvs,
 	std::vector<glm::vec3>& in_normals,
 
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+
+	unsigned int numThreads = 1
+);
+
+// Same with 16 bit indices, returns false and outputs nothing if the mesh needs more than 65536 vertices
+bool indexVBO(
+	std::vector<glm::vec3>& in_vertices,
+	std::vector<glm::vec2>& in_uvs,
+	std::vector<glm::vec3>& in_normals,
+
+	std::vector<unsigned short>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals
+);
+
+// Former std::map based indexVBO, kept as benchmark reference. Indices wrap past 65536 vertices.
+void indexVBO_map(
+	std::vector<glm::vec3>& in_vertices,
+	std::vector<glm::vec2>& in_uvs,
+	std::vector<glm::vec3>& in_normals,
+
 	std::vector<unsigned short>& out_indices,
 	std::vector<glm::vec3>& out_vertices,
 	std::vector<glm::vec2>& out_uvs,
 	std::vector<glm::vec3>& out_normals
 );
 
+// Packs 32 bit indices for glBufferData : 16 bit when vertexCount allows it, 32 bit otherwise.
+// Returns the index type for glDrawElements (GL_UNSIGNED_SHORT / GL_UNSIGNED_INT).
+unsigned int packIndexVBO(
+	const std::vector<unsigned int>& indices,
+	size_t vertexCount,
+	std::vector<unsigned char>& out_bytes
+);
+
 
+// Welds triangle corners equal within a small epsilon (position, uv and normal), the tangents and bitangents of
+// welded corners are summed. Candidates come from a spatial grid, built on numThreads threads (0 : all of them).
+// Outputs are appended to.
 void indexVBO_TBN(
 	std::vector<glm::vec3>& in_vertices,
 	std::vector<glm::vec2>& in_uvs,
@@ -21,6 +63,24 @@ void indexVBO_TBN(
 	std::vector<glm::vec3>& in_tangents,
 	std::vector<glm::vec3>& in_bitangents,
 
+	std::vector<unsigned int>& out_indices,
+	std::vector<glm::vec3>& out_vertices,
+	std::vector<glm::vec2>& out_uvs,
+	std::vector<glm::vec3>& out_normals,
+	std::vector<glm::vec3>& out_tangents,
+	std::vector<glm::vec3>& out_bitangents,
+
+	unsigned int numThreads = 1
+);
+
+// Same with 16 bit indices, returns false and outputs nothing if the mesh needs more than 65536 vertices
+bool indexVBO_TBN(
+	std::vector<glm::vec3>& in_vertices,
+	std::vector<glm::vec2>& in_uvs,
+	std::vector<glm::vec3>& in_normals,
+	std::vector<glm::vec3>& in_tangents,
+	std::vector<glm::vec3>& in_bitangents,
+
 	std::vector<unsigned short>& out_indices,
 	std::vector<glm::vec3>& out_vertices,
 	std::vector<glm::vec2>& out_uvs,
@@ -29,4 +89,31 @@ void indexVBO_TBN(
 	std::vector<glm::vec3>& out_bitangents
 );
 
+
+// Reorders the output of indexVBO for the GPU vertex cache, overdraw and fetch locality.
+// Returns ACMR / ATVR before and after, see meshOptimizer.h
+MeshOptimizationReport optimizeIndexedVBO(
+	std::vector<unsigned int>& indices,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs,
+	std::vector<glm::vec3>& normals
+);
+
+MeshOptimizationReport optimizeIndexedVBO(
+	std::vector<unsigned short>& indices,
+	std::vector<glm::vec3>& vertices,
+	std::vector<glm::vec2>& uvs,
+	std::vector<glm::vec3>& normals
+);
+
+
+// Prints the time of indexVBO_map and of the hash welder (1 thread and every hardware thread) on the given
+// triangle corners, and whether they produced the same mesh
+void benchmarkIndexVBO(
+	std::vector<glm::vec3>& in_vertices,
+	std::vector<glm::vec2>& in_uvs,
+	std::vector<glm::vec3>& in_normals,
+	int numRuns = 5
+);
+
 #endif
\ No newline at end of file
@@ -1,69 +1,132 @@
 #include <iostream>
+#include <cstring>
+#include <utility>
 
 #include "common/vertextBufferObject.h"
+#include "glState.h"
+
+VertexBufferObject::VertexBufferObject(StagingArena& stagingArena)
+	: _stagingArena(&stagingArena) {}
+
+VertexBufferObject::~VertexBufferObject()
+{
+	deleteVBO();
+}
+
+VertexBufferObject::VertexBufferObject(VertexBufferObject&& other) noexcept
+	: _buffer(std::move(other._buffer))
+	, _bufferType(other._bufferType)
+	, _stagingArena(other._stagingArena)
+	, _staging(other._staging)
+	, _bytesAdded(other._bytesAdded)
+	, _uploadedDataSize(other._uploadedDataSize)
+	, _isDataUploaded(other._isDataUploaded)
+{
+	other._staging = StagingArena::Allocation();
+	other._bytesAdded = 0;
+	other._isDataUploaded = false;
+}
+
+VertexBufferObject& VertexBufferObject::operator=(VertexBufferObject&& other) noexcept
+{
+	if (this != &other)
+	{
+		deleteVBO();
+		_buffer = std::move(other._buffer);
+		_bufferType = other._bufferType;
+		_stagingArena = other._stagingArena;
+		_staging = other._staging;
+		_bytesAdded = other._bytesAdded;
+		_uploadedDataSize = other._uploadedDataSize;
+		_isDataUploaded = other._isDataUploaded;
+
+		other._staging = StagingArena::Allocation();
+		other._bytesAdded = 0;
+		other._isDataUploaded = false;
+	}
+
+	return *this;
+}
 
 void VertexBufferObject::createVBO(uint32_t reserveSizeBytes)
 {
-	if (_isBufferCreated)
+	if (_buffer)
 	{
 		std::cout << "This buffer is already created! You need to delete it before re-creating it!" << std::endl;
 		return;
 	}
 
-	glGenBuffers(1, &_bufferID);
-	_rawData.reserve(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
-
-	_isBufferCreated = true;
+	_buffer = GLBuffer::create();
+	_staging = _stagingArena->allocate(reserveSizeBytes);
+	_bytesAdded = 0;
 }
 
 void VertexBufferObject::bindVBO(GLenum bufferType)
 {
-	if (!_isBufferCreated)
+	if (!_buffer)
 	{
 		std::cout << "This buffer is not created yet! You cannot bind it before you create it!" << std::endl;
 		return;
 	}
 
 	_bufferType = bufferType;
-	glBindBuffer(_bufferType, _bufferID);
+	GLState::bindBuffer(_bufferType, _buffer.get());
 }
 
 void VertexBufferObject::addRawData(const void* ptrData, uint32_t dataSize, int repeat)
 {
-	const auto bytesToAdd = dataSize * repeat;
-	if (_bytesAdded + bytesToAdd > _rawData.capacity())
+	const auto destination = appendRawData(dataSize * repeat);
+	if (destination == nullptr) {
+		return;
+	}
+
+	for (int i = 0; i < repeat; i++) {
+		memcpy(destination + dataSize * i, ptrData, dataSize);
+	}
+}
+
+unsigned char* VertexBufferObject::appendRawData(uint32_t dataSizeBytes)
+{
+	if (_bytesAdded > 0 && !_stagingArena->isValid(_staging))
 	{
-		const auto newCapacity = _rawData.capacity() * 2;
-		std::vector<unsigned char> newRawData;
-		newRawData.reserve(newCapacity);
-		memcpy(newRawData.data(), _rawData.data(), _bytesAdded);
-		_rawData = std::move(newRawData);
+		std::cout << "Staging arena has been reset while this buffer was gathering data! Added data are lost!" << std::endl;
+		_staging = StagingArena::Allocation();
+		_bytesAdded = 0;
+		return nullptr;
 	}
 
-	for (int i = 0; i < repeat; i++)
+	const auto requiredSize = _bytesAdded + dataSizeBytes;
+	if (requiredSize > _staging.capacity || !_stagingArena->isValid(_staging))
 	{
-		memcpy(_rawData.data() + _bytesAdded, ptrData, dataSize);
-		_bytesAdded += dataSize;
+		// Grow at least twice, so that many small appends stay cheap
+		const auto doubledSize = _staging.capacity * 2;
+		_stagingArena->grow(_staging, _bytesAdded, requiredSize > doubledSize ? requiredSize : doubledSize);
 	}
+
+	const auto result = _staging.data + _bytesAdded;
+	_bytesAdded = requiredSize;
+	return result;
 }
 
 void* VertexBufferObject::getRawDataPointer()
 {
-	return _rawData.data();
+	return _staging.data;
 }
 
 void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
 {
-	if (!_isBufferCreated)
+	if (!_buffer)
 	{
 		std::cout << "This buffer is not created yet! Call createVBO before uploading data to GPU!" << std::endl;
 		return;
 	}
 
-	glBufferData(_bufferType, _bytesAdded, _rawData.data(), usageHint);
+	// One copy straight from the staging arena, then give the staging space back
+	glBufferData(_bufferType, _bytesAdded, _bytesAdded > 0 ? _staging.data : nullptr, usageHint);
 	_isDataUploaded = true;
-	_uploadedDataSize = _bytesAdded;
+	_uploadedDataSize = static_cast<uint32_t>(_bytesAdded);
 	_bytesAdded = 0;
+	_stagingArena->release(_staging);
 }
 
 void* VertexBufferObject::mapBufferToMemory(GLenum usageHint)
@@ -93,7 +156,7 @@ void VertexBufferObject::unmapBuffer()
 
 GLuint VertexBufferObject::getBufferID()
 {
-	return _bufferID;
+	return _buffer.get();
 }
 
 uint32_t VertexBufferObject::getBufferSize()
@@ -103,10 +166,11 @@ uint32_t VertexBufferObject::getBufferSize()
 
 void VertexBufferObject::deleteVBO()
 {
-	if (_isBufferCreated)
+	if (_buffer)
 	{
-		glDeleteBuffers(1, &_bufferID);
+		_buffer.reset();
+		_stagingArena->release(_staging);
+		_bytesAdded = 0;
 		_isDataUploaded = false;
-		_isBufferCreated = false;
 	}
 }
\ No newline at end of file
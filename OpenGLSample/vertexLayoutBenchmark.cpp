@@ -0,0 +1,126 @@
+// STL
+#include <iostream>
+#include <iomanip>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "vertexLayoutBenchmark.h"
+#include "cylinder.h"
+#include "glState.h"
+
+namespace static_meshes_3D {
+
+	namespace {
+
+		// Vertex shaders touch every attribute they declare, so that the driver cannot skip fetching them
+		const char* FULL_VERTEX_SHADER =
+			"#version 330 core\n"
+			"layout (location = 0) in vec3 aPos;\n"
+			"layout (location = 1) in vec2 aTexCoords;\n"
+			"layout (location = 2) in vec3 aNormal;\n"
+			"out vec3 vColor;\n"
+			"void main()\n"
+			"{\n"
+			"    vColor = aNormal + vec3(aTexCoords, 0.0);\n"
+			"    gl_Position = vec4(aPos, 1.0);\n"
+			"}\n";
+
+		const char* POSITION_VERTEX_SHADER =
+			"#version 330 core\n"
+			"layout (location = 0) in vec3 aPos;\n"
+			"void main()\n"
+			"{\n"
+			"    gl_Position = vec4(aPos, 1.0);\n"
+			"}\n";
+
+		GLuint compileProgram(const char* vertexShaderSource)
+		{
+			const GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+			glShaderSource(shader, 1, &vertexShaderSource, nullptr);
+			glCompileShader(shader);
+
+			const GLuint program = glCreateProgram();
+			glAttachShader(program, shader);
+			glLinkProgram(program);
+			glDeleteShader(shader);
+
+			GLint success = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				char infoLog[1024];
+				glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+				std::cout << "ERROR::VERTEX_LAYOUT_BENCHMARK::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+				glDeleteProgram(program);
+				return 0;
+			}
+
+			return program;
+		}
+
+		// Returns millions of vertices per second of given draw, timed on the GPU
+		template<typename DrawFunction>
+		double measure(GLuint query, int numDraws, double verticesPerDraw, DrawFunction draw)
+		{
+			// Warm up, so that first-use costs (residency, shader patching) are not timed
+			draw();
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			for (int i = 0; i < numDraws; i++) {
+				draw();
+			}
+			glEndQuery(GL_TIME_ELAPSED);
+
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			return nanoseconds > 0 ? verticesPerDraw * numDraws * 1000.0 / double(nanoseconds) : 0.0;
+		}
+
+	} // namespace
+
+	void benchmarkVertexLayouts(int numSegments, int numDraws)
+	{
+		const GLuint fullProgram = compileProgram(FULL_VERTEX_SHADER);
+		const GLuint positionProgram = compileProgram(POSITION_VERTEX_SHADER);
+		if (fullProgram == 0 || positionProgram == 0)
+		{
+			GLState::deleteProgram(fullProgram);
+			GLState::deleteProgram(positionProgram);
+			return;
+		}
+
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		GLState::setEnabled(GL_RASTERIZER_DISCARD, true);
+
+		const char* layoutNames[] = { "planar", "interleaved", "position split" };
+		const VertexLayout layouts[] = { VertexLayout::Planar, VertexLayout::Interleaved, VertexLayout::PositionSplit };
+
+		std::cout << "Vertex layout benchmark, Mvertices/s (" << numDraws << " draws)" << std::endl;
+		std::cout << std::setw(16) << "layout" << std::setw(12) << "points" << std::setw(12) << "triangles" << std::setw(16) << "position only" << std::endl;
+		for (int i = 0; i < 3; i++)
+		{
+			Torus torus(1.0f, 0.25f, numSegments, numSegments, true, true, true, layouts[i]);
+			const double numVertices = torus.getNumVertices();
+			const double numIndices = torus.getNumIndices();
+
+			GLState::useProgram(fullProgram);
+			const auto points = measure(query, numDraws, numVertices, [&torus]() { torus.renderPoints(); });
+			const auto triangles = measure(query, numDraws, numIndices, [&torus]() { torus.render(); });
+			GLState::useProgram(positionProgram);
+			const auto positionOnly = measure(query, numDraws, numIndices, [&torus]() { torus.render(); });
+
+			std::cout << std::fixed << std::setprecision(1)
+				<< std::setw(16) << layoutNames[i] << std::setw(12) << points << std::setw(12) << triangles << std::setw(16) << positionOnly << std::endl;
+		}
+
+		GLState::setEnabled(GL_RASTERIZER_DISCARD, false);
+		glDeleteQueries(1, &query);
+		GLState::useProgram(0);
+		GLState::deleteProgram(fullProgram);
+		GLState::deleteProgram(positionProgram);
+	}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace static_meshes_3D {
+
+	/**
+	 * Measures vertex fetch throughput of every VertexLayout. The same torus is built in each layout and drawn
+	 * with rasterization disabled, so the time is spent in vertex fetch and the vertex shader only. Prints
+	 * millions of vertices per second for:
+	 *  - points: every vertex fetched once, in order (raw fetch bandwidth)
+	 *  - triangles: indexed draw counted per index, shared vertices hit the post-transform cache
+	 *  - position only: indexed draw reading positions only (depth / shadow passes)
+	 *
+	 * Needs a current OpenGL 3.3+ context. Everything the benchmark creates is deleted before it returns.
+	 *
+	 * @param numSegments  Segments around the torus and around its tube (vertex count is about numSegments^2)
+	 * @param numDraws     Number of timed draws per layout and pass
+	 */
+	void benchmarkVertexLayouts(int numSegments = 512, int numDraws = 100);
+
+} // namespace static_meshes_3D